@@ -0,0 +1,396 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_AUDIOBUSES_HPP
+#define SCC_AUDIOBUSES_HPP
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include "null.hpp"
+#include "audiochunk.hpp"
+#include "audioeffects.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use AudioBuses class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Submixes: channels are assigned to buses (eg music, effects, UI, voice),
+// each with its own gain and effects, which are mixed into their output bus,
+// and so on up to the master bus. An effect on a bus runs once for all of
+// its channels, instead of once per channel.
+//
+// Notes:
+// - a channel's sound is routed by an effect on that channel, which moves
+//   it into its bus (leaving silence for SDL_mixer to mix). SDL_mixer
+//   removes a channel's effects when it stops, so sounds must be played
+//   with play() (or attach()ed to right after playing), every time.
+//   Otherwise, they go straight to the master bus, like unassigned
+//   channels do.
+// - the route must be the channel's last effect: any registered on the
+//   channel after it (eg by AudioChannels::setPanning(), or AudioEffects)
+//   only get its silence. Call attach() again after adding them, which
+//   moves the route after them.
+// - the master bus's effects and gain apply to everything, including
+//   music, which can't be routed to other buses (SDL_mixer mixes it before
+//   any effect is called)
+// - the buses are summed by a post-mix effect, which should be registered
+//   before any other (ie the buses should be made first), so that those
+//   see the whole mix
+// - the channels' and chunks' volumes are applied when routing, as they
+//   would be by SDL_mixer
+// - the mixer's format must be AUDIO_S16SYS or AUDIO_F32SYS (as for
+//   AudioEffects), and at most maxFrames frames are routed per callback
+//   (the rest play as if unassigned)
+// - only one AudioBuses should exist at a time, and it must be used from
+//   one thread. Bus effects are called on the audio thread, with the same
+//   signature as in AudioEffects.
+class AudioBuses {
+public:
+	static const int MASTER = 0;
+	static const int NO_BUS = -1;
+	static const int DEFAULT_MAX_FRAMES = 8192;
+
+	// Throws std::runtime_error if audio isn't open, or if its format isn't
+	// supported.
+	explicit AudioBuses(int maxFrames = DEFAULT_MAX_FRAMES);
+	~AudioBuses();
+
+	// returns the new bus, which is mixed into output
+	int create(int output = MASTER);
+	int getBusCount() const { return buses_.size(); }
+
+	float getGain(int bus) const { return buses_[bus]->gain.getGain(); }
+	// ramped over a callback, so it doesn't click
+	void setGain(int bus, float gain) { buses_[bus]->gain.setGain(gain); }
+
+	// run in the order they were added, before the gain
+	template<typename F> void addEffect(int bus, F f);
+	void clearEffects(int bus);
+
+	// bus may be NO_BUS (the same as MASTER). These return false on error
+	// (see SDL_GetError()).
+	bool assign(int channel, int bus);
+	bool assign(int from, int to, int bus);
+	int getBus(int channel) const;
+
+	// same as chunk.play() (returns the channel, or -1 on error), with the
+	// sound routed to its channel's bus
+	int play(AudioChunk &chunk, int channel = -1, int loops = 0,
+		int ticks = -1);
+	// routes the sound playing on channel. If it already is, the route is
+	// moved after the channel's other effects.
+	bool attach(int channel);
+
+	AudioBuses(const AudioBuses &that) = delete;
+	AudioBuses & operator=(const AudioBuses &that) = delete;
+private:
+	struct Bus {
+		Bus(int output, size_t samples, int channels)
+			: output{output}, gain(1.0f, channels), buffer(samples),
+			active{false}
+		{}
+
+		int output;
+		AudioEffects::Gain gain;
+		std::vector<std::function<void(float*, int)>> effects;
+		std::vector<float> buffer;
+		bool active; // whether anything was routed to it, this time
+	};
+	struct Route {
+		AudioBuses *owner;
+		int channel;
+		int bus;
+		int cursor; // in frames. A channel may be called more than once.
+		bool attached;
+	};
+
+	static void route(int channel, void *stream, int len, void *udata);
+	static void routeDone(int channel, void *udata)
+	{
+		static_cast<Route*>(udata)->attached = false;
+	}
+	static void mix(int channel, void *stream, int len, void *udata);
+	static void mixDone(int channel, void *udata)
+	{
+		static_cast<AudioBuses*>(udata)->registered_ = false;
+	}
+
+	int frameSize() const
+	{
+		return channels_ * (format_ == AUDIO_F32SYS ? 4 : 2);
+	}
+	// must be called with the audio locked
+	Route &routeOf(int channel);
+	void process(Bus &bus, int frames);
+
+	Uint16 format_;
+	int channels_;
+	int maxFrames_;
+	bool registered_;
+	// the audio thread uses these, so they're only changed with the audio
+	// locked. Pointers, so they don't move.
+	std::vector<std::unique_ptr<Bus>> buses_;
+	std::vector<std::unique_ptr<Route>> routes_;
+};
+
+AudioBuses::AudioBuses(int maxFrames)
+	: maxFrames_{maxFrames}, registered_{false}
+{
+	int frequency;
+	if(Mix_QuerySpec(&frequency, &format_, &channels_) == 0) {
+		throw std::runtime_error("Making audio buses failed: audio "
+			"isn't open");
+	}
+	if(format_ != AUDIO_S16SYS && format_ != AUDIO_F32SYS) {
+		throw std::runtime_error("Making audio buses failed: the "
+			"mixer's format must be AUDIO_S16SYS or AUDIO_F32SYS");
+	}
+	buses_.emplace_back(new Bus(NO_BUS, maxFrames_ * channels_, channels_));
+	if(!Mix_RegisterEffect(MIX_CHANNEL_POST, mix, mixDone, this)) {
+		throw std::runtime_error(std::string("Making audio buses "
+			"failed: ") + SDL_GetError());
+	}
+	registered_ = true;
+}
+
+AudioBuses::~AudioBuses()
+{
+	SDL_LockAudio();
+	for(std::unique_ptr<Route> &route : routes_) {
+		if(route->attached) {
+			Mix_UnregisterEffect(route->channel, AudioBuses::route);
+		}
+	}
+	if(registered_) {
+		Mix_UnregisterEffect(MIX_CHANNEL_POST, mix);
+	}
+	SDL_UnlockAudio();
+}
+
+int AudioBuses::create(int output)
+{
+	if(output < 0 || output >= getBusCount()) {
+		output = MASTER;
+	}
+	Bus *bus = new Bus(output, maxFrames_ * channels_, channels_);
+	SDL_LockAudio();
+	// outputs always come before, so mix() can go backwards
+	buses_.emplace_back(bus);
+	SDL_UnlockAudio();
+	return getBusCount() - 1;
+}
+
+template<typename F>
+void AudioBuses::addEffect(int bus, F f)
+{
+	std::function<void(float*, int)> effect(std::move(f));
+	SDL_LockAudio();
+	buses_[bus]->effects.push_back(std::move(effect));
+	SDL_UnlockAudio();
+}
+
+void AudioBuses::clearEffects(int bus)
+{
+	std::vector<std::function<void(float*, int)>> effects;
+	SDL_LockAudio();
+	buses_[bus]->effects.swap(effects);
+	SDL_UnlockAudio();
+	// destroyed here, outside of the lock
+}
+
+bool AudioBuses::assign(int channel, int bus)
+{
+	return assign(channel, channel, bus);
+}
+
+bool AudioBuses::assign(int from, int to, int bus)
+{
+	if(bus >= getBusCount()) {
+		SDL_SetError("AudioBuses: no such bus: %d", bus);
+		return false;
+	}
+	if(from < 0 || to < from) {
+		SDL_SetError("AudioBuses: invalid channels: %d to %d", from, to);
+		return false;
+	}
+	SDL_LockAudio();
+	for(int channel = from; channel <= to; ++channel) {
+		routeOf(channel).bus = bus;
+	}
+	SDL_UnlockAudio();
+	return true;
+}
+
+int AudioBuses::getBus(int channel) const
+{
+	if(channel < 0 || channel >= static_cast<int>(routes_.size())) {
+		return NO_BUS;
+	}
+	return routes_[channel]->bus;
+}
+
+int AudioBuses::play(AudioChunk &chunk, int channel, int loops, int ticks)
+{
+	// locked, so none of it is mixed before it's routed
+	SDL_LockAudio();
+	channel = chunk.play(channel, loops, ticks);
+	if(channel >= 0) {
+		attach(channel);
+	}
+	SDL_UnlockAudio();
+	return channel;
+}
+
+bool AudioBuses::attach(int channel)
+{
+	if(channel < 0) {
+		SDL_SetError("AudioBuses: invalid channel: %d", channel);
+		return false;
+	}
+	SDL_LockAudio();
+	Route &r = routeOf(channel);
+	if(r.attached) {
+		// registered again, to be last (routeDone() clears attached)
+		Mix_UnregisterEffect(channel, route);
+	}
+	bool ok = Mix_RegisterEffect(channel, route, routeDone, &r) != 0;
+	r.attached = ok;
+	SDL_UnlockAudio();
+	return ok;
+}
+
+AudioBuses::Route &AudioBuses::routeOf(int channel)
+{
+	while(static_cast<int>(routes_.size()) <= channel) {
+		Route route = { this, static_cast<int>(routes_.size()), NO_BUS,
+			0, false };
+		routes_.emplace_back(new Route(route));
+	}
+	return *routes_[channel];
+}
+
+void AudioBuses::route(int channel, void *stream, int len, void *udata)
+{
+	Route &r = *static_cast<Route*>(udata);
+	AudioBuses &self = *r.owner;
+	if(r.bus == NO_BUS || r.bus == MASTER) {
+		// left for SDL_mixer to mix, which is the same
+		return;
+	}
+	Bus &bus = *self.buses_[r.bus];
+	int frames = std::min(len / self.frameSize(), self.maxFrames_ - r.cursor);
+	if(frames <= 0) {
+		return;
+	}
+	// SDL_mixer applies these after the effects
+	Mix_Chunk *chunk = Mix_GetChunk(channel);
+	int chunkVolume = chunk != NULL ? Mix_VolumeChunk(chunk, -1)
+		: MIX_MAX_VOLUME;
+	float volume = static_cast<float>(Mix_Volume(channel, -1))
+		* chunkVolume / (MIX_MAX_VOLUME * MIX_MAX_VOLUME);
+
+	float *out = &bus.buffer[r.cursor * self.channels_];
+	int count = frames * self.channels_;
+	if(self.format_ == AUDIO_F32SYS) {
+		float *samples = static_cast<float*>(stream);
+		for(int i = 0; i < count; ++i) {
+			out[i] += samples[i] * volume;
+		}
+		std::memset(samples, 0, count * sizeof(float));
+	} else {
+		Sint16 *samples = static_cast<Sint16*>(stream);
+		volume /= 32768.0f;
+		for(int i = 0; i < count; ++i) {
+			out[i] += samples[i] * volume;
+		}
+		std::memset(samples, 0, count * sizeof(Sint16));
+	}
+	r.cursor += frames;
+	bus.active = true;
+}
+
+void AudioBuses::process(Bus &bus, int frames)
+{
+	for(std::function<void(float*, int)> &effect : bus.effects) {
+		effect(bus.buffer.data(), frames);
+	}
+	bus.gain.process(bus.buffer.data(), frames);
+}
+
+void AudioBuses::mix(int, void *stream, int len, void *udata)
+{
+	AudioBuses &self = *static_cast<AudioBuses*>(udata);
+	int frames = std::min(len / self.frameSize(), self.maxFrames_);
+	int count = frames * self.channels_;
+	for(std::unique_ptr<Route> &route : self.routes_) {
+		route->cursor = 0;
+	}
+	// children first; they always come after their outputs
+	for(size_t i = self.buses_.size() - 1; i > MASTER; --i) {
+		Bus &bus = *self.buses_[i];
+		// effects run anyway, for their tails (eg reverb)
+		if(!bus.active && bus.effects.empty()) {
+			continue;
+		}
+		self.process(bus, frames);
+		Bus &output = *self.buses_[bus.output];
+		for(int k = 0; k < count; ++k) {
+			output.buffer[k] += bus.buffer[k];
+		}
+		std::fill(bus.buffer.begin(), bus.buffer.begin() + count, 0.0f);
+		output.active = true;
+		bus.active = false;
+	}
+
+	Bus &master = *self.buses_[MASTER];
+	float *mixed = master.buffer.data();
+	if(self.format_ == AUDIO_F32SYS) {
+		float *samples = static_cast<float*>(stream);
+		for(int k = 0; k < count; ++k) {
+			mixed[k] += samples[k];
+		}
+		self.process(master, frames);
+		std::copy(mixed, mixed + count, samples);
+	} else {
+		Sint16 *samples = static_cast<Sint16*>(stream);
+		for(int k = 0; k < count; ++k) {
+			mixed[k] += samples[k] * (1.0f / 32768.0f);
+		}
+		self.process(master, frames);
+		for(int k = 0; k < count; ++k) {
+			float s = mixed[k] * 32768.0f;
+			s = std::max(-32768.0f, std::min(s, 32767.0f));
+			samples[k] = static_cast<Sint16>(s);
+		}
+	}
+	std::fill(mixed, mixed + count, 0.0f);
+	master.active = false;
+}
+
+} // namespace SDL
+
+#endif // SCC_AUDIOBUSES_HPP
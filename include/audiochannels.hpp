@@ -30,9 +30,8 @@
 
 namespace SDL {
 
-// TODO sound effects
-//
 // convenience wrapper around channel-related functions.
+// (for effects, see AudioEffects)
 struct AudioChannels {
 	static int allocate(int num) { return Mix_AllocateChannels(num); }
 	static int reserve(int num) { return Mix_ReserveChannels(num); }
@@ -74,8 +73,34 @@ struct AudioChannels {
 	static void pause(int which) { Mix_Pause(which); }
 	static void resume(int which) { Mix_Resume(which); }
 
+	// volume goes from 0 to MIX_MAX_VOLUME. which may be -1, for all of
+	// them. setVolume() returns the old volume (the average, for all).
+	static int setVolume(int which, int volume)
+	{
+		return Mix_Volume(which, volume);
+	}
+	static int getVolume(int which) { return Mix_Volume(which, -1); }
+
 	static bool isPaused(int which) { return Mix_Paused(which); }
 	static bool isPlaying(int which) { return Mix_Playing(which); }
+
+	// These register SDL_mixer's positional effect, which goes away when
+	// the channel stops, so call them after playing. left, right and
+	// distance go from 0 to 255 (255 is full volume, but farthest);
+	// angle is in degrees, 0 being ahead and 90, to the right.
+	// (to position many channels every frame, see SpatialAudio)
+	static bool setPanning(int which, Uint8 left, Uint8 right)
+	{
+		return Mix_SetPanning(which, left, right);
+	}
+	static bool setDistance(int which, Uint8 distance)
+	{
+		return Mix_SetDistance(which, distance);
+	}
+	static bool setPosition(int which, Sint16 angle, Uint8 distance)
+	{
+		return Mix_SetPosition(which, angle, distance);
+	}
 };
 
 } // namespace SDL
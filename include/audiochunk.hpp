@@ -37,6 +37,11 @@ namespace SDL {
 class RWops;
 
 class AudioChunk {
+	// for making them from the chunks it converts
+	friend class AudioLoader;
+	friend class CompressedChunk;
+	friend class VoiceMixer;
+	friend class Playlist;
 	// notes:
 	// - To stop playing, call AudioChannels::halt() or
 	//   AudioChannels::fadeOut()
@@ -65,6 +70,15 @@ public:
 	}
 	int getVolume() { return setVolume(-1); }
 
+	// the size of the decoded samples, in bytes
+	Uint32 getByteLength() const { return chunk_->alen; }
+	// whether any channel is playing this
+	bool isPlaying() const;
+	bool isPlaying(int channel) const
+	{
+		return Mix_Playing(channel) && Mix_GetChunk(channel) == chunk_.get();
+	}
+
 	AudioChunk(const AudioChunk &that) = delete;
 	AudioChunk(AudioChunk &&that) = default;
 	~AudioChunk() = default;
@@ -83,6 +97,8 @@ public:
 		void operator()(Mix_Chunk *chunk) { Mix_FreeChunk(chunk); }
 	};
 private:
+	explicit AudioChunk(Mix_Chunk *chunk) : chunk_{chunk} {}
+
 	std::unique_ptr<Mix_Chunk, Deleter> chunk_;
 };
 
@@ -101,6 +117,17 @@ AudioChunk::AudioChunk(Uint8 *mem, Uint32 len)
 		"Quickloading raw audio chunk from memory failed", mem, len)}
 {}
 
+bool AudioChunk::isPlaying() const
+{
+	int channels = Mix_AllocateChannels(-1); // -1 only queries
+	for(int i = 0; i < channels; ++i) {
+		if(isPlaying(i)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 } // namespace SDL
 
 #endif
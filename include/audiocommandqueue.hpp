@@ -0,0 +1,377 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_AUDIOCOMMANDQUEUE_HPP
+#define SCC_AUDIOCOMMANDQUEUE_HPP
+
+#include <vector>
+#include <atomic>
+#include <stdexcept>
+#include <cmath>
+#include <algorithm>
+#include "null.hpp"
+#include "audiochunk.hpp"
+#include "lockfreequeue.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use AudioCommandQueue class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Plays, stops and changes the volume of channels from any thread, without
+// locking the audio. Calls only put a command in a lock-free queue; the
+// commands are carried out on the audio thread, by a post-mix effect, so
+// they take effect from the next callback on. What happens to them (and
+// which channels finish) comes back through another queue, read by poll().
+//
+// Notes:
+// - the calls never wait. They return false if the queue is full, and the
+//   command is lost.
+// - volumes are ramped to, a step per callback (SDL_mixer applies a
+//   channel's volume once per callback), so changes don't click
+// - each play has an id of your choosing, which comes back with the
+//   events about it
+// - events are dropped (and counted) when nobody polls them
+// - this sets Mix_ChannelFinished(), so only one may exist at a time, and
+//   nothing else may set it meanwhile
+// - there's no command to play music: Mix_PlayMusic() waits for the music
+//   that's fading out, which would never happen on the audio thread
+// - the chunks must outlive their commands, as with chunk.play()
+class AudioCommandQueue {
+public:
+	static const size_t DEFAULT_CAPACITY = 1024;
+	static const Uint32 DEFAULT_RAMP = 20; // ms
+
+	struct Event {
+		enum Type {
+			STARTED, // play() did, on channel
+			FAILED, // play() didn't (eg no free channel)
+			FINISHED // channel stopped, however it did
+		};
+		Type type;
+		int channel;
+		Uint32 id; // the play's, or 0 if it wasn't one of ours
+	};
+
+	// Throws std::runtime_error if audio isn't open, or if there's another
+	// AudioCommandQueue.
+	explicit AudioCommandQueue(size_t capacity = DEFAULT_CAPACITY);
+	~AudioCommandQueue();
+
+	// These are like the AudioChunk and AudioChannels functions of the same
+	// names. channel may be -1 (any free channel for play(), all of them
+	// otherwise).
+	bool play(AudioChunk &chunk, int channel = -1, int loops = 0,
+		int ticks = -1, Uint32 id = 0);
+	bool fadeIn(AudioChunk &chunk, int channel, int loops, int ms,
+		int ticks = -1, Uint32 id = 0);
+	bool halt(int channel) { return push(Command(HALT, channel)); }
+	bool fadeOut(int channel, int ms);
+	bool pause(int channel) { return push(Command(PAUSE, channel)); }
+	bool resume(int channel) { return push(Command(RESUME, channel)); }
+	// volume goes from 0 to MIX_MAX_VOLUME, reached after ms
+	bool setVolume(int channel, int volume, Uint32 ms = DEFAULT_RAMP);
+
+	bool setMusicVolume(int volume, Uint32 ms = DEFAULT_RAMP);
+	bool pauseMusic() { return push(Command(PAUSE_MUSIC)); }
+	bool resumeMusic() { return push(Command(RESUME_MUSIC)); }
+	bool haltMusic() { return push(Command(HALT_MUSIC)); }
+
+	// returns false if there's none
+	bool poll(Event &event) { return events_.pop(event); }
+
+	Uint64 getDroppedEvents() const { return droppedEvents_.load(); }
+
+	AudioCommandQueue(const AudioCommandQueue &that) = delete;
+	AudioCommandQueue & operator=(const AudioCommandQueue &that) = delete;
+private:
+	enum Type {
+		PLAY, HALT, FADE_OUT, PAUSE, RESUME, VOLUME,
+		MUSIC_VOLUME, PAUSE_MUSIC, RESUME_MUSIC, HALT_MUSIC
+	};
+
+	struct Command {
+		Command() = default;
+		explicit Command(Type type, int channel = -1)
+			: type{type}, chunk{NULL}, channel{channel}, loops{0},
+			ticks{-1}, value{0}, ms{0}, id{0}
+		{}
+
+		Type type;
+		AudioChunk *chunk;
+		int channel;
+		int loops;
+		int ticks;
+		int value; // the volume, or the fade's length
+		Uint32 ms; // the ramp's length
+		Uint32 id;
+	};
+
+	// a volume on its way somewhere; audio thread only
+	struct Ramp {
+		float current;
+		int target;
+		float step;
+		bool active;
+	};
+
+	static AudioCommandQueue *&instance()
+	{
+		static AudioCommandQueue *queue = NULL;
+		return queue;
+	}
+	static void finished(int channel);
+	static void run(int channel, void *stream, int len, void *udata);
+	static void runDone(int channel, void *udata)
+	{
+		static_cast<AudioCommandQueue*>(udata)->registered_ = false;
+	}
+
+	bool push(const Command &command) { return commands_.push(command); }
+	void notify(Event::Type type, int channel, Uint32 id);
+	void apply(const Command &command, float period);
+	// channel may be -1, for the music
+	void startRamp(int channel, int volume, Uint32 ms, float period);
+	void advance(Ramp &ramp, int channel);
+
+	int frequency_;
+	int frameSize_;
+	bool registered_;
+	LockFreeQueue<Command> commands_;
+	LockFreeQueue<Event> events_;
+	std::atomic<Uint64> droppedEvents_;
+	// audio thread only (Mix_ChannelFinished() is called with the audio
+	// locked, too), for the channels there were when this was made
+	std::vector<Ramp> ramps_;
+	std::vector<Uint32> ids_; // of what's playing on each channel
+	Ramp musicRamp_;
+};
+
+AudioCommandQueue::AudioCommandQueue(size_t capacity)
+	: registered_{false}, commands_(capacity), events_(capacity),
+	droppedEvents_{0}, musicRamp_()
+{
+	Uint16 format;
+	int channels;
+	if(Mix_QuerySpec(&frequency_, &format, &channels) == 0) {
+		throw std::runtime_error("Making audio command queue failed: "
+			"audio isn't open");
+	}
+	if(instance() != NULL) {
+		throw std::runtime_error("Making audio command queue failed: "
+			"there's one already");
+	}
+	frameSize_ = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+	int channelCount = Mix_AllocateChannels(-1);
+	ramps_.assign(channelCount, Ramp());
+	ids_.assign(channelCount, 0);
+
+	SDL_LockAudio();
+	instance() = this;
+	Mix_ChannelFinished(finished);
+	registered_ = Mix_RegisterEffect(MIX_CHANNEL_POST, run, runDone, this)
+		!= 0;
+	if(!registered_) {
+		Mix_ChannelFinished(NULL);
+		instance() = NULL;
+	}
+	SDL_UnlockAudio();
+	if(!registered_) {
+		throw std::runtime_error(std::string("Making audio command "
+			"queue failed: ") + SDL_GetError());
+	}
+}
+
+AudioCommandQueue::~AudioCommandQueue()
+{
+	SDL_LockAudio();
+	if(registered_) {
+		Mix_UnregisterEffect(MIX_CHANNEL_POST, run);
+	}
+	Mix_ChannelFinished(NULL);
+	instance() = NULL;
+	SDL_UnlockAudio();
+}
+
+bool AudioCommandQueue::play(AudioChunk &chunk, int channel, int loops,
+	int ticks, Uint32 id)
+{
+	return fadeIn(chunk, channel, loops, 0, ticks, id);
+}
+
+bool AudioCommandQueue::fadeIn(AudioChunk &chunk, int channel, int loops,
+	int ms, int ticks, Uint32 id)
+{
+	Command command(PLAY, channel);
+	command.chunk = &chunk;
+	command.loops = loops;
+	command.ticks = ticks;
+	command.value = ms;
+	command.id = id;
+	return push(command);
+}
+
+bool AudioCommandQueue::fadeOut(int channel, int ms)
+{
+	Command command(FADE_OUT, channel);
+	command.value = ms;
+	return push(command);
+}
+
+bool AudioCommandQueue::setVolume(int channel, int volume, Uint32 ms)
+{
+	Command command(VOLUME, channel);
+	command.value = volume;
+	command.ms = ms;
+	return push(command);
+}
+
+bool AudioCommandQueue::setMusicVolume(int volume, Uint32 ms)
+{
+	Command command(MUSIC_VOLUME);
+	command.value = volume;
+	command.ms = ms;
+	return push(command);
+}
+
+void AudioCommandQueue::notify(Event::Type type, int channel, Uint32 id)
+{
+	Event event = { type, channel, id };
+	if(!events_.push(event)) {
+		++droppedEvents_;
+	}
+}
+
+void AudioCommandQueue::finished(int channel)
+{
+	AudioCommandQueue *self = instance();
+	if(self == NULL) {
+		return;
+	}
+	Uint32 id = 0;
+	if(channel < static_cast<int>(self->ids_.size())) {
+		id = self->ids_[channel];
+		self->ids_[channel] = 0;
+	}
+	self->notify(Event::FINISHED, channel, id);
+}
+
+void AudioCommandQueue::run(int, void *, int len, void *udata)
+{
+	AudioCommandQueue &self = *static_cast<AudioCommandQueue*>(udata);
+	// how long a callback is, in ms
+	float period = 1000.0f * (len / self.frameSize_) / self.frequency_;
+	Command command;
+	while(self.commands_.pop(command)) {
+		self.apply(command, period);
+	}
+	for(size_t i = 0; i < self.ramps_.size(); ++i) {
+		self.advance(self.ramps_[i], i);
+	}
+	self.advance(self.musicRamp_, -1);
+}
+
+void AudioCommandQueue::apply(const Command &command, float period)
+{
+	int channel = command.channel;
+	switch(command.type) {
+	case PLAY: {
+		AudioChunk &chunk = *command.chunk;
+		channel = command.value > 0
+			? chunk.fadeIn(channel, command.loops, command.value,
+				command.ticks)
+			: chunk.play(channel, command.loops, command.ticks);
+		if(channel < 0) {
+			notify(Event::FAILED, command.channel, command.id);
+			break;
+		}
+		// after playing, which finishes what was there before
+		if(channel < static_cast<int>(ids_.size())) {
+			ids_[channel] = command.id;
+		}
+		notify(Event::STARTED, channel, command.id);
+		break;
+	}
+	case HALT: Mix_HaltChannel(channel); break;
+	case FADE_OUT: Mix_FadeOutChannel(channel, command.value); break;
+	case PAUSE: Mix_Pause(channel); break;
+	case RESUME: Mix_Resume(channel); break;
+	case VOLUME:
+		if(channel >= 0) {
+			startRamp(channel, command.value, command.ms, period);
+			break;
+		}
+		for(int i = 0; i < Mix_AllocateChannels(-1); ++i) {
+			startRamp(i, command.value, command.ms, period);
+		}
+		break;
+	case MUSIC_VOLUME:
+		startRamp(-1, command.value, command.ms, period);
+		break;
+	case PAUSE_MUSIC: Mix_PauseMusic(); break;
+	case RESUME_MUSIC: Mix_ResumeMusic(); break;
+	case HALT_MUSIC: Mix_HaltMusic(); break;
+	}
+}
+
+void AudioCommandQueue::startRamp(int channel, int volume, Uint32 ms,
+	float period)
+{
+	volume = std::max(0, std::min(volume, MIX_MAX_VOLUME));
+	if(channel >= static_cast<int>(ramps_.size())) {
+		// made after this was; no ramp
+		Mix_Volume(channel, volume);
+		return;
+	}
+	Ramp &ramp = channel < 0 ? musicRamp_ : ramps_[channel];
+	ramp.current = channel < 0 ? Mix_VolumeMusic(-1)
+		: Mix_Volume(channel, -1);
+	ramp.target = volume;
+	// the first step is taken right away
+	float steps = std::max(ms / period, 1.0f);
+	ramp.step = (volume - ramp.current) / steps;
+	ramp.active = true;
+}
+
+void AudioCommandQueue::advance(Ramp &ramp, int channel)
+{
+	if(!ramp.active) {
+		return;
+	}
+	ramp.current += ramp.step;
+	bool done = ramp.step >= 0 ? ramp.current >= ramp.target
+		: ramp.current <= ramp.target;
+	if(done) {
+		ramp.current = ramp.target;
+		ramp.active = false;
+	}
+	int volume = static_cast<int>(std::lround(ramp.current));
+	if(channel < 0) {
+		Mix_VolumeMusic(volume);
+	} else {
+		Mix_Volume(channel, volume);
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_AUDIOCOMMANDQUEUE_HPP
@@ -0,0 +1,292 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_AUDIODEVICE_HPP
+#define SCC_AUDIODEVICE_HPP
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include "null.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use AudioDevice class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Opens SDL_mixer's audio (Mix_OpenAudio()) for as long as it exists, and
+// measures its callbacks: how often they come, how late, and how long
+// they take. autoTune() picks the smallest buffer the machine keeps up
+// with, rather than guessing one.
+//
+// Notes:
+// - the times are taken at the end of each callback (with Mix_SetPostMix(),
+//   which it takes up), so they include every effect and hook
+// - an underrun is counted when a callback ends more than a buffer's
+//   worth later than the device's clock says it should have, which is
+//   when the device has run out of samples and played silence
+// - how long callbacks take is only measured while tuning, since that
+//   needs the music hook (see autoTune())
+// - only one may exist at a time, and it must be the only thing opening
+//   audio, since tuning reopens it
+class AudioDevice {
+public:
+	static const int DEFAULT_CHUNK_SIZE = 1024;
+
+	struct Stats {
+		Uint64 callbacks;
+		int frames; // in each callback, as SDL_mixer was handed them
+		// these are all in seconds
+		double period; // between callbacks, on average
+		double jitter; // the period's standard deviation
+		double maxPeriod;
+		double callbackTime; // on average; 0 if not tuning
+		double maxCallbackTime;
+		// the buffer being mixed and the one being played (the device
+		// may buffer more)
+		double latency;
+		Uint64 underruns;
+	};
+
+	// the same as Mix_OpenAudio()'s. Throws std::runtime_error if it
+	// fails.
+	AudioDevice(int frequency = MIX_DEFAULT_FREQUENCY,
+		Uint16 format = MIX_DEFAULT_FORMAT, int channels = 2,
+		int chunkSize = DEFAULT_CHUNK_SIZE);
+	~AudioDevice();
+
+	int getChunkSize() const { return chunkSize_; }
+	// since it was opened, or since resetStats()
+	Stats getStats() const;
+	void resetStats();
+
+	// Reopens audio with chunk sizes from minChunkSize, doubling up to
+	// maxChunkSize, measuring each for ms, and stays with the first one
+	// that's stable: no underruns, and no callback taking more than
+	// headroom of the period. load is run in each callback, in place of
+	// the game's mixing, if it's given.
+	// Must be called before anything's played (reopening stops it all,
+	// and removes every effect) and before the music hook is used.
+	// Returns the chunk size, or -1 on error, in which case audio may be
+	// closed (see SDL_GetError()).
+	int autoTune(int minChunkSize = 256, int maxChunkSize = 8192,
+		Uint32 ms = 1000, std::function<void(Uint8*, int)> load = NULL,
+		double headroom = 0.5);
+
+	AudioDevice(const AudioDevice &that) = delete;
+	AudioDevice & operator=(const AudioDevice &that) = delete;
+private:
+	// audio thread's; read under the audio lock
+	struct Accumulator {
+		Uint64 callbacks;
+		int frames;
+		Uint64 first, last; // performance counter ticks
+		double expected; // seconds of audio mixed, past the first
+		double baseline; // how late callbacks usually end
+		double sum, sumSquares, max;
+		Uint64 timed;
+		double timeSum, timeMax;
+		Uint64 underruns;
+	};
+
+	bool open(int chunkSize);
+	static void hook(void *udata, Uint8 *stream, int len);
+	static void postMix(void *udata, Uint8 *stream, int len);
+	void measure(int len);
+
+	int frequency_;
+	Uint16 format_;
+	int channels_;
+	int chunkSize_;
+	int frameSize_;
+	bool open_;
+	Accumulator accumulator_;
+	Uint64 start_; // of the callback, when the hook's on
+	std::function<void(Uint8*, int)> load_;
+};
+
+AudioDevice::AudioDevice(int frequency, Uint16 format, int channels,
+	int chunkSize)
+	: frequency_{frequency}, format_{format}, channels_{channels},
+	chunkSize_{chunkSize}, open_{false}, accumulator_(), start_{0}
+{
+	if(!open(chunkSize)) {
+		throw std::runtime_error(std::string("Opening audio device "
+			"failed: ") + SDL_GetError());
+	}
+}
+
+AudioDevice::~AudioDevice()
+{
+	if(open_) {
+		Mix_SetPostMix(NULL, NULL);
+		Mix_CloseAudio();
+	}
+}
+
+bool AudioDevice::open(int chunkSize)
+{
+	if(Mix_OpenAudio(frequency_, format_, channels_, chunkSize) < 0) {
+		return false;
+	}
+	open_ = true;
+	chunkSize_ = chunkSize;
+	// SDL_mixer may have been given something else
+	Mix_QuerySpec(&frequency_, &format_, &channels_);
+	frameSize_ = SDL_AUDIO_BITSIZE(format_) / 8 * channels_;
+	resetStats();
+	Mix_SetPostMix(postMix, this);
+	return true;
+}
+
+AudioDevice::Stats AudioDevice::getStats() const
+{
+	SDL_LockAudio();
+	Accumulator a = accumulator_;
+	SDL_UnlockAudio();
+
+	Stats stats = Stats();
+	stats.callbacks = a.callbacks;
+	stats.frames = a.frames;
+	stats.underruns = a.underruns;
+	// the first only starts the clock
+	if(a.callbacks > 1) {
+		double n = a.callbacks - 1;
+		stats.period = a.sum / n;
+		stats.jitter = std::sqrt(std::max(0.0,
+			a.sumSquares / n - stats.period * stats.period));
+		stats.maxPeriod = a.max;
+		stats.latency = 2 * stats.period;
+	}
+	if(a.timed > 0) {
+		stats.callbackTime = a.timeSum / a.timed;
+		stats.maxCallbackTime = a.timeMax;
+	}
+	return stats;
+}
+
+void AudioDevice::resetStats()
+{
+	SDL_LockAudio();
+	accumulator_ = Accumulator();
+	SDL_UnlockAudio();
+}
+
+int AudioDevice::autoTune(int minChunkSize, int maxChunkSize, Uint32 ms,
+	std::function<void(Uint8*, int)> load, double headroom)
+{
+	if(minChunkSize <= 0 || minChunkSize > maxChunkSize) {
+		SDL_SetError("AudioDevice: invalid chunk sizes");
+		return -1;
+	}
+	int allocated = Mix_AllocateChannels(-1);
+	int chunkSize = minChunkSize;
+	for(;;) {
+		Mix_SetPostMix(NULL, NULL);
+		Mix_CloseAudio();
+		open_ = false;
+		if(!open(chunkSize)) {
+			return -1;
+		}
+		Mix_AllocateChannels(allocated);
+		// the hook's state is set before it's installed, so it needn't
+		// be locked
+		load_ = load;
+		Mix_HookMusic(hook, this);
+		// the first few are often bunched up, filling the device's buffer
+		SDL_Delay(ms / 4);
+		resetStats();
+		SDL_Delay(ms);
+		Mix_HookMusic(NULL, NULL);
+		load_ = NULL;
+
+		Stats stats = getStats();
+		double period = static_cast<double>(stats.frames) / frequency_;
+		bool stable = stats.callbacks > 1 && stats.underruns == 0
+			&& stats.maxCallbackTime < headroom * period;
+		if(stable || chunkSize * 2 > maxChunkSize) {
+			break;
+		}
+		chunkSize *= 2;
+	}
+	resetStats();
+	return chunkSize_;
+}
+
+void AudioDevice::hook(void *udata, Uint8 *stream, int len)
+{
+	AudioDevice &device = *static_cast<AudioDevice*>(udata);
+	device.start_ = SDL_GetPerformanceCounter();
+	if(device.load_) {
+		device.load_(stream, len);
+	}
+}
+
+void AudioDevice::postMix(void *udata, Uint8 *, int len)
+{
+	static_cast<AudioDevice*>(udata)->measure(len);
+}
+
+void AudioDevice::measure(int len)
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+	Accumulator &a = accumulator_;
+	int frames = len / frameSize_;
+	double period = static_cast<double>(frames) / frequency_;
+
+	if(start_ != 0) {
+		double time = (now - start_) / frequency;
+		++a.timed;
+		a.timeSum += time;
+		a.timeMax = std::max(a.timeMax, time);
+		start_ = 0;
+	}
+	if(a.callbacks++ == 0) {
+		a.first = a.last = now;
+		a.frames = frames;
+		return;
+	}
+	double since = (now - a.last) / frequency;
+	a.last = now;
+	a.sum += since;
+	a.sumSquares += since * since;
+	a.max = std::max(a.max, since);
+
+	// how late this one ended, by the device's clock. That drifts a
+	// little from the performance counter's, so the baseline's let
+	// creep up; an underrun's a jump of a whole buffer.
+	a.expected += period;
+	double late = (now - a.first) / frequency - a.expected;
+	if(late - a.baseline > period) {
+		++a.underruns;
+		a.baseline = late;
+	} else {
+		a.baseline = std::min(late, a.baseline + period / 1024);
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_AUDIODEVICE_HPP
@@ -0,0 +1,600 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_AUDIOEFFECTS_HPP
+#define SCC_AUDIOEFFECTS_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "null.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use AudioEffects class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Registers C++ callables as SDL_mixer effects. An effect is called on the
+// audio thread as f(samples, frames), where samples are frames interleaved
+// floats (one per output channel, in -1..1) that it changes in place.
+//
+// Below are some kernels to use as effects. They take the number of
+// channels, which must be the mixer's (and the sample rate, if it matters).
+//
+// Notes:
+// - the mixer's format must be AUDIO_S16SYS or AUDIO_F32SYS. With S16, the
+//   buffer is converted to floats and back in blocks of BLOCK_FRAMES, with
+//   scratch space that's allocated at registration, so the callback itself
+//   never allocates nor locks
+// - the callable is copied (or moved) in, and destroyed when the effect is
+//   done: when it's removed, when its channel stops playing (SDL_mixer
+//   removes a channel's effects then, so add them after playing) or when
+//   the audio is closed
+// - the effect runs on the audio thread, so whatever it shares with the
+//   rest of the program must be atomic. The kernels below keep their
+//   parameters so, in a block their copies share: keep one and add() a
+//   copy, and setting the one you kept changes the effect too. Each copy
+//   has its own state (delay lines, envelopes and such), though.
+// - effects on a channel see that channel's sound only, before it's mixed;
+//   those on MIX_CHANNEL_POST see the final mix
+class AudioEffects {
+public:
+	static const int BLOCK_FRAMES = 256;
+	static const int MAX_CHANNELS = 8;
+
+	// returns false on error (see SDL_GetError())
+	template<typename F> static bool add(int channel, F f);
+	template<typename F> static bool addPost(F f)
+	{
+		return add(MIX_CHANNEL_POST, std::move(f));
+	}
+	// removes every effect on the channel, including SDL_mixer's own (eg
+	// the one Mix_SetPanning() registers)
+	static bool removeAll(int channel)
+	{
+		return Mix_UnregisterAllEffects(channel) != 0;
+	}
+
+	class Gain;
+	class Pan;
+	class Biquad;
+	class Compressor;
+	class Reverb;
+private:
+	// feedback loops decay into denormals, which are slow on many CPUs.
+	// This rounds them to zero (it isn't optimized away without
+	// -ffast-math).
+	static float flushDenormal(float x) { return x + 1e-18f - 1e-18f; }
+
+	template<typename F>
+	struct Holder {
+		Holder(F &&callable, Uint16 format, int channels)
+			: f(std::move(callable)), format{format},
+			channels{channels}
+		{}
+
+		static void effect(int channel, void *stream, int len, void *udata);
+		static void done(int channel, void *udata)
+		{
+			delete static_cast<Holder*>(udata);
+		}
+
+		F f;
+		Uint16 format;
+		int channels;
+		float block[BLOCK_FRAMES * MAX_CHANNELS];
+	};
+};
+
+template<typename F>
+bool AudioEffects::add(int channel, F f)
+{
+	int frequency, channels;
+	Uint16 format;
+	if(!Mix_QuerySpec(&frequency, &format, &channels)) {
+		return false;
+	}
+	if(format != AUDIO_S16SYS && format != AUDIO_F32SYS) {
+		SDL_SetError("AudioEffects: the mixer's format must be "
+			"AUDIO_S16SYS or AUDIO_F32SYS");
+		return false;
+	}
+	if(channels > MAX_CHANNELS) {
+		SDL_SetError("AudioEffects: too many channels: %d", channels);
+		return false;
+	}
+	Holder<F> *holder = new Holder<F>(std::move(f), format, channels);
+	if(!Mix_RegisterEffect(channel, Holder<F>::effect, Holder<F>::done,
+		holder))
+	{
+		// done isn't called for effects that weren't registered
+		delete holder;
+		return false;
+	}
+	return true;
+}
+
+template<typename F>
+void AudioEffects::Holder<F>::effect(int, void *stream, int len,
+	void *udata)
+{
+	Holder &holder = *static_cast<Holder*>(udata);
+	if(holder.format == AUDIO_F32SYS) {
+		int frames = len / (sizeof(float) * holder.channels);
+		holder.f(static_cast<float*>(stream), frames);
+		return;
+	}
+	Sint16 *samples = static_cast<Sint16*>(stream);
+	int frames = len / (sizeof(Sint16) * holder.channels);
+	const float toFloat = 1.0f / 32768.0f;
+	while(frames > 0) {
+		int n = std::min(frames, static_cast<int>(BLOCK_FRAMES));
+		int count = n * holder.channels;
+		for(int i = 0; i < count; ++i) {
+			holder.block[i] = samples[i] * toFloat;
+		}
+		holder.f(holder.block, n);
+		for(int i = 0; i < count; ++i) {
+			float s = holder.block[i] * 32768.0f;
+			s = std::max(-32768.0f, std::min(s, 32767.0f));
+			samples[i] = static_cast<Sint16>(s);
+		}
+		samples += count;
+		frames -= n;
+	}
+}
+
+// Multiplies every sample by a gain. A new gain is ramped to over a call,
+// so changing it doesn't click.
+class AudioEffects::Gain {
+public:
+	explicit Gain(float gain = 1.0f, int channels = 2)
+		: gain_{std::make_shared<std::atomic<float>>(gain)},
+		current_{gain}, channels_{channels}
+	{}
+
+	float getGain() const { return gain_->load(); }
+	void setGain(float gain) { gain_->store(gain); }
+
+	void process(float *samples, int frames);
+	void operator()(float *samples, int frames) { process(samples, frames); }
+private:
+	std::shared_ptr<std::atomic<float>> gain_;
+	float current_; // audio thread only
+	int channels_;
+};
+
+void AudioEffects::Gain::process(float *samples, int frames)
+{
+	float target = gain_->load();
+	int count = frames * channels_;
+	if(target == current_) {
+		// the common case: one multiply per sample, which GCC vectorizes
+		for(int i = 0; i < count; ++i) {
+			samples[i] *= target;
+		}
+		return;
+	}
+	float step = (target - current_) / frames;
+	for(int i = 0; i < count; i += channels_) {
+		current_ += step;
+		for(int c = 0; c < channels_; ++c) {
+			samples[i + c] *= current_;
+		}
+	}
+	current_ = target;
+}
+
+// Stereo balance, from -1 (left only) through 0 (as is) to 1 (right only),
+// with an equal power law in between. Ramped like Gain.
+// The mixer must be stereo.
+class AudioEffects::Pan {
+public:
+	explicit Pan(float pan = 0.0f)
+		: pan_{std::make_shared<std::atomic<float>>(pan)}
+	{
+		gains(pan, left_, right_);
+	}
+
+	float getPan() const { return pan_->load(); }
+	void setPan(float pan) { pan_->store(pan); }
+
+	void process(float *samples, int frames);
+	void operator()(float *samples, int frames) { process(samples, frames); }
+private:
+	static void gains(float pan, float &left, float &right)
+	{
+		const float QUARTER_PI = 0.78539816f;
+		pan = std::max(-1.0f, std::min(pan, 1.0f));
+		float angle = (pan + 1.0f) * QUARTER_PI;
+		// sqrt(2), so both are 1 at the center
+		left = std::min(1.41421356f * std::cos(angle), 1.0f);
+		right = std::min(1.41421356f * std::sin(angle), 1.0f);
+	}
+
+	std::shared_ptr<std::atomic<float>> pan_;
+	float left_, right_; // audio thread only
+};
+
+void AudioEffects::Pan::process(float *samples, int frames)
+{
+	float left, right;
+	gains(pan_->load(), left, right);
+	float leftStep = (left - left_) / frames;
+	float rightStep = (right - right_) / frames;
+	for(int i = 0; i < frames * 2; i += 2) {
+		left_ += leftStep;
+		right_ += rightStep;
+		samples[i] *= left_;
+		samples[i + 1] *= right_;
+	}
+	left_ = left;
+	right_ = right;
+}
+
+// The filters from Robert Bristow-Johnson's Audio EQ Cookbook. gain (in
+// dB) is only used by PEAK and the shelves. Parameters set from another
+// thread take effect on the next call.
+class AudioEffects::Biquad {
+public:
+	enum Type {
+		LOW_PASS, HIGH_PASS, BAND_PASS, NOTCH, PEAK, LOW_SHELF, HIGH_SHELF
+	};
+
+	Biquad(int rate, Type type, float frequency, float q = 0.7071f,
+		float gain = 0.0f, int channels = 2)
+		: rate_{rate}, channels_{channels},
+		params_{std::make_shared<Params>()}, version_{0}
+	{
+		set(type, frequency, q, gain);
+		std::fill(z1_, z1_ + MAX_CHANNELS, 0.0f);
+		std::fill(z2_, z2_ + MAX_CHANNELS, 0.0f);
+	}
+
+	void set(Type type, float frequency, float q, float gain = 0.0f);
+	Type getType() const { return static_cast<Type>(params_->type.load()); }
+	float getFrequency() const { return params_->frequency.load(); }
+	float getQ() const { return params_->q.load(); }
+	float getGain() const { return params_->gain.load(); }
+
+	void process(float *samples, int frames);
+	void operator()(float *samples, int frames) { process(samples, frames); }
+private:
+	struct Params {
+		Params() : version{0} {}
+
+		std::atomic<int> type;
+		std::atomic<float> frequency, q, gain;
+		// bumped by set(), so every copy knows to work them out again
+		std::atomic<Uint32> version;
+	};
+
+	void computeCoefficients();
+
+	int rate_, channels_;
+	std::shared_ptr<Params> params_;
+	// audio thread only
+	Uint32 version_;
+	float b0_, b1_, b2_, a1_, a2_;
+	float z1_[MAX_CHANNELS], z2_[MAX_CHANNELS];
+};
+
+void AudioEffects::Biquad::set(Type type, float frequency, float q,
+	float gain)
+{
+	params_->type.store(type);
+	params_->frequency.store(frequency);
+	params_->q.store(q);
+	params_->gain.store(gain);
+	// a call in between may see a mix of old and new parameters, but this
+	// makes the next one see all of the new ones
+	params_->version.fetch_add(1, std::memory_order_release);
+}
+
+void AudioEffects::Biquad::computeCoefficients()
+{
+	const float PI = 3.14159265f;
+	float nyquist = rate_ / 2.0f;
+	float frequency = params_->frequency.load();
+	frequency = std::max(1.0f, std::min(frequency, nyquist * 0.99f));
+	float q = std::max(params_->q.load(), 0.01f);
+	float A = std::pow(10.0f, params_->gain.load() / 40);
+	float w0 = 2 * PI * frequency / rate_;
+	float cosw = std::cos(w0);
+	float alpha = std::sin(w0) / (2 * q);
+	float shelf = 2 * std::sqrt(A) * alpha;
+	float b0, b1, b2, a0, a1, a2;
+	switch(params_->type.load()) {
+	case LOW_PASS:
+		b0 = b2 = (1 - cosw) / 2;
+		b1 = 1 - cosw;
+		a0 = 1 + alpha; a1 = -2 * cosw; a2 = 1 - alpha;
+		break;
+	case HIGH_PASS:
+		b0 = b2 = (1 + cosw) / 2;
+		b1 = -(1 + cosw);
+		a0 = 1 + alpha; a1 = -2 * cosw; a2 = 1 - alpha;
+		break;
+	case BAND_PASS: // 0 dB at the peak
+		b0 = alpha; b1 = 0; b2 = -alpha;
+		a0 = 1 + alpha; a1 = -2 * cosw; a2 = 1 - alpha;
+		break;
+	case NOTCH:
+		b0 = b2 = 1;
+		b1 = -2 * cosw;
+		a0 = 1 + alpha; a1 = -2 * cosw; a2 = 1 - alpha;
+		break;
+	case PEAK:
+		b0 = 1 + alpha * A; b1 = -2 * cosw; b2 = 1 - alpha * A;
+		a0 = 1 + alpha / A; a1 = -2 * cosw; a2 = 1 - alpha / A;
+		break;
+	case LOW_SHELF:
+		b0 = A * ((A + 1) - (A - 1) * cosw + shelf);
+		b1 = 2 * A * ((A - 1) - (A + 1) * cosw);
+		b2 = A * ((A + 1) - (A - 1) * cosw - shelf);
+		a0 = (A + 1) + (A - 1) * cosw + shelf;
+		a1 = -2 * ((A - 1) + (A + 1) * cosw);
+		a2 = (A + 1) + (A - 1) * cosw - shelf;
+		break;
+	case HIGH_SHELF:
+	default:
+		b0 = A * ((A + 1) + (A - 1) * cosw + shelf);
+		b1 = -2 * A * ((A - 1) + (A + 1) * cosw);
+		b2 = A * ((A + 1) + (A - 1) * cosw - shelf);
+		a0 = (A + 1) - (A - 1) * cosw + shelf;
+		a1 = 2 * ((A - 1) - (A + 1) * cosw);
+		a2 = (A + 1) - (A - 1) * cosw - shelf;
+		break;
+	}
+	b0_ = b0 / a0; b1_ = b1 / a0; b2_ = b2 / a0;
+	a1_ = a1 / a0; a2_ = a2 / a0;
+}
+
+void AudioEffects::Biquad::process(float *samples, int frames)
+{
+	Uint32 version = params_->version.load(std::memory_order_acquire);
+	if(version != version_) {
+		version_ = version;
+		computeCoefficients();
+	}
+	// transposed direct form II, each channel on its own
+	for(int c = 0; c < channels_; ++c) {
+		float z1 = z1_[c], z2 = z2_[c];
+		for(int i = c; i < frames * channels_; i += channels_) {
+			float x = samples[i];
+			float y = b0_ * x + z1;
+			z1 = b1_ * x - a1_ * y + z2;
+			z2 = b2_ * x - a2_ * y;
+			samples[i] = y;
+		}
+		z1_[c] = flushDenormal(z1);
+		z2_[c] = flushDenormal(z2);
+	}
+}
+
+// A feed-forward peak compressor, with the channels linked (they're all
+// turned down together). Above the threshold (in dB below full scale), the
+// level rises 1/ratio dB per dB; makeup (in dB) is applied after.
+class AudioEffects::Compressor {
+public:
+	explicit Compressor(int rate, float threshold = -20.0f,
+		float ratio = 4.0f, int channels = 2)
+		: rate_{rate}, channels_{channels},
+		params_{std::make_shared<Params>(threshold, ratio)},
+		envelope_{0.0f}
+	{}
+
+	float getThreshold() const { return params_->threshold.load(); }
+	void setThreshold(float dB) { params_->threshold.store(dB); }
+	float getRatio() const { return params_->ratio.load(); }
+	void setRatio(float ratio) { params_->ratio.store(ratio); }
+	// in ms
+	float getAttack() const { return params_->attack.load(); }
+	void setAttack(float ms) { params_->attack.store(ms); }
+	float getRelease() const { return params_->release.load(); }
+	void setRelease(float ms) { params_->release.store(ms); }
+	float getMakeup() const { return params_->makeup.load(); }
+	void setMakeup(float dB) { params_->makeup.store(dB); }
+
+	// how much the last call turned the sound down, in dB (for meters)
+	float getReduction() const { return params_->reduction.load(); }
+
+	void process(float *samples, int frames);
+	void operator()(float *samples, int frames) { process(samples, frames); }
+private:
+	float coefficient(float ms) const
+	{
+		return std::exp(-1000.0f / (std::max(ms, 0.01f) * rate_));
+	}
+
+	struct Params {
+		Params(float threshold, float ratio)
+			: threshold{threshold}, ratio{ratio}, attack{5.0f},
+			release{100.0f}, makeup{0.0f}, reduction{0.0f}
+		{}
+
+		std::atomic<float> threshold, ratio, attack, release, makeup;
+		std::atomic<float> reduction;
+	};
+
+	int rate_, channels_;
+	std::shared_ptr<Params> params_;
+	float envelope_; // audio thread only
+};
+
+void AudioEffects::Compressor::process(float *samples, int frames)
+{
+	const Params &params = *params_;
+	float threshold = std::pow(10.0f, params.threshold.load() / 20);
+	float exponent = 1 / std::max(params.ratio.load(), 1.0f) - 1;
+	float attack = coefficient(params.attack.load());
+	float release = coefficient(params.release.load());
+	float makeup = std::pow(10.0f, params.makeup.load() / 20);
+	float envelope = envelope_;
+	float gain = 1;
+	for(int i = 0; i < frames * channels_; i += channels_) {
+		float peak = 0;
+		for(int c = 0; c < channels_; ++c) {
+			peak = std::max(peak, std::fabs(samples[i + c]));
+		}
+		float k = peak > envelope ? attack : release;
+		envelope = peak + k * (envelope - peak);
+		gain = envelope > threshold
+			? std::pow(envelope / threshold, exponent) : 1.0f;
+		for(int c = 0; c < channels_; ++c) {
+			samples[i + c] *= gain * makeup;
+		}
+	}
+	envelope_ = flushDenormal(envelope);
+	params_->reduction.store(-20 * std::log10(gain));
+}
+
+// A small Schroeder reverb, after Freeverb: per channel, four damped comb
+// filters in parallel, then two allpasses, fed with the channels' average.
+// The delay lines are allocated by the constructor.
+class AudioEffects::Reverb {
+public:
+	explicit Reverb(int rate, float roomSize = 0.5f, float damping = 0.5f,
+		float mix = 0.25f, int channels = 2);
+
+	// all from 0 to 1. mix is how much of the output is reverb.
+	float getRoomSize() const { return params_->roomSize.load(); }
+	void setRoomSize(float size) { params_->roomSize.store(size); }
+	float getDamping() const { return params_->damping.load(); }
+	void setDamping(float damping) { params_->damping.store(damping); }
+	float getMix() const { return params_->mix.load(); }
+	void setMix(float mix) { params_->mix.store(mix); }
+
+	void process(float *samples, int frames);
+	void operator()(float *samples, int frames) { process(samples, frames); }
+private:
+	static const int COMBS = 4;
+	static const int ALLPASSES = 2;
+
+	struct Delay {
+		std::vector<float> buffer;
+		size_t index;
+		float store; // the comb's lowpass
+	};
+	struct Tank {
+		Delay combs[COMBS];
+		Delay allpasses[ALLPASSES];
+	};
+
+	struct Params {
+		Params(float roomSize, float damping, float mix)
+			: roomSize{roomSize}, damping{damping}, mix{mix}
+		{}
+
+		std::atomic<float> roomSize, damping, mix;
+	};
+
+	static float next(Delay &delay, float input, float feedback);
+
+	int channels_;
+	std::shared_ptr<Params> params_;
+	std::vector<Tank> tanks_;
+};
+
+AudioEffects::Reverb::Reverb(int rate, float roomSize, float damping,
+	float mix, int channels)
+	: channels_{channels},
+	params_{std::make_shared<Params>(roomSize, damping, mix)},
+	tanks_(channels)
+{
+	// Freeverb's tunings, in samples at 44.1 kHz
+	const int combLengths[COMBS] = { 1116, 1188, 1277, 1356 };
+	const int allpassLengths[ALLPASSES] = { 556, 441 };
+	const int STEREO_SPREAD = 23;
+	float scale = rate / 44100.0f;
+	for(int c = 0; c < channels; ++c) {
+		int spread = c % 2 * STEREO_SPREAD;
+		Tank &tank = tanks_[c];
+		for(int i = 0; i < COMBS; ++i) {
+			size_t length = (combLengths[i] + spread) * scale;
+			tank.combs[i].buffer.assign(std::max<size_t>(length, 1), 0);
+			tank.combs[i].index = 0;
+			tank.combs[i].store = 0;
+		}
+		for(int i = 0; i < ALLPASSES; ++i) {
+			size_t length = (allpassLengths[i] + spread) * scale;
+			tank.allpasses[i].buffer.assign(std::max<size_t>(length, 1),
+				0);
+			tank.allpasses[i].index = 0;
+			tank.allpasses[i].store = 0;
+		}
+	}
+}
+
+float AudioEffects::Reverb::next(Delay &delay, float input, float feedback)
+{
+	float output = delay.buffer[delay.index];
+	delay.buffer[delay.index] = flushDenormal(input + output * feedback);
+	if(++delay.index == delay.buffer.size()) {
+		delay.index = 0;
+	}
+	return output;
+}
+
+void AudioEffects::Reverb::process(float *samples, int frames)
+{
+	// 4 combs in place of Freeverb's 8, hence twice its input gain
+	const float INPUT_GAIN = 0.03f;
+	const float ALLPASS_FEEDBACK = 0.5f;
+	float feedback = 0.7f + 0.28f * std::min(params_->roomSize.load(), 1.0f);
+	float damping = 0.4f * std::min(params_->damping.load(), 1.0f);
+	float mix = std::max(0.0f, std::min(params_->mix.load(), 1.0f));
+	// wet is louder than dry at the same level; 3 keeps them comparable
+	float wet = mix * 3, dry = 1 - mix;
+	for(int i = 0; i < frames * channels_; i += channels_) {
+		float input = 0;
+		for(int c = 0; c < channels_; ++c) {
+			input += samples[i + c];
+		}
+		input *= INPUT_GAIN / channels_;
+		for(int c = 0; c < channels_; ++c) {
+			Tank &tank = tanks_[c];
+			float out = 0;
+			for(Delay &comb : tank.combs) {
+				float delayed = comb.buffer[comb.index];
+				comb.store = flushDenormal(delayed * (1 - damping)
+					+ comb.store * damping);
+				comb.buffer[comb.index] = input + comb.store * feedback;
+				if(++comb.index == comb.buffer.size()) {
+					comb.index = 0;
+				}
+				out += delayed;
+			}
+			for(Delay &allpass : tank.allpasses) {
+				float delayed = next(allpass, out, ALLPASS_FEEDBACK);
+				out = delayed - out;
+			}
+			samples[i + c] = samples[i + c] * dry + out * wet;
+		}
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_AUDIOEFFECTS_HPP
@@ -0,0 +1,305 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_AUDIOLOADER_HPP
+#define SCC_AUDIOLOADER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include "null.hpp"
+#include "rwops.hpp"
+#include "audiochunk.hpp"
+#include "parallelfor.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use AudioLoader class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Loads AudioChunks already converted to the opened device's format, like
+// AudioChunk(const RWops&) does, but many at once: loadAll() decodes,
+// converts and resamples on several threads.
+//
+// Notes:
+// - only WAVs are decoded here (with SDL_LoadWAV_RW(), which is thread
+//   safe); other formats are left to Mix_LoadWAV_RW(), like AudioChunk
+//   does. SDL_mixer doesn't promise that's thread safe, so those loads
+//   take turns, on a lock every AudioLoader shares.
+// - the sample rate is converted by resample(), which is faster than
+//   SDL_AudioCVT's (and better than that of SDL before 2.0.7); the rest
+//   of the conversion (format and channels) is SDL_AudioCVT's
+// - the loader remembers the device's format when made. Audio must be open
+//   by then, and not be reopened with another format while it's used.
+class AudioLoader {
+public:
+	// Throws std::runtime_error if audio isn't open.
+	AudioLoader();
+
+	// These throw std::runtime_error on failure.
+	AudioChunk load(const char *path) const
+	{
+		RWops file(path, "rb");
+		return load(file);
+	}
+	// file must be at the start of the sound
+	AudioChunk load(RWops &file) const;
+	// in the order of paths, on up to threadCount threads (0 means one
+	// per core). If any fails, the first error is thrown and what's
+	// been loaded is freed.
+	std::vector<AudioChunk> loadAll(const std::vector<std::string> &paths,
+		unsigned threadCount = 0) const;
+
+	// Linear interpolation of srcFrames interleaved frames into
+	// dstFrames; src and dst mustn't overlap. Mono and stereo have loops
+	// of their own, over frames, which GCC vectorizes at -O3.
+	static void resample(const float *src, size_t srcFrames, float *dst,
+		size_t dstFrames, int channels);
+
+private:
+	struct Free {
+		void operator()(Uint8 *buffer) { SDL_free(buffer); }
+	};
+	using Buffer = std::unique_ptr<Uint8, Free>;
+
+	// SDL_LoadWAV_RW() returns the spec it was given; it's not freed
+	struct SpecDeleter {
+		void operator()(SDL_AudioSpec *) {}
+	};
+	struct WavDeleter {
+		void operator()(Uint8 *buffer) { SDL_FreeWAV(buffer); }
+	};
+
+	// resample()'s first frames, channels known at compile time. Indices
+	// are 32 bits, since loads through 64 bit ones don't vectorize.
+	template <int CHANNELS>
+	static void resampleFrames(const float *__restrict src,
+		float *__restrict dst, size_t frames, Uint64 step);
+
+	// what loads through Mix_LoadWAV_RW() lock
+	static std::mutex &mixerLock()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	static bool isWav(RWops &file);
+	// A new buffer with src converted; len is updated to the new length.
+	// Throws std::runtime_error on failure.
+	static Buffer convert(const Uint8 *src, Uint32 &len,
+		SDL_AudioFormat srcFormat, Uint8 srcChannels,
+		SDL_AudioFormat dstFormat, Uint8 dstChannels, int rate);
+
+	int frequency_;
+	Uint16 format_;
+	int channels_;
+};
+
+AudioLoader::AudioLoader()
+{
+	if(Mix_QuerySpec(&frequency_, &format_, &channels_) == 0) {
+		throw std::runtime_error("Making audio loader failed: audio "
+			"isn't open");
+	}
+}
+
+AudioChunk AudioLoader::load(RWops &file) const
+{
+	if(!isWav(file)) {
+		std::lock_guard<std::mutex> lock(mixerLock());
+		return AudioChunk(file);
+	}
+	SDL_AudioSpec spec;
+	Uint8 *samples;
+	Uint32 len;
+	FromRWops<SpecDeleter>::load(file, SDL_LoadWAV_RW,
+		"Loading audio chunk from file failed", &spec, &samples, &len);
+	std::unique_ptr<Uint8, WavDeleter> wav(samples);
+
+	Buffer converted;
+	if(spec.freq == frequency_) {
+		converted = convert(samples, len, spec.format, spec.channels,
+			format_, channels_, frequency_);
+	} else {
+		// in floats, where the resampling is done
+		Buffer source = convert(samples, len, spec.format, spec.channels,
+			AUDIO_F32SYS, channels_, spec.freq);
+		wav.reset();
+		size_t frameSize = channels_ * sizeof(float);
+		size_t srcFrames = len / frameSize;
+		size_t dstFrames = static_cast<size_t>(
+			static_cast<Uint64>(srcFrames) * frequency_ / spec.freq);
+		Buffer resampled(static_cast<Uint8*>(
+			SDL_malloc(dstFrames * frameSize + 1)));
+		if(!resampled) {
+			throw std::runtime_error("Loading audio chunk from file "
+				"failed: out of memory");
+		}
+		resample(reinterpret_cast<const float*>(source.get()), srcFrames,
+			reinterpret_cast<float*>(resampled.get()), dstFrames,
+			channels_);
+		source.reset();
+		len = static_cast<Uint32>(dstFrames * frameSize);
+		converted = convert(resampled.get(), len, AUDIO_F32SYS, channels_,
+			format_, channels_, frequency_);
+	}
+
+	Mix_Chunk *chunk = Mix_QuickLoad_RAW(converted.get(), len);
+	if(chunk == NULL) {
+		throw std::runtime_error("Loading audio chunk from file failed");
+	}
+	// so that Mix_FreeChunk() frees the samples too (with SDL_free())
+	chunk->allocated = 1;
+	converted.release();
+	return AudioChunk(chunk);
+}
+
+std::vector<AudioChunk> AudioLoader::loadAll(
+	const std::vector<std::string> &paths, unsigned threadCount) const
+{
+	// AudioChunk can't be default constructed, so they're made as
+	// they're loaded and moved in order afterwards
+	std::vector<std::unique_ptr<AudioChunk>> loaded(paths.size());
+	parallelFor(0, paths.size(), [&](size_t i) {
+		loaded[i].reset(new AudioChunk(load(paths[i].c_str())));
+	}, threadCount);
+
+	std::vector<AudioChunk> chunks;
+	chunks.reserve(paths.size());
+	for(std::unique_ptr<AudioChunk> &chunk : loaded) {
+		chunks.push_back(std::move(*chunk));
+	}
+	return chunks;
+}
+
+void AudioLoader::resample(const float *src, size_t srcFrames, float *dst,
+	size_t dstFrames, int channels)
+{
+	if(srcFrames == 0 || dstFrames == 0) {
+		return;
+	}
+	// in 32.32 fixed point, so positions don't drift on long sounds
+	Uint64 step = (static_cast<Uint64>(srcFrames) << 32) / dstFrames;
+	// from this frame on, the next source frame would be out of bounds
+	size_t last = 0;
+	if(srcFrames > 1) {
+		last = static_cast<size_t>(
+			((static_cast<Uint64>(srcFrames - 1) << 32) - 1) / step + 1);
+		last = std::min(last, dstFrames);
+	}
+
+	bool small = static_cast<Uint64>(srcFrames) * channels
+		<= static_cast<Uint64>(std::numeric_limits<Sint32>::max());
+	if(small && channels == 1) {
+		resampleFrames<1>(src, dst, last, step);
+	} else if(small && channels == 2) {
+		resampleFrames<2>(src, dst, last, step);
+	} else {
+		Uint64 position = 0;
+		for(size_t i = 0; i < last; ++i, position += step) {
+			size_t index = static_cast<size_t>(position >> 32) * channels;
+			float fraction = static_cast<Uint32>(position)
+				* (1.0f / 4294967296.0f);
+			for(int c = 0; c < channels; ++c) {
+				float a = src[index + c];
+				float b = src[index + channels + c];
+				dst[i * channels + c] = a + (b - a) * fraction;
+			}
+		}
+	}
+	// the tail just holds the last frame
+	const float *end = src + (srcFrames - 1) * channels;
+	for(size_t i = last; i < dstFrames; ++i) {
+		for(int c = 0; c < channels; ++c) {
+			dst[i * channels + c] = end[c];
+		}
+	}
+}
+
+template <int CHANNELS>
+void AudioLoader::resampleFrames(const float *__restrict src,
+	float *__restrict dst, size_t frames, Uint64 step)
+{
+	Uint64 position = 0;
+	for(size_t i = 0; i < frames; ++i, position += step) {
+		Sint32 index = static_cast<Sint32>(position >> 32) * CHANNELS;
+		float fraction = static_cast<Uint32>(position)
+			* (1.0f / 4294967296.0f);
+		for(int c = 0; c < CHANNELS; ++c) {
+			float a = src[index + c];
+			float b = src[index + CHANNELS + c];
+			dst[i * CHANNELS + c] = a + (b - a) * fraction;
+		}
+	}
+}
+
+bool AudioLoader::isWav(RWops &file)
+{
+	Uint8 header[12];
+	Sint64 start = file.tell();
+	size_t count = file.read(header, sizeof(header), 1);
+	file.seek(start, RW_SEEK_SET);
+	return count == 1 && std::memcmp(header, "RIFF", 4) == 0
+		&& std::memcmp(header + 8, "WAVE", 4) == 0;
+}
+
+AudioLoader::Buffer AudioLoader::convert(const Uint8 *src, Uint32 &len,
+	SDL_AudioFormat srcFormat, Uint8 srcChannels, SDL_AudioFormat dstFormat,
+	Uint8 dstChannels, int rate)
+{
+	SDL_AudioCVT cvt;
+	if(SDL_BuildAudioCVT(&cvt, srcFormat, srcChannels, rate, dstFormat,
+		dstChannels, rate) < 0)
+	{
+		throw std::runtime_error("Loading audio chunk from file failed: "
+			"can't convert to the device's format");
+	}
+	// SDL_ConvertAudio() needs room for the intermediate steps
+	size_t capacity = static_cast<size_t>(len)
+		* (cvt.needed ? cvt.len_mult : 1);
+	Buffer converted(static_cast<Uint8*>(SDL_malloc(capacity + 1)));
+	if(!converted) {
+		throw std::runtime_error("Loading audio chunk from file failed: "
+			"out of memory");
+	}
+	std::memcpy(converted.get(), src, len);
+	if(cvt.needed) {
+		cvt.buf = converted.get();
+		cvt.len = len;
+		if(SDL_ConvertAudio(&cvt) < 0) {
+			throw std::runtime_error("Loading audio chunk from file "
+				"failed: converting to the device's format failed");
+		}
+		len = cvt.len_cvt;
+	}
+	return converted;
+}
+
+} // namespace SDL
+
+#endif // SCC_AUDIOLOADER_HPP
@@ -0,0 +1,712 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_CHUNKEDRWOPS_HPP
+#define SCC_CHUNKEDRWOPS_HPP
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include "null.hpp"
+#include "rwops.hpp"
+
+namespace SDL {
+
+// Read-only, seekable RWops over a chunked compressed container.
+//
+// The container (made with pack()) holds independently compressed blocks of
+// a fixed uncompressed size, plus an index of where each block starts. A read
+// only decompresses the blocks it touches, so seeking costs about the same as
+// it would in the uncompressed data, and loaders that stream through
+// RWops::seek() (eg Mix_LoadMUS_RW) work unchanged.
+//
+// Layout (all integers are little-endian):
+//	header: "SCCZ", version (32 bits), block size (32), block count (32),
+//		uncompressed size (64), index offset (64)
+//	blocks
+//	index: block count entries of offset (64) and compressed size (32)
+// A block whose compressed size equals its uncompressed size is stored as is.
+//
+// Notes:
+// - the codec is LZ4's block format: not the tightest, but decompressing is
+//   little more than a memcpy()
+// - decompressed blocks are kept in a small LRU cache. When reads are
+//   sequential, the next block is decompressed ahead on a worker thread.
+class ChunkedRWops {
+public:
+	static const Uint32 DEFAULT_BLOCK_SIZE = 64 * 1024;
+	static const int DEFAULT_CACHE_BLOCKS = 8;
+
+	// Compresses everything from src's current position to its end into
+	// dest, which must be seekable (the header is rewritten at the end).
+	// Returns how many bytes were written to dest, or -1 on error, in
+	// which case SDL_GetError() says why.
+	static Sint64 pack(const RWops &src, RWops &dest,
+		Uint32 blockSize = DEFAULT_BLOCK_SIZE);
+
+	// Opens a container made by pack(). The returned RWops owns container
+	// and can be passed anywhere a RWops is expected. It can't be written
+	// to. Throws if container doesn't look like a valid container.
+	static RWops open(RWops container,
+		int cacheBlocks = DEFAULT_CACHE_BLOCKS, bool readAhead = true);
+
+private:
+	static const Uint32 VERSION = 1;
+	static const int HEADER_SIZE = 32;
+	static const int INDEX_ENTRY_SIZE = 12;
+	static const Uint32 NO_BLOCK = 0xffffffff;
+
+	struct IndexEntry {
+		Sint64 offset;
+		Uint32 size;
+	};
+
+	// what open() adapts into a RWops
+	class Stream;
+
+	static void put32(Uint8 *dst, Uint32 value);
+	static void put64(Uint8 *dst, Uint64 value);
+	static Uint32 get32(const Uint8 *src);
+	static Uint64 get64(const Uint8 *src);
+
+	// Both return 0 on failure. compressBlock() also fails when the
+	// result wouldn't fit in dstCapacity.
+	static int compressBlock(const Uint8 *src, int srcSize, Uint8 *dst,
+		int dstCapacity);
+	static bool decompressBlock(const Uint8 *src, int srcSize, Uint8 *dst,
+		int dstSize);
+};
+
+class ChunkedRWops::Stream {
+public:
+	Stream(RWops container, int cacheBlocks, bool readAhead);
+	~Stream();
+
+	// for RWops::adapt(). There's no write(), so writing fails.
+	Sint64 size() const { return size_; }
+	Sint64 seek(Sint64 offset, int whence);
+	size_t read(void *ptr, size_t size, size_t maxnum);
+
+	Stream(const Stream &that) = delete;
+	Stream & operator=(const Stream &that) = delete;
+private:
+	struct Block {
+		Uint32 index;
+		Uint64 lastUse;
+		std::vector<Uint8> data;
+	};
+
+	Uint32 blockLength(Uint32 index) const
+	{
+		Uint64 begin = static_cast<Uint64>(index) * blockSize_;
+		return static_cast<Uint32>(
+			std::min<Uint64>(blockSize_, size_ - begin));
+	}
+
+	// all of these must be called with mutex_ locked
+	bool isCached(Uint32 index) const;
+	Block *find(Uint32 index);
+	Block *insert(Uint32 index, std::vector<Uint8> &data);
+	bool readCompressed(Uint32 index, std::vector<Uint8> &compressed);
+	// may unlock the mutex while decompressing. The returned block is
+	// valid until the mutex is unlocked again.
+	Block *fetch(Uint32 index, std::unique_lock<std::mutex> &lock);
+
+	// only reads what never changes after construction, so it's called
+	// with mutex_ unlocked
+	bool decode(Uint32 index, const std::vector<Uint8> &compressed,
+		std::vector<Uint8> &data) const;
+
+	size_t readBytes(Uint8 *dst, size_t count);
+	void work();
+
+	RWops container_;
+	Uint32 blockSize_;
+	Uint64 size_;
+	std::vector<IndexEntry> index_;
+	Sint64 position_;
+
+	std::vector<Block> cache_;
+	Uint64 useClock_;
+	std::vector<Uint8> compressed_;
+	std::vector<Uint8> decompressed_;
+	Uint32 lastBlock_;
+
+	// read-ahead state, shared with the worker
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	Uint32 prefetch_;
+	Uint32 inFlight_;
+	bool quit_;
+	std::thread worker_;
+};
+
+RWops ChunkedRWops::open(RWops container, int cacheBlocks, bool readAhead)
+{
+	// Stream can't be moved (it owns a thread and a mutex)
+	return RWops::adapt(std::unique_ptr<Stream>(new Stream(
+		std::move(container), cacheBlocks, readAhead)));
+}
+
+Sint64 ChunkedRWops::pack(const RWops &src, RWops &dest, Uint32 blockSize)
+{
+	if(blockSize == 0 || blockSize > 0x7fffffff) {
+		SDL_SetError("ChunkedRWops: invalid block size");
+		return -1;
+	}
+	Sint64 start = dest.tell();
+	Uint8 header[HEADER_SIZE] = {0};
+	if(dest.write(header, HEADER_SIZE, 1) != 1) {
+		return -1;
+	}
+
+	std::vector<Uint8> raw(blockSize);
+	// never bigger than the raw block: if compressing doesn't save at
+	// least a byte, the block is stored instead
+	std::vector<Uint8> packed(blockSize);
+	std::vector<IndexEntry> index;
+	Uint64 size = 0;
+	Sint64 offset = HEADER_SIZE;
+
+	bool end = false;
+	while(!end) {
+		// every block but the last must be full, and some RWops return
+		// short reads before the end
+		size_t got = 0;
+		while(got < blockSize) {
+			size_t n = src.read(raw.data() + got, 1, blockSize - got);
+			if(n == 0) {
+				end = true;
+				break;
+			}
+			got += n;
+		}
+		if(got == 0) {
+			break;
+		}
+		int rawSize = static_cast<int>(got);
+		int packedSize = compressBlock(raw.data(), rawSize,
+			packed.data(), rawSize - 1);
+		const Uint8 *out = packed.data();
+		if(packedSize == 0) {
+			out = raw.data();
+			packedSize = rawSize;
+		}
+		if(dest.write(out, packedSize, 1) != 1) {
+			return -1;
+		}
+		index.push_back(IndexEntry{offset,
+			static_cast<Uint32>(packedSize)});
+		offset += packedSize;
+		size += got;
+	}
+
+	std::vector<Uint8> entries(index.size() * INDEX_ENTRY_SIZE);
+	for(size_t i = 0; i < index.size(); ++i) {
+		put64(&entries[i * INDEX_ENTRY_SIZE], index[i].offset);
+		put32(&entries[i * INDEX_ENTRY_SIZE + 8], index[i].size);
+	}
+	if(!entries.empty()
+		&& dest.write(entries.data(), entries.size(), 1) != 1)
+	{
+		return -1;
+	}
+
+	std::memcpy(header, "SCCZ", 4);
+	put32(header + 4, VERSION);
+	put32(header + 8, blockSize);
+	put32(header + 12, static_cast<Uint32>(index.size()));
+	put64(header + 16, size);
+	put64(header + 24, offset);
+	if(dest.seek(start, RW_SEEK_SET) < 0
+		|| dest.write(header, HEADER_SIZE, 1) != 1
+		|| dest.seek(start + offset + entries.size(), RW_SEEK_SET) < 0)
+	{
+		return -1;
+	}
+	return offset + entries.size();
+}
+
+void ChunkedRWops::put32(Uint8 *dst, Uint32 value)
+{
+	for(int i = 0; i < 4; ++i) {
+		dst[i] = static_cast<Uint8>(value >> (8 * i));
+	}
+}
+
+void ChunkedRWops::put64(Uint8 *dst, Uint64 value)
+{
+	for(int i = 0; i < 8; ++i) {
+		dst[i] = static_cast<Uint8>(value >> (8 * i));
+	}
+}
+
+Uint32 ChunkedRWops::get32(const Uint8 *src)
+{
+	Uint32 value = 0;
+	for(int i = 3; i >= 0; --i) {
+		value = (value << 8) | src[i];
+	}
+	return value;
+}
+
+Uint64 ChunkedRWops::get64(const Uint8 *src)
+{
+	Uint64 value = 0;
+	for(int i = 7; i >= 0; --i) {
+		value = (value << 8) | src[i];
+	}
+	return value;
+}
+
+int ChunkedRWops::compressBlock(const Uint8 *src, int srcSize, Uint8 *dst,
+	int dstCapacity)
+{
+	// the constants below are LZ4's, so the output is a valid LZ4 block
+	const int MIN_MATCH = 4;
+	const int LAST_LITERALS = 5;
+	const int MATCH_FIND_LIMIT = 12;
+	const int MAX_OFFSET = 65535;
+	const int HASH_BITS = 12;
+
+	int table[1 << HASH_BITS];
+	std::fill(table, table + (1 << HASH_BITS), -1);
+
+	Uint8 *op = dst;
+	Uint8 *const opEnd = dst + dstCapacity;
+	int anchor = 0;
+	int ip = 0;
+
+	// writes a length that didn't fit in the token's nibble
+	auto putLength = [&op](int length) {
+		for(; length >= 255; length -= 255) {
+			*op++ = 255;
+		}
+		*op++ = static_cast<Uint8>(length);
+	};
+	// worst case size of a sequence, so we check for room only once
+	auto room = [&op, opEnd](int literals, int matchLength) {
+		return opEnd - op >= 1 + literals / 255 + 1 + literals + 2
+			+ matchLength / 255 + 1;
+	};
+
+	while(ip < srcSize - MATCH_FIND_LIMIT) {
+		Uint32 sequence;
+		std::memcpy(&sequence, src + ip, 4);
+		Uint32 hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+		int ref = table[hash];
+		table[hash] = ip;
+		if(ref < 0 || ip - ref > MAX_OFFSET
+			|| std::memcmp(src + ref, src + ip, 4) != 0)
+		{
+			++ip;
+			continue;
+		}
+		int length = MIN_MATCH;
+		while(ip + length < srcSize - LAST_LITERALS
+			&& src[ref + length] == src[ip + length])
+		{
+			++length;
+		}
+
+		int literals = ip - anchor;
+		int matchCode = length - MIN_MATCH;
+		if(!room(literals, matchCode)) {
+			return 0;
+		}
+		*op++ = static_cast<Uint8>((std::min(literals, 15) << 4)
+			| std::min(matchCode, 15));
+		if(literals >= 15) {
+			putLength(literals - 15);
+		}
+		std::memcpy(op, src + anchor, literals);
+		op += literals;
+		*op++ = static_cast<Uint8>(ip - ref);
+		*op++ = static_cast<Uint8>((ip - ref) >> 8);
+		if(matchCode >= 15) {
+			putLength(matchCode - 15);
+		}
+		ip += length;
+		anchor = ip;
+	}
+
+	// the last sequence has literals only
+	int literals = srcSize - anchor;
+	if(!room(literals, 0)) {
+		return 0;
+	}
+	*op++ = static_cast<Uint8>(std::min(literals, 15) << 4);
+	if(literals >= 15) {
+		putLength(literals - 15);
+	}
+	std::memcpy(op, src + anchor, literals);
+	op += literals;
+	return static_cast<int>(op - dst);
+}
+
+bool ChunkedRWops::decompressBlock(const Uint8 *src, int srcSize, Uint8 *dst,
+	int dstSize)
+{
+	const Uint8 *ip = src;
+	const Uint8 *const ipEnd = src + srcSize;
+	Uint8 *op = dst;
+	Uint8 *const opEnd = dst + dstSize;
+
+	// reads a length that didn't fit in the token's nibble
+	auto getLength = [&ip, ipEnd](size_t &length) {
+		Uint8 byte;
+		do {
+			if(ip == ipEnd) {
+				return false;
+			}
+			byte = *ip++;
+			length += byte;
+		} while(byte == 255);
+		return true;
+	};
+
+	while(ip < ipEnd) {
+		Uint8 token = *ip++;
+		size_t literals = token >> 4;
+		if(literals == 15 && !getLength(literals)) {
+			return false;
+		}
+		if(literals > static_cast<size_t>(ipEnd - ip)
+			|| literals > static_cast<size_t>(opEnd - op))
+		{
+			return false;
+		}
+		std::memcpy(op, ip, literals);
+		op += literals;
+		ip += literals;
+		if(ip == ipEnd) {
+			break; // the last sequence has no match
+		}
+
+		if(ipEnd - ip < 2) {
+			return false;
+		}
+		size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if(offset == 0 || offset > static_cast<size_t>(op - dst)) {
+			return false;
+		}
+		size_t length = token & 15;
+		if(length == 15 && !getLength(length)) {
+			return false;
+		}
+		length += 4;
+		if(length > static_cast<size_t>(opEnd - op)) {
+			return false;
+		}
+		// the match may overlap what it's writing, so no memcpy()
+		const Uint8 *match = op - offset;
+		while(length-- > 0) {
+			*op++ = *match++;
+		}
+	}
+	return op == opEnd;
+}
+
+ChunkedRWops::Stream::Stream(RWops container, int cacheBlocks, bool readAhead)
+	: container_{std::move(container)}, blockSize_{0}, size_{0},
+	position_{0}, cache_(std::max(cacheBlocks, 1)), useClock_{0},
+	lastBlock_{NO_BLOCK}, prefetch_{NO_BLOCK}, inFlight_{NO_BLOCK},
+	quit_{false}
+{
+	Uint8 header[HEADER_SIZE];
+	if(container_.read(header, HEADER_SIZE, 1) != 1
+		|| std::memcmp(header, "SCCZ", 4) != 0)
+	{
+		throw std::runtime_error("Opening chunked RWops failed: "
+			"not a chunked container");
+	}
+	if(get32(header + 4) != VERSION) {
+		throw std::runtime_error("Opening chunked RWops failed: "
+			"unsupported version");
+	}
+	blockSize_ = get32(header + 8);
+	Uint32 blockCount = get32(header + 12);
+	size_ = get64(header + 16);
+	Sint64 indexOffset = get64(header + 24);
+	if(blockSize_ == 0 || blockSize_ > 0x7fffffff
+		|| (size_ + blockSize_ - 1) / blockSize_ != blockCount)
+	{
+		throw std::runtime_error("Opening chunked RWops failed: "
+			"corrupt header");
+	}
+
+	// checked against the container before anything's allocated, so a
+	// corrupt count can't ask for gigabytes
+	Sint64 containerSize = container_.size();
+	Uint64 indexSize = static_cast<Uint64>(blockCount) * INDEX_ENTRY_SIZE;
+	if(indexOffset < HEADER_SIZE || (containerSize >= 0
+		&& (indexOffset > containerSize || indexSize
+			> static_cast<Uint64>(containerSize - indexOffset))))
+	{
+		throw std::runtime_error("Opening chunked RWops failed: "
+			"corrupt header");
+	}
+	if(container_.seek(indexOffset, RW_SEEK_SET) < 0) {
+		throw std::runtime_error("Opening chunked RWops failed: "
+			"couldn't read block index");
+	}
+	// a batch at a time, for containers whose size isn't known: there,
+	// a corrupt count runs out of index to read rather than of memory
+	const Uint32 BATCH = 4096;
+	std::vector<Uint8> entries(std::min(blockCount, BATCH)
+		* INDEX_ENTRY_SIZE);
+	for(Uint32 first = 0; first < blockCount; first += BATCH) {
+		Uint32 count = std::min(blockCount - first, BATCH);
+		if(container_.read(entries.data(), count * INDEX_ENTRY_SIZE, 1)
+			!= 1)
+		{
+			throw std::runtime_error("Opening chunked RWops failed: "
+				"couldn't read block index");
+		}
+		for(Uint32 j = 0; j < count; ++j) {
+			IndexEntry entry;
+			entry.offset = get64(&entries[j * INDEX_ENTRY_SIZE]);
+			entry.size = get32(&entries[j * INDEX_ENTRY_SIZE + 8]);
+			if(entry.size == 0 || entry.size > blockLength(first + j)) {
+				throw std::runtime_error("Opening chunked RWops "
+					"failed: corrupt block index");
+			}
+			index_.push_back(entry);
+		}
+	}
+
+	for(Block &block : cache_) {
+		block.index = NO_BLOCK;
+		block.lastUse = 0;
+	}
+	// started last, so the ctor can still throw without joining it
+	if(readAhead && blockCount > 1) {
+		worker_ = std::thread(&Stream::work, this);
+	}
+}
+
+ChunkedRWops::Stream::~Stream()
+{
+	if(worker_.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			quit_ = true;
+		}
+		cond_.notify_all();
+		worker_.join();
+	}
+}
+
+Sint64 ChunkedRWops::Stream::seek(Sint64 offset, int whence)
+{
+	Sint64 base;
+	switch(whence) {
+	case RW_SEEK_SET:
+		base = 0;
+	break;
+	case RW_SEEK_CUR:
+		base = position_;
+	break;
+	case RW_SEEK_END:
+		base = size_;
+	break;
+	default:
+		SDL_SetError("ChunkedRWops: unknown value for 'whence'");
+		return -1;
+	}
+	if(base + offset < 0) {
+		SDL_SetError("ChunkedRWops: can't seek before the beginning");
+		return -1;
+	}
+	position_ = base + offset;
+	return position_;
+}
+
+size_t ChunkedRWops::Stream::read(void *ptr, size_t size, size_t maxnum)
+{
+	if(size == 0 || maxnum == 0) {
+		return 0;
+	}
+	// like SDL's own RWops, whole objects only
+	Uint64 left = static_cast<Uint64>(position_) < size_
+		? size_ - position_ : 0;
+	size_t count = static_cast<size_t>(
+		std::min<Uint64>(left / size, maxnum));
+	return readBytes(static_cast<Uint8*>(ptr), count * size) / size;
+}
+
+size_t ChunkedRWops::Stream::readBytes(Uint8 *dst, size_t count)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	size_t done = 0;
+	Uint32 index = NO_BLOCK;
+	while(done < count) {
+		index = static_cast<Uint32>(position_ / blockSize_);
+		Uint32 offset = static_cast<Uint32>(position_ % blockSize_);
+		Block *block = fetch(index, lock);
+		if(block == NULL) {
+			break;
+		}
+		size_t n = std::min<size_t>(count - done,
+			block->data.size() - offset);
+		std::memcpy(dst + done, block->data.data() + offset, n);
+		done += n;
+		position_ += n;
+	}
+
+	// sequential reader: have the next block ready before it's asked for
+	if(worker_.joinable() && index != NO_BLOCK
+		&& (index == lastBlock_ || index == lastBlock_ + 1)
+		&& index + 1 < index_.size() && !isCached(index + 1))
+	{
+		prefetch_ = index + 1;
+		cond_.notify_all();
+	}
+	lastBlock_ = index;
+	return done;
+}
+
+bool ChunkedRWops::Stream::isCached(Uint32 index) const
+{
+	for(const Block &block : cache_) {
+		if(block.index == index) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// unlike isCached(), counts as a use of the block
+ChunkedRWops::Stream::Block *ChunkedRWops::Stream::find(Uint32 index)
+{
+	for(Block &block : cache_) {
+		if(block.index == index) {
+			block.lastUse = ++useClock_;
+			return &block;
+		}
+	}
+	return NULL;
+}
+
+ChunkedRWops::Stream::Block *ChunkedRWops::Stream::insert(Uint32 index,
+	std::vector<Uint8> &data)
+{
+	// someone else might have decompressed the same block meanwhile
+	Block *block = find(index);
+	if(block != NULL) {
+		return block;
+	}
+	block = &*std::min_element(cache_.begin(), cache_.end(),
+		[](const Block &a, const Block &b) {
+			return a.lastUse < b.lastUse;
+		});
+	block->index = index;
+	block->lastUse = ++useClock_;
+	// swapping, rather than copying, recycles the evicted buffer
+	block->data.swap(data);
+	return block;
+}
+
+bool ChunkedRWops::Stream::readCompressed(Uint32 index,
+	std::vector<Uint8> &compressed)
+{
+	const IndexEntry &entry = index_[index];
+	compressed.resize(entry.size);
+	if(container_.seek(entry.offset, RW_SEEK_SET) < 0) {
+		return false;
+	}
+	return container_.read(compressed.data(), entry.size, 1) == 1;
+}
+
+bool ChunkedRWops::Stream::decode(Uint32 index,
+	const std::vector<Uint8> &compressed, std::vector<Uint8> &data) const
+{
+	Uint32 length = blockLength(index);
+	data.resize(length);
+	if(compressed.size() == length) {
+		std::memcpy(data.data(), compressed.data(), length);
+		return true;
+	}
+	if(!decompressBlock(compressed.data(),
+		static_cast<int>(compressed.size()), data.data(), length))
+	{
+		SDL_SetError("ChunkedRWops: corrupt block");
+		return false;
+	}
+	return true;
+}
+
+ChunkedRWops::Stream::Block *ChunkedRWops::Stream::fetch(Uint32 index,
+	std::unique_lock<std::mutex> &lock)
+{
+	// no point in decompressing what the worker is already working on
+	cond_.wait(lock, [this, index] { return inFlight_ != index; });
+	Block *block = find(index);
+	if(block != NULL) {
+		return block;
+	}
+	if(!readCompressed(index, compressed_)) {
+		return NULL;
+	}
+	lock.unlock();
+	bool ok = decode(index, compressed_, decompressed_);
+	lock.lock();
+	return ok ? insert(index, decompressed_) : NULL;
+}
+
+void ChunkedRWops::Stream::work()
+{
+	std::vector<Uint8> compressed;
+	std::vector<Uint8> data;
+	std::unique_lock<std::mutex> lock(mutex_);
+	while(true) {
+		cond_.wait(lock, [this] {
+			return quit_ || prefetch_ != NO_BLOCK;
+		});
+		if(quit_) {
+			break;
+		}
+		Uint32 index = prefetch_;
+		prefetch_ = NO_BLOCK;
+		if(isCached(index) || !readCompressed(index, compressed)) {
+			continue;
+		}
+		inFlight_ = index;
+		lock.unlock();
+		bool ok = decode(index, compressed, data);
+		lock.lock();
+		inFlight_ = NO_BLOCK;
+		if(ok) {
+			insert(index, data);
+		}
+		cond_.notify_all();
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_CHUNKEDRWOPS_HPP
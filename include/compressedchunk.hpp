@@ -0,0 +1,384 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_COMPRESSEDCHUNK_HPP
+#define SCC_COMPRESSEDCHUNK_HPP
+
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "null.hpp"
+#include "audiochunk.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use CompressedChunk class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// An AudioChunk that's kept in memory as IMA ADPCM, a quarter of the size,
+// and decoded as it plays, a callback's worth at a time.
+//
+// It's played like an AudioChunk, but what SDL_mixer plays is a short
+// silent chunk (the carrier), looped for as long as the sound lasts; an
+// effect on its channel decodes the sound over the silence. So:
+// - the channel's and the carrier's volumes, fades and everything else
+//   that applies to channels work as usual
+// - the channel may be busy for up to BLOCK_FRAMES after the sound ends
+//   (which is silent), since the carrier is looped whole
+// - the mixer's format must be AUDIO_S16SYS
+// - ADPCM is lossy, but hard to tell apart from the original for most
+//   sound effects and ambience (it's what many consoles use)
+// - the sound is split in blocks of BLOCK_FRAMES that can each be decoded
+//   on their own, though playing decodes them straight through
+class CompressedChunk {
+public:
+	static const Uint32 BLOCK_FRAMES = 1024;
+
+	// Compresses the chunk, which may then be destroyed. Throws
+	// std::runtime_error if audio isn't open, or its format isn't
+	// AUDIO_S16SYS.
+	explicit CompressedChunk(const AudioChunk &chunk);
+	explicit CompressedChunk(const char *filename)
+		: CompressedChunk(AudioChunk(filename))
+	{}
+
+	// the same as AudioChunk's
+	int play(int channel, int loops, int ticks = -1);
+	int fadeIn(int channel, int loops, int ms, int ticks = -1);
+	int setVolume(int volume) { return carrier_.setVolume(volume); }
+	int getVolume() { return carrier_.getVolume(); }
+	bool isPlaying() const { return carrier_.isPlaying(); }
+	bool isPlaying(int channel) const { return carrier_.isPlaying(channel); }
+
+	// the size of the compressed samples, in bytes
+	Uint32 getByteLength() const { return data_->blocks.size(); }
+	// what it'd be as an AudioChunk
+	Uint32 getDecodedLength() const
+	{
+		return data_->frames * data_->channels * sizeof(Sint16);
+	}
+
+	CompressedChunk(const CompressedChunk &that) = delete;
+	CompressedChunk(CompressedChunk &&that) = default;
+	// stops the channels playing it
+	~CompressedChunk() = default;
+	CompressedChunk & operator=(CompressedChunk that)
+	{
+		swap(*this, that);
+		return *this;
+	}
+	friend void swap(CompressedChunk &first,
+		CompressedChunk &second) noexcept
+	{
+		using std::swap;
+		swap(first.data_, second.data_);
+		swap(first.carrier_, second.carrier_);
+	}
+private:
+	static const int MAX_CHANNELS = 8;
+	// each channel's decoder state, at the start of each block
+	static const size_t HEADER_SIZE = 4; // Sint16 sample, Uint8 index, pad
+
+	struct Data {
+		int channels;
+		Uint32 frames;
+		size_t blockSize;
+		std::vector<Uint8> blocks;
+		std::vector<Uint8> silence; // the carrier's samples
+	};
+
+	// where a channel is in a sound; made when it's played, deleted when
+	// the effect's done
+	struct Voice {
+		const Data *data;
+		Uint32 frame;
+		int loops; // left after this time through
+		bool ended;
+		int sample[MAX_CHANNELS];
+		int index[MAX_CHANNELS];
+	};
+
+	static const Sint16 *steps()
+	{
+		static const Sint16 table[89] = {
+			7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+			34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+			130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371,
+			408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060,
+			1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749,
+			3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132,
+			7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818,
+			18500, 20350, 22385, 24623, 27086, 29794, 32767
+		};
+		return table;
+	}
+	// ADPCM's decoding step, shared by the encoder to stay in sync
+	static int decode(Uint8 nibble, int &sample, int &index)
+	{
+		static const int indexSteps[16] = {
+			-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+		};
+		int step = steps()[index];
+		int diff = step >> 3;
+		if(nibble & 4) {
+			diff += step;
+		}
+		if(nibble & 2) {
+			diff += step >> 1;
+		}
+		if(nibble & 1) {
+			diff += step >> 2;
+		}
+		sample += nibble & 8 ? -diff : diff;
+		sample = std::max(-32768, std::min(sample, 32767));
+		index = std::max(0, std::min(index + indexSteps[nibble], 88));
+		return sample;
+	}
+	static Uint8 encode(int target, int &sample, int &index);
+	static Data * compress(const Mix_Chunk &chunk);
+
+	// the carrier's loops and ticks for a sound's
+	int carrierLoops(int loops) const;
+	int carrierTicks(int loops, int ticks) const;
+	// registers the decoding effect on channel, or halts it
+	int attach(int channel, int loops);
+	static void effect(int channel, void *stream, int len, void *udata);
+	static void done(int, void *udata) { delete static_cast<Voice*>(udata); }
+	static void startBlock(Voice &voice);
+
+	// declared first, so it's destroyed after the carrier, which halts the
+	// channels decoding it when it's freed
+	std::unique_ptr<Data> data_;
+	AudioChunk carrier_;
+};
+
+CompressedChunk::CompressedChunk(const AudioChunk &chunk)
+	: data_{compress(*chunk.chunk_)},
+	// QuickLoad_RAW doesn't copy the samples, so they're kept in data_
+	carrier_{data_->silence.data(),
+		static_cast<Uint32>(data_->silence.size())}
+{
+	carrier_.setVolume(chunk.chunk_->volume);
+}
+
+CompressedChunk::Data * CompressedChunk::compress(const Mix_Chunk &chunk)
+{
+	int frequency, channels;
+	Uint16 format;
+	if(Mix_QuerySpec(&frequency, &format, &channels) == 0) {
+		throw std::runtime_error("Compressing audio chunk failed: "
+			"audio isn't open");
+	}
+	if(format != AUDIO_S16SYS || channels > MAX_CHANNELS) {
+		throw std::runtime_error("Compressing audio chunk failed: the "
+			"mixer's format must be AUDIO_S16SYS");
+	}
+	std::unique_ptr<Data> compressed{new Data()};
+	Data &data = *compressed;
+	data.channels = channels;
+	data.frames = chunk.alen / (channels * sizeof(Sint16));
+	data.blockSize = channels * HEADER_SIZE
+		+ (BLOCK_FRAMES * channels + 1) / 2;
+	Uint32 blockCount = (data.frames + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+	data.blocks.assign(blockCount * data.blockSize, 0);
+
+	const Sint16 *samples = reinterpret_cast<const Sint16*>(
+		chunk.abuf);
+	int sample[MAX_CHANNELS] = {};
+	int index[MAX_CHANNELS] = {};
+	for(Uint32 block = 0; block < blockCount; ++block) {
+		Uint8 *header = &data.blocks[block * data.blockSize];
+		Uint8 *nibbles = header + channels * HEADER_SIZE;
+		Uint32 first = block * BLOCK_FRAMES;
+		// the first sample's stored as is, so blocks stand alone
+		for(int c = 0; c < channels; ++c) {
+			if(first < data.frames) {
+				sample[c] = samples[first * channels + c];
+			}
+			Sint16 start = static_cast<Sint16>(sample[c]);
+			std::memcpy(header + c * HEADER_SIZE, &start, sizeof(start));
+			header[c * HEADER_SIZE + 2] = static_cast<Uint8>(index[c]);
+		}
+		Uint32 count = std::min(first + BLOCK_FRAMES, data.frames) - first;
+		for(Uint32 f = 0; f < count; ++f) {
+			for(int c = 0; c < channels; ++c) {
+				size_t s = f * channels + c;
+				Uint8 nibble = encode(samples[(first + f) * channels + c],
+					sample[c], index[c]);
+				nibbles[s / 2] |= nibble << (s % 2 * 4);
+			}
+		}
+	}
+
+	data.silence.assign(BLOCK_FRAMES * channels * sizeof(Sint16), 0);
+	return compressed.release();
+}
+
+Uint8 CompressedChunk::encode(int target, int &sample, int &index)
+{
+	int diff = target - sample;
+	Uint8 nibble = 0;
+	if(diff < 0) {
+		nibble = 8;
+		diff = -diff;
+	}
+	int step = steps()[index];
+	if(diff >= step) {
+		nibble |= 4;
+		diff -= step;
+	}
+	step >>= 1;
+	if(diff >= step) {
+		nibble |= 2;
+		diff -= step;
+	}
+	step >>= 1;
+	if(diff >= step) {
+		nibble |= 1;
+	}
+	decode(nibble, sample, index);
+	return nibble;
+}
+
+int CompressedChunk::play(int channel, int loops, int ticks)
+{
+	// locked, so none of the carrier's silence is mixed undecoded
+	SDL_LockAudio();
+	channel = carrier_.play(channel, carrierLoops(loops),
+		carrierTicks(loops, ticks));
+	channel = attach(channel, loops);
+	SDL_UnlockAudio();
+	return channel;
+}
+
+int CompressedChunk::fadeIn(int channel, int loops, int ms, int ticks)
+{
+	SDL_LockAudio();
+	channel = carrier_.fadeIn(channel, carrierLoops(loops), ms,
+		carrierTicks(loops, ticks));
+	channel = attach(channel, loops);
+	SDL_UnlockAudio();
+	return channel;
+}
+
+int CompressedChunk::carrierLoops(int loops) const
+{
+	if(loops < 0) {
+		return -1;
+	}
+	Uint64 perTime = (data_->frames + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+	Uint64 total = std::max<Uint64>(perTime * (loops + 1), 1);
+	return static_cast<int>(std::min<Uint64>(total - 1,
+		std::numeric_limits<int>::max()));
+}
+
+int CompressedChunk::carrierTicks(int loops, int ticks) const
+{
+	if(loops < 0) {
+		return ticks;
+	}
+	int frequency;
+	Mix_QuerySpec(&frequency, NULL, NULL);
+	// rounded up, so the end isn't cut
+	Uint64 frames = static_cast<Uint64>(data_->frames) * (loops + 1);
+	Uint64 ms = (frames * 1000 + frequency - 1) / frequency + 1;
+	ms = std::min<Uint64>(ms, std::numeric_limits<int>::max());
+	return ticks < 0 ? static_cast<int>(ms)
+		: std::min(ticks, static_cast<int>(ms));
+}
+
+int CompressedChunk::attach(int channel, int loops)
+{
+	if(channel < 0) {
+		return channel;
+	}
+	Voice *voice = new Voice();
+	voice->data = data_.get();
+	voice->frame = 0;
+	voice->loops = loops;
+	voice->ended = data_->frames == 0;
+	if(!Mix_RegisterEffect(channel, effect, done, voice)) {
+		delete voice;
+		Mix_HaltChannel(channel);
+		return -1;
+	}
+	return channel;
+}
+
+void CompressedChunk::startBlock(Voice &voice)
+{
+	const Data &data = *voice.data;
+	const Uint8 *header = &data.blocks[voice.frame / BLOCK_FRAMES
+		* data.blockSize];
+	for(int c = 0; c < data.channels; ++c) {
+		Sint16 start;
+		std::memcpy(&start, header + c * HEADER_SIZE, sizeof(start));
+		voice.sample[c] = start;
+		voice.index[c] = header[c * HEADER_SIZE + 2];
+	}
+}
+
+void CompressedChunk::effect(int, void *stream, int len, void *udata)
+{
+	Voice &voice = *static_cast<Voice*>(udata);
+	const Data &data = *voice.data;
+	const int channels = data.channels;
+	Sint16 *out = static_cast<Sint16*>(stream);
+	int frames = len / (channels * sizeof(Sint16));
+	while(frames > 0 && !voice.ended) {
+		Uint32 inBlock = voice.frame % BLOCK_FRAMES;
+		if(inBlock == 0) {
+			startBlock(voice);
+		}
+		// to the end of the block or the sound, whichever's first
+		Uint32 n = std::min<Uint32>(frames, std::min(
+			BLOCK_FRAMES - inBlock, data.frames - voice.frame));
+		const Uint8 *nibbles = &data.blocks[voice.frame / BLOCK_FRAMES
+			* data.blockSize] + channels * HEADER_SIZE;
+		size_t s = inBlock * channels;
+		for(Uint32 f = 0; f < n; ++f) {
+			for(int c = 0; c < channels; ++c, ++s) {
+				Uint8 nibble = nibbles[s / 2] >> (s % 2 * 4) & 15;
+				*out++ = static_cast<Sint16>(
+					decode(nibble, voice.sample[c], voice.index[c]));
+			}
+		}
+		frames -= n;
+		voice.frame += n;
+		if(voice.frame == data.frames) {
+			voice.frame = 0;
+			if(voice.loops == 0) {
+				voice.ended = true;
+			} else if(voice.loops > 0) {
+				--voice.loops;
+			}
+		}
+	}
+	// the carrier's silence is left as is after the end
+}
+
+} // namespace SDL
+
+#endif // SCC_COMPRESSEDCHUNK_HPP
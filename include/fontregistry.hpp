@@ -0,0 +1,216 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_FONTREGISTRY_HPP
+#define SCC_FONTREGISTRY_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <SDL.h>
+#include "null.hpp"
+#include "rwops.hpp"
+#include "truetypefont.hpp"
+
+#ifndef HAVE_SDL_TTF
+# error "can't use FontRegistry without SDL_ttf"
+#endif
+
+namespace SDL {
+
+// Hands out shared TrueTypeFonts by path and size, reading each font file
+// into memory once, however many sizes it's opened at. Each size is opened
+// from that memory (through a const memory RWops of its own), the first
+// time it's asked for.
+//
+// Notes:
+// - a size is opened while some handle to it exists, and closed with the
+//   last one; asking for it again afterwards opens it again, but doesn't
+//   read the file again
+// - a font keeps the memory it's opened from, so handles stay good even
+//   after trim() or the registry are gone
+// - SDL_ttf can't share a face between sizes, so each size still parses
+//   its own tables; what's saved is the reading and the copies of the file
+// - like SDL_ttf, it isn't thread-safe
+class FontRegistry {
+public:
+	using Handle = std::shared_ptr<TrueTypeFont>;
+
+	FontRegistry() = default;
+
+	// Opens path at size, unless it's open already. Throws
+	// std::runtime_error if the file can't be read or opened as a font.
+	Handle get(const std::string &path, int size);
+	// Reads path into memory now, so the first get() doesn't have to.
+	// Throws like get().
+	void preload(const std::string &path);
+
+	// whether path has been read
+	bool contains(const std::string &path) const;
+	// the files read, and the sizes open out of them
+	size_t getFileCount() const { return files_.size(); }
+	size_t getFontCount() const;
+	// the bytes of the files read
+	Uint64 getBytes() const;
+
+	// forgets the files no open font was opened from
+	void trim();
+
+	FontRegistry(const FontRegistry &that) = delete;
+	FontRegistry & operator=(const FontRegistry &that) = delete;
+private:
+	typedef std::vector<Uint8> Bytes;
+
+	struct File {
+		std::shared_ptr<const Bytes> bytes;
+		std::unordered_map<int, std::weak_ptr<TrueTypeFont>> fonts;
+	};
+
+	// what a Handle points into: the font, and the memory it reads from
+	struct Instance {
+		Instance(std::shared_ptr<const Bytes> bytes, int size)
+			: bytes(std::move(bytes)),
+			font(RWops(this->bytes->data(), int(this->bytes->size())),
+				size)
+		{}
+
+		std::shared_ptr<const Bytes> bytes; // before font, which reads it
+		TrueTypeFont font;
+	};
+
+	File &fileOf(const std::string &path);
+	static std::shared_ptr<const Bytes> readAll(const std::string &path);
+
+	std::unordered_map<std::string, File> files_;
+};
+
+FontRegistry::Handle FontRegistry::get(const std::string &path, int size)
+{
+	File &file = fileOf(path);
+	std::weak_ptr<TrueTypeFont> &open = file.fonts[size];
+	Handle font = open.lock();
+	if(font) {
+		return font;
+	}
+	auto instance = std::make_shared<Instance>(file.bytes, size);
+	font = Handle(instance, &instance->font);
+	open = font;
+	return font;
+}
+
+void FontRegistry::preload(const std::string &path)
+{
+	fileOf(path);
+}
+
+bool FontRegistry::contains(const std::string &path) const
+{
+	return files_.find(path) != files_.end();
+}
+
+size_t FontRegistry::getFontCount() const
+{
+	size_t count = 0;
+	for(const auto &file : files_) {
+		for(const auto &font : file.second.fonts) {
+			if(!font.second.expired()) {
+				++count;
+			}
+		}
+	}
+	return count;
+}
+
+Uint64 FontRegistry::getBytes() const
+{
+	Uint64 bytes = 0;
+	for(const auto &file : files_) {
+		bytes += file.second.bytes->size();
+	}
+	return bytes;
+}
+
+void FontRegistry::trim()
+{
+	for(auto file = files_.begin(); file != files_.end(); ) {
+		auto &fonts = file->second.fonts;
+		for(auto font = fonts.begin(); font != fonts.end(); ) {
+			if(font->second.expired()) {
+				font = fonts.erase(font);
+			} else {
+				++font;
+			}
+		}
+		if(fonts.empty()) {
+			file = files_.erase(file);
+		} else {
+			++file;
+		}
+	}
+}
+
+FontRegistry::File &FontRegistry::fileOf(const std::string &path)
+{
+	auto found = files_.find(path);
+	if(found != files_.end()) {
+		return found->second;
+	}
+	// read before inserting, so a failure leaves nothing behind
+	File file{readAll(path), {}};
+	return files_.emplace(path, std::move(file)).first->second;
+}
+
+std::shared_ptr<const FontRegistry::Bytes> FontRegistry::readAll(
+	const std::string &path)
+{
+	RWops rwops(path.c_str(), "rb");
+	// the size isn't always known, so until the end
+	const size_t CHUNK_SIZE = 64 * 1024;
+	auto bytes = std::make_shared<Bytes>();
+	Sint64 size = rwops.size();
+	bytes->reserve(size > 0 ? size_t(size) : CHUNK_SIZE);
+	size_t count;
+	do {
+		size_t old = bytes->size();
+		bytes->resize(old + CHUNK_SIZE);
+		count = rwops.read(&(*bytes)[old], 1, CHUNK_SIZE);
+		bytes->resize(old + count);
+	} while(count > 0);
+	if(bytes->empty()) {
+		throw std::runtime_error("Loading font failed: " + path
+			+ " is empty");
+	}
+	// RWops' const memory ctor takes an int
+	if(bytes->size() > size_t(std::numeric_limits<int>::max())) {
+		throw std::runtime_error("Loading font failed: " + path
+			+ " is too big");
+	}
+	bytes->shrink_to_fit();
+	return bytes;
+}
+
+} // namespace SDL
+
+#endif // SCC_FONTREGISTRY_HPP
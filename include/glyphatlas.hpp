@@ -0,0 +1,269 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_GLYPHATLAS_HPP
+#define SCC_GLYPHATLAS_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <stdexcept>
+#include "null.hpp"
+#include "texture.hpp"
+#include "truetypefont.hpp"
+#include "utf8.hpp"
+
+#ifndef HAVE_SDL_TTF
+# error "can't use GlyphAtlas without SDL_ttf"
+#endif
+
+namespace SDL {
+
+// Draws text a glyph at a time, from textures each glyph's rasterized into
+// once (the atlas's pages), rather than rasterizing and uploading the whole
+// string every time it changes. Once the glyphs are in, drawing allocates
+// nothing: it's a lookup and an SDL_RenderCopy() per glyph, which SDL's
+// renderers batch.
+//
+// Notes:
+// - it's for one font and one renderer. Renderer::drawText() keeps one
+//   per font for you.
+// - glyphs are rasterized white (blended) and tinted when drawn, so one
+//   atlas does for every color
+// - text is drawn on one line, glyph after glyph by their advances and
+//   kerning. Code points past U+FFFF are drawn as U+FFFD, since SDL_ttf
+//   only has metrics for those up to it.
+// - the font's style and size must not change once glyphs are in
+class GlyphAtlas {
+public:
+	static const int DEFAULT_PAGE_SIZE = 512;
+
+	explicit GlyphAtlas(SDL_Renderer *renderer, const TrueTypeFont &font,
+		int pageSize = DEFAULT_PAGE_SIZE);
+
+	// Draws utf8 with its top-left at (x, y). font must be the one it was
+	// made for. Returns false if a glyph couldn't be drawn (the rest
+	// are).
+	bool draw(TrueTypeFont &font, const char *utf8, int x, int y,
+		SDL_Color color);
+	// how far draw() would move along, in pixels
+	int measure(TrueTypeFont &font, const char *utf8);
+
+	size_t getGlyphCount() const { return glyphs_.size(); }
+	int getPageCount() const { return static_cast<int>(pages_.size()); }
+	// false once the font it was made for is gone
+	bool isFontAlive() const { return !font_.expired(); }
+
+	GlyphAtlas(const GlyphAtlas &that) = delete;
+	GlyphAtlas & operator=(const GlyphAtlas &that) = delete;
+private:
+	// between glyphs, so they don't bleed into each other when scaled
+	static const int PADDING = 1;
+
+	struct Glyph {
+		int page;
+		SDL_Rect rect; // empty for blanks
+		int advance;
+	};
+
+	// adds it if it isn't in yet. NULL on error.
+	const Glyph *find(TrueTypeFont &font, Uint16 glyph);
+	bool add(TrueTypeFont &font, Uint16 glyph, Glyph &out);
+	bool checkFont(const TrueTypeFont &font) const;
+
+	SDL_Renderer *renderer_;
+	Uint64 fontId_;
+	std::weak_ptr<const void> font_;
+	int pageSize_;
+	std::vector<Texture> pages_;
+	// where the next glyph goes, in the last page: glyphs are packed in
+	// rows (shelves) as tall as the tallest in them
+	int penX_, penY_, shelfHeight_;
+	std::unordered_map<Uint16, Glyph> glyphs_;
+};
+
+GlyphAtlas::GlyphAtlas(SDL_Renderer *renderer, const TrueTypeFont &font,
+	int pageSize)
+	: renderer_{renderer}, fontId_{font.getId()},
+	font_{font.getLifetime()}, pageSize_{pageSize},
+	penX_{0}, penY_{0}, shelfHeight_{0}
+{}
+
+bool GlyphAtlas::draw(TrueTypeFont &font, const char *utf8, int x, int y,
+	SDL_Color color)
+{
+	if(!checkFont(font)) {
+		return false;
+	}
+	for(Texture &page : pages_) {
+		page.setColorMod(color.r, color.g, color.b);
+		page.setAlphaMod(color.a);
+	}
+	bool drawn = true;
+	Uint16 previous = 0;
+	for(Uint32 codepoint; (codepoint = UTF8::next(utf8)) != 0; ) {
+		Uint16 glyph = codepoint > 0xFFFF ? UTF8::REPLACEMENT : codepoint;
+		size_t pages = pages_.size();
+		const Glyph *found = find(font, glyph);
+		if(found == NULL) {
+			drawn = false;
+			continue;
+		}
+		if(pages_.size() != pages) {
+			// a new page, not tinted yet
+			pages_.back().setColorMod(color.r, color.g, color.b);
+			pages_.back().setAlphaMod(color.a);
+		}
+		if(previous != 0) {
+			x += font.getKerning(previous, glyph);
+		}
+		if(found->rect.w > 0) {
+			SDL_Rect dest{x, y, found->rect.w, found->rect.h};
+			if(SDL_RenderCopy(renderer_,
+				pages_[found->page].texture_.get(), &found->rect,
+				&dest) < 0)
+			{
+				drawn = false;
+			}
+		}
+		x += found->advance;
+		previous = glyph;
+	}
+	return drawn;
+}
+
+int GlyphAtlas::measure(TrueTypeFont &font, const char *utf8)
+{
+	if(!checkFont(font)) {
+		return 0;
+	}
+	int width = 0;
+	Uint16 previous = 0;
+	for(Uint32 codepoint; (codepoint = UTF8::next(utf8)) != 0; ) {
+		Uint16 glyph = codepoint > 0xFFFF ? UTF8::REPLACEMENT : codepoint;
+		const Glyph *found = find(font, glyph);
+		if(found == NULL) {
+			continue;
+		}
+		if(previous != 0) {
+			width += font.getKerning(previous, glyph);
+		}
+		width += found->advance;
+		previous = glyph;
+	}
+	return width;
+}
+
+const GlyphAtlas::Glyph *GlyphAtlas::find(TrueTypeFont &font, Uint16 glyph)
+{
+	auto found = glyphs_.find(glyph);
+	if(found != glyphs_.end()) {
+		return &found->second;
+	}
+	Glyph added;
+	if(!add(font, glyph, added)) {
+		return NULL;
+	}
+	return &glyphs_.insert({glyph, added}).first->second;
+}
+
+bool GlyphAtlas::add(TrueTypeFont &font, Uint16 glyph, Glyph &out)
+{
+	if(!font.getGlyphMetrics(glyph, NULL, NULL, NULL, NULL,
+		&out.advance))
+	{
+		return false;
+	}
+	out.page = 0;
+	out.rect = SDL_Rect{0, 0, 0, 0};
+
+	// rendered as a string of one, so it's placed as it'd be in one
+	char text[5];
+	text[UTF8::encode(glyph, text)] = '\0';
+	std::unique_ptr<SDL_Surface, Surface::Deleter> surface{
+		TTF_RenderUTF8_Blended(font.font_.get(), text,
+			SDL_Color{255, 255, 255, 255})};
+	if(!surface) {
+		// nothing to render (blanks, in some versions): just an advance
+		return true;
+	}
+	if(surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+		surface.reset(SDL_ConvertSurfaceFormat(surface.get(),
+			SDL_PIXELFORMAT_ARGB8888, 0));
+		if(!surface) {
+			return false;
+		}
+	}
+	int w = surface->w, h = surface->h;
+	if(w + PADDING > pageSize_ || h + PADDING > pageSize_) {
+		SDL_SetError("GlyphAtlas: glyph is bigger than a page");
+		return false;
+	}
+
+	if(penX_ + w + PADDING > pageSize_) {
+		// the next shelf
+		penX_ = 0;
+		penY_ += shelfHeight_;
+		shelfHeight_ = 0;
+	}
+	if(pages_.empty() || penY_ + h + PADDING > pageSize_) {
+		try {
+			pages_.push_back(Texture(renderer_, SDL_PIXELFORMAT_ARGB8888,
+				SDL_TEXTUREACCESS_STATIC, pageSize_, pageSize_));
+		} catch(const std::runtime_error &) {
+			// SDL_CreateTexture() set the error
+			return false;
+		}
+		pages_.back().setBlendMode(SDL_BLENDMODE_BLEND);
+		// static textures start out undefined, and the padding between
+		// glyphs must be see-through
+		std::vector<Uint32> blank(pageSize_ * pageSize_, 0);
+		if(!pages_.back().update(NULL, blank.data(),
+			pageSize_ * sizeof(Uint32)))
+		{
+			pages_.pop_back();
+			return false;
+		}
+		penX_ = penY_ = shelfHeight_ = 0;
+	}
+	SDL_Rect rect{penX_, penY_, w, h};
+	if(!pages_.back().update(&rect, surface->pixels, surface->pitch)) {
+		return false;
+	}
+	penX_ += w + PADDING;
+	shelfHeight_ = std::max(shelfHeight_, h + PADDING);
+	out.page = static_cast<int>(pages_.size()) - 1;
+	out.rect = rect;
+	return true;
+}
+
+bool GlyphAtlas::checkFont(const TrueTypeFont &font) const
+{
+	if(font.getId() != fontId_) {
+		SDL_SetError("GlyphAtlas: not the font it was made for");
+		return false;
+	}
+	return true;
+}
+
+} // namespace SDL
+
+#endif // SCC_GLYPHATLAS_HPP
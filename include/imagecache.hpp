@@ -0,0 +1,413 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_IMAGECACHE_HPP
+#define SCC_IMAGECACHE_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <SDL.h>
+#include "null.hpp"
+#include "rwops.hpp"
+
+#ifndef HAVE_SDL_IMAGE
+# error "cannot use ImageCache class without SDL_image"
+#endif
+
+#if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
+# define SCC_HAVE_MMAP
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+namespace SDL {
+
+// A cache of decoded images on disk, so that loading the same PNG or JPEG
+// again (eg on the next launch) is a copy instead of a decode. Decoded
+// pixels are stored already converted to the format they're wanted in, so
+// there's no conversion either.
+//
+// Use it through Surface::fromImage(image, cache) or
+// Renderer::makeTexture(image, cache); textures are cached in the first of
+// the renderer's texture formats, which is its fastest one.
+//
+// Notes:
+// - images are keyed by a hash of their encoded bytes (FNV-1a, 64 bits)
+//   and the pixel format, so an image that changes is decoded again, and
+//   the old entry is simply never used again
+// - each entry is a file in directory, which must exist. Entries are
+//   written to a temporary file which is then renamed, so a crash never
+//   leaves a broken entry behind, and several processes can share the
+//   directory.
+// - files are memory mapped where possible (on unix), and read otherwise
+// - the files are only meant for the machine that wrote them (the pixels
+//   are in its byte order). Those of other machines, or of other versions
+//   of this class, are treated as misses and overwritten.
+// - the encoded image is read whole even on a hit, to be hashed
+// - failing to write an entry isn't an error; the image just isn't cached
+// - it may be used from several threads at once
+class ImageCache {
+public:
+	static const Uint32 VERSION = 1;
+
+	explicit ImageCache(std::string directory);
+
+	// Both return NULL on failure, and SDL_GetError() tells why. Meant
+	// for Surface and Texture; prefer their ctors, which throw instead.
+	// The Surface is in format; the Texture is static, and blended if
+	// its format has alpha.
+	SDL_Surface *loadSurface(const RWops &image, Uint32 format);
+	SDL_Texture *loadTexture(SDL_Renderer *renderer, const RWops &image);
+
+	Uint64 getHits() const { return hits_; }
+	Uint64 getMisses() const { return misses_; }
+
+	ImageCache(const ImageCache &that) = delete;
+	ImageCache & operator=(const ImageCache &that) = delete;
+private:
+	static const Uint32 MAGIC = 0x49434353; // "SCCI", in this byte order
+
+	// the start of each file, in this machine's byte order; the pixels
+	// follow right after
+	struct Header {
+		Uint32 magic;
+		Uint32 version;
+		Uint64 hash;
+		Uint32 format;
+		Uint32 width;
+		Uint32 height;
+		Uint32 pitch;
+	};
+
+	struct Pixels {
+		Uint32 format;
+		int width;
+		int height;
+		int pitch;
+		const void *data;
+	};
+
+	// a read-only view of a whole file
+	class Mapping {
+	public:
+		explicit Mapping(const std::string &path);
+		~Mapping();
+
+		const Uint8 *data() const { return data_; }
+		size_t size() const { return size_; }
+
+		Mapping(const Mapping &that) = delete;
+		Mapping & operator=(const Mapping &that) = delete;
+	private:
+		const Uint8 *data_;
+		size_t size_;
+#ifdef SCC_HAVE_MMAP
+		void *map_;
+#endif
+		std::vector<Uint8> buffer_; // where there's no mmap
+	};
+
+	// Calls use(pixels) with image's pixels in format, from the cache if
+	// they're there, else decoded (and then cached). Returns what use()
+	// returned, or NULL if the image couldn't be decoded.
+	template <typename T, typename F>
+	T *withPixels(const RWops &image, Uint32 format, F use);
+
+	static bool readAll(const RWops &image, std::vector<Uint8> &bytes);
+	static Uint64 hash(const std::vector<Uint8> &bytes);
+	static bool isValid(const Mapping &mapping, Uint64 hash, Uint32 format);
+	std::string pathOf(Uint64 hash, Uint32 format) const;
+	bool store(const std::string &path, Uint64 hash,
+		const SDL_Surface *surface) const;
+
+	std::string directory_;
+	std::atomic<Uint64> hits_;
+	std::atomic<Uint64> misses_;
+};
+
+ImageCache::ImageCache(std::string directory)
+	: directory_(std::move(directory)), hits_{0}, misses_{0}
+{
+	if(!directory_.empty() && directory_.back() != '/'
+		&& directory_.back() != '\\')
+	{
+		directory_ += '/';
+	}
+}
+
+SDL_Surface *ImageCache::loadSurface(const RWops &image, Uint32 format)
+{
+	return withPixels<SDL_Surface>(image, format,
+		[](const Pixels &pixels) -> SDL_Surface*
+		{
+			int bpp;
+			Uint32 r, g, b, a;
+			if(!SDL_PixelFormatEnumToMasks(pixels.format, &bpp,
+				&r, &g, &b, &a))
+			{
+				return NULL;
+			}
+			SDL_Surface *surface = SDL_CreateRGBSurface(0,
+				pixels.width, pixels.height, bpp, r, g, b, a);
+			if(surface == NULL) {
+				return NULL;
+			}
+			// the pitches may differ, so row by row
+			size_t rowSize = pixels.width
+				* SDL_BYTESPERPIXEL(pixels.format);
+			for(int y = 0; y < pixels.height; ++y) {
+				std::memcpy(
+					static_cast<Uint8*>(surface->pixels)
+						+ y * surface->pitch,
+					static_cast<const Uint8*>(pixels.data)
+						+ y * pixels.pitch,
+					rowSize);
+			}
+			return surface;
+		});
+}
+
+SDL_Texture *ImageCache::loadTexture(SDL_Renderer *renderer,
+	const RWops &image)
+{
+	SDL_RendererInfo info;
+	if(SDL_GetRendererInfo(renderer, &info) < 0) {
+		return NULL;
+	}
+	// the first one is the renderer's favourite. YUV formats can't hold
+	// images, though.
+	Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+	if(info.num_texture_formats > 0
+		&& !SDL_ISPIXELFORMAT_FOURCC(info.texture_formats[0]))
+	{
+		format = info.texture_formats[0];
+	}
+	return withPixels<SDL_Texture>(image, format,
+		[renderer](const Pixels &pixels) -> SDL_Texture*
+		{
+			SDL_Texture *texture = SDL_CreateTexture(renderer,
+				pixels.format, SDL_TEXTUREACCESS_STATIC,
+				pixels.width, pixels.height);
+			if(texture == NULL) {
+				return NULL;
+			}
+			if(SDL_UpdateTexture(texture, NULL, pixels.data,
+				pixels.pitch) < 0)
+			{
+				SDL_DestroyTexture(texture);
+				return NULL;
+			}
+			// like SDL_CreateTextureFromSurface() does
+			if(SDL_ISPIXELFORMAT_ALPHA(pixels.format)) {
+				SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+			}
+			return texture;
+		});
+}
+
+template <typename T, typename F>
+T *ImageCache::withPixels(const RWops &image, Uint32 format, F use)
+{
+	std::vector<Uint8> encoded;
+	if(!readAll(image, encoded)) {
+		return NULL;
+	}
+	Uint64 key = hash(encoded);
+	std::string path = pathOf(key, format);
+
+	{
+		Mapping mapping(path);
+		if(isValid(mapping, key, format)) {
+			++hits_;
+			Header header;
+			std::memcpy(&header, mapping.data(), sizeof(header));
+			Pixels pixels{format, int(header.width), int(header.height),
+				int(header.pitch), mapping.data() + sizeof(header)};
+			return use(pixels);
+		}
+	}
+
+	++misses_;
+	SDL_RWops *rwops = SDL_RWFromConstMem(encoded.data(), encoded.size());
+	if(rwops == NULL) {
+		return NULL;
+	}
+	SDL_Surface *decoded = IMG_Load_RW(rwops, 1);
+	if(decoded == NULL) {
+		return NULL;
+	}
+	SDL_Surface *converted = SDL_ConvertSurfaceFormat(decoded, format, 0);
+	SDL_FreeSurface(decoded);
+	if(converted == NULL) {
+		return NULL;
+	}
+	store(path, key, converted);
+	// converted isn't RLE-encoded, so it needn't be locked
+	Pixels pixels{format, converted->w, converted->h, converted->pitch,
+		converted->pixels};
+	T *result = use(pixels);
+	SDL_FreeSurface(converted);
+	return result;
+}
+
+bool ImageCache::readAll(const RWops &image, std::vector<Uint8> &bytes)
+{
+	// the size isn't always known, so until the end
+	const size_t CHUNK_SIZE = 64 * 1024;
+	Sint64 size = image.size() - image.tell();
+	bytes.reserve(size > 0 ? size_t(size) : CHUNK_SIZE);
+	size_t count;
+	do {
+		size_t old = bytes.size();
+		bytes.resize(old + CHUNK_SIZE);
+		count = image.read(&bytes[old], 1, CHUNK_SIZE);
+		bytes.resize(old + count);
+	} while(count > 0);
+	if(bytes.empty()) {
+		SDL_SetError("ImageCache: the image is empty");
+		return false;
+	}
+	return true;
+}
+
+Uint64 ImageCache::hash(const std::vector<Uint8> &bytes)
+{
+	Uint64 hash = 0xcbf29ce484222325ULL; // FNV-1a's offset basis
+	for(Uint8 byte : bytes) {
+		hash ^= byte;
+		hash *= 0x100000001b3ULL; // and its prime
+	}
+	return hash;
+}
+
+bool ImageCache::isValid(const Mapping &mapping, Uint64 hash, Uint32 format)
+{
+	Header header;
+	if(mapping.size() < sizeof(header)) {
+		return false;
+	}
+	std::memcpy(&header, mapping.data(), sizeof(header));
+	Uint32 bytesPerPixel = SDL_BYTESPERPIXEL(format);
+	// a truncated file (say, the disk was full) is a miss too
+	return header.magic == MAGIC && header.version == VERSION
+		&& header.hash == hash && header.format == format
+		&& bytesPerPixel > 0 && header.width > 0 && header.height > 0
+		&& header.width <= header.pitch / bytesPerPixel
+		&& (mapping.size() - sizeof(header)) / header.pitch
+			>= header.height;
+}
+
+std::string ImageCache::pathOf(Uint64 hash, Uint32 format) const
+{
+	char name[64];
+	std::snprintf(name, sizeof(name), "%016llx-%08x.pixels",
+		static_cast<unsigned long long>(hash),
+		static_cast<unsigned>(format));
+	return directory_ + name;
+}
+
+bool ImageCache::store(const std::string &path, Uint64 hash,
+	const SDL_Surface *surface) const
+{
+	// unique among threads and processes, so they don't write the same
+	// temporary file
+	char suffix[64];
+	std::snprintf(suffix, sizeof(suffix), ".%llx-%p.tmp",
+		static_cast<unsigned long long>(SDL_GetPerformanceCounter()),
+		static_cast<const void*>(&suffix));
+	std::string temporary = path + suffix;
+	SDL_RWops *file = SDL_RWFromFile(temporary.c_str(), "wb");
+	if(file == NULL) {
+		return false;
+	}
+	Header header{MAGIC, VERSION, hash, surface->format->format,
+		Uint32(surface->w), Uint32(surface->h), Uint32(surface->pitch)};
+	size_t pixelBytes = size_t(surface->h) * surface->pitch;
+	bool ok = SDL_RWwrite(file, &header, sizeof(header), 1) == 1
+		&& SDL_RWwrite(file, surface->pixels, 1, pixelBytes)
+			== pixelBytes;
+	ok = SDL_RWclose(file) == 0 && ok;
+	// rename() replaces path atomically where it exists (on unix);
+	// elsewhere it fails if another process got there first, which is
+	// fine too
+	if(!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+		std::remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+ImageCache::Mapping::Mapping(const std::string &path)
+	: data_{NULL}, size_{0}
+#ifdef SCC_HAVE_MMAP
+	, map_{MAP_FAILED}
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0) {
+		return;
+	}
+	struct stat status;
+	if(fstat(fd, &status) == 0 && status.st_size > 0) {
+		map_ = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(map_ != MAP_FAILED) {
+			data_ = static_cast<const Uint8*>(map_);
+			size_ = status.st_size;
+		}
+	}
+	close(fd); // the mapping stays
+}
+#else
+{
+	SDL_RWops *file = SDL_RWFromFile(path.c_str(), "rb");
+	if(file == NULL) {
+		return;
+	}
+	Sint64 size = SDL_RWsize(file);
+	if(size > 0) {
+		buffer_.resize(size_t(size));
+		if(SDL_RWread(file, buffer_.data(), 1, buffer_.size())
+			== buffer_.size())
+		{
+			data_ = buffer_.data();
+			size_ = buffer_.size();
+		}
+	}
+	SDL_RWclose(file);
+}
+#endif
+
+ImageCache::Mapping::~Mapping()
+{
+#ifdef SCC_HAVE_MMAP
+	if(map_ != MAP_FAILED) {
+		munmap(map_, size_);
+	}
+#endif
+}
+
+} // namespace SDL
+
+#endif // SCC_IMAGECACHE_HPP
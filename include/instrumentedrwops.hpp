@@ -0,0 +1,132 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_INSTRUMENTEDRWOPS_HPP
+#define SCC_INSTRUMENTEDRWOPS_HPP
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <SDL.h>
+#include "null.hpp"
+#include "rwops.hpp"
+#include "iostats.hpp"
+
+namespace SDL {
+
+// A RWops that forwards everything to another one (which it owns), counting
+// the bytes, the calls and the time spent in them. The counts are added to
+// IOStats' totals, under name, when this is destroyed; unlike loads through
+// FromRWops, that happens even if IOStats is disabled.
+//
+// For things that read from a RWops over time (eg a streamed Music or a
+// ChunkedRWops' container), rather than all at once.
+class InstrumentedRWops : public RWops {
+public:
+	// an empty name means source's. Either way, this gets that name.
+	explicit InstrumentedRWops(RWops source,
+		std::string name = std::string());
+
+	InstrumentedRWops(const InstrumentedRWops &that) = delete;
+	InstrumentedRWops(InstrumentedRWops &&that) = default;
+	~InstrumentedRWops() = default;
+	InstrumentedRWops & operator=(InstrumentedRWops that)
+	{
+		swap(*this, that);
+		return *this;
+	}
+	friend void swap(InstrumentedRWops &first,
+		InstrumentedRWops &second) noexcept
+	{
+		using std::swap;
+		swap(static_cast<RWops&>(first), static_cast<RWops&>(second));
+	}
+
+private:
+	// what's adapted into the RWops
+	class Stream {
+	public:
+		Stream(RWops source, std::string name)
+			: name_(name.empty() ? source.getName() : std::move(name)),
+			span_(name_), source_(std::move(source))
+		{}
+
+		const std::string &name() const { return name_; }
+
+		Sint64 size();
+		Sint64 seek(Sint64 offset, int whence);
+		size_t read(void *ptr, size_t size, size_t maxnum);
+		size_t write(const void *ptr, size_t size, size_t num);
+
+		Stream(const Stream &that) = delete;
+		Stream & operator=(const Stream &that) = delete;
+	private:
+		std::string name_;
+		// destroyed after source_, so closing it is counted too
+		IOStats::Span span_;
+		RWops source_;
+	};
+};
+
+InstrumentedRWops::InstrumentedRWops(RWops source, std::string name)
+	: RWops(RWops::adapt(std::unique_ptr<Stream>(
+		new Stream(std::move(source), std::move(name)))))
+{
+	setName(target<Stream>()->name());
+}
+
+Sint64 InstrumentedRWops::Stream::size()
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	Sint64 result = source_.size();
+	span_.countSeek(SDL_GetPerformanceCounter() - start);
+	return result;
+}
+
+Sint64 InstrumentedRWops::Stream::seek(Sint64 offset, int whence)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	Sint64 result = source_.seek(offset, whence);
+	span_.countSeek(SDL_GetPerformanceCounter() - start);
+	return result;
+}
+
+size_t InstrumentedRWops::Stream::read(void *ptr, size_t size,
+	size_t maxnum)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	size_t result = source_.read(ptr, size, maxnum);
+	span_.countRead(result * size, SDL_GetPerformanceCounter() - start);
+	return result;
+}
+
+size_t InstrumentedRWops::Stream::write(const void *ptr, size_t size,
+	size_t num)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	size_t result = source_.write(ptr, size, num);
+	span_.countWrite(result * size, SDL_GetPerformanceCounter() - start);
+	return result;
+}
+
+} // namespace SDL
+
+#endif // SCC_INSTRUMENTEDRWOPS_HPP
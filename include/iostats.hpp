@@ -0,0 +1,398 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_IOSTATS_HPP
+#define SCC_IOSTATS_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+#include <algorithm>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <SDL.h>
+#include "null.hpp"
+
+namespace SDL {
+
+// Adds up what's read from (and written to) RWops, per asset name, to find
+// out which assets make loading slow. Disabled by default; once enabled,
+// everything done through an InstrumentedRWops is counted under its name.
+// So is every load through FromRWops::load() (so every Surface, Texture
+// and AudioChunk loaded from a RWops), under the RWops' name, if
+// HAVE_IOSTATS is defined before rwops.hpp is included (scc.hpp defines it
+// along with HAVE_THREADS); without it, loads aren't even checked for being
+// counted.
+//
+// Music isn't counted: it goes on reading its RWops while it plays, long
+// after loading, so it's loaded through FromRWops::stream() instead. Give it
+// an InstrumentedRWops to count its reads.
+//
+// Notes:
+// - times are in SDL_GetPerformanceCounter() ticks (see toSeconds())
+// - ioTicks is the time spent inside read(), write() and seek(); totalTicks
+//   is the whole load (decoding included), or the InstrumentedRWops'
+//   lifetime. Their difference is what isn't I/O.
+// - each load or InstrumentedRWops is also kept as one event, for
+//   writeTrace(), up to MAX_EVENTS of them
+// - everything here is thread safe
+class IOStats {
+public:
+	static const size_t MAX_EVENTS = 100000;
+
+	struct Record {
+		Record() : count{0}, bytesRead{0}, bytesWritten{0}, reads{0},
+			writes{0}, seeks{0}, ioTicks{0}, totalTicks{0}
+		{}
+
+		std::string name;
+		Uint64 count; // how many loads (or RWops) this adds up
+		Uint64 bytesRead;
+		Uint64 bytesWritten;
+		Uint64 reads;
+		Uint64 writes;
+		Uint64 seeks;
+		Uint64 ioTicks;
+		Uint64 totalTicks;
+	};
+
+	static void setEnabled(bool enabled) { registry().enabled = enabled; }
+	static bool isEnabled() { return registry().enabled; }
+	// forgets everything counted so far
+	static void clear();
+
+	// the totals per name, slowest (by totalTicks) first
+	static std::vector<Record> totals();
+	static double toSeconds(Uint64 ticks)
+	{
+		return double(ticks) / SDL_GetPerformanceFrequency();
+	}
+
+	// The totals, one row (or object) per name
+	static void writeCsv(std::ostream &out);
+	static void writeJson(std::ostream &out);
+	// The events in Chrome's trace event format, for chrome://tracing or
+	// Perfetto
+	static void writeTrace(std::ostream &out);
+
+	// Counts one load (or RWops), and adds it to the totals when
+	// destroyed. What FromRWops and InstrumentedRWops use.
+	class Span {
+	public:
+		explicit Span(std::string name);
+		~Span();
+
+		// A SDL_RWops that calls rwops and counts the calls; valid
+		// while this is. Closing it doesn't close rwops. Returns rwops
+		// itself if it can't be made, so counting never breaks loading.
+		SDL_RWops *wrap(SDL_RWops *rwops);
+
+		// what wrap() does after each call, for other wrappers
+		void countRead(size_t bytes, Uint64 ticks);
+		void countWrite(size_t bytes, Uint64 ticks);
+		void countSeek(Uint64 ticks);
+
+		Span(const Span &that) = delete;
+		Span & operator=(const Span &that) = delete;
+	private:
+		struct Deleter {
+			void operator()(SDL_RWops *rwops) { SDL_FreeRW(rwops); }
+		};
+
+		static Span &self(SDL_RWops *rwops)
+		{
+			return *static_cast<Span*>(rwops->hidden.unknown.data2);
+		}
+		static SDL_RWops *target(SDL_RWops *rwops)
+		{
+			return static_cast<SDL_RWops*>(rwops->hidden.unknown.data1);
+		}
+		// the wrapper's callbacks
+		static Sint64 size(SDL_RWops *rwops);
+		static Sint64 seek(SDL_RWops *rwops, Sint64 offset, int whence);
+		static size_t read(SDL_RWops *rwops, void *ptr, size_t size,
+			size_t maxnum);
+		static size_t write(SDL_RWops *rwops, const void *ptr,
+			size_t size, size_t num);
+		static int close(SDL_RWops *) { return 0; }
+
+		Record record_;
+		Uint64 start_;
+		std::unique_ptr<SDL_RWops, Deleter> wrapper_;
+	};
+
+private:
+	struct Event {
+		std::string name;
+		Uint64 start;
+		Uint64 ticks;
+		Uint64 bytes;
+		int thread;
+	};
+
+	struct Registry {
+		Registry() : enabled{false}, epoch{SDL_GetPerformanceCounter()} {}
+
+		std::atomic<bool> enabled;
+		std::mutex mutex;
+		Uint64 epoch;
+		std::vector<Record> totals;
+		std::map<std::string, size_t> index; // name -> totals[i]
+		std::vector<Event> events;
+		// numbered in order of appearance, for the trace
+		std::map<std::thread::id, int> threads;
+	};
+
+	static Registry &registry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	static void add(const Record &record, Uint64 start);
+	static void writeString(std::ostream &out, const std::string &s);
+};
+
+void IOStats::clear()
+{
+	Registry &r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	r.totals.clear();
+	r.index.clear();
+	r.events.clear();
+	r.threads.clear();
+	r.epoch = SDL_GetPerformanceCounter();
+}
+
+std::vector<IOStats::Record> IOStats::totals()
+{
+	std::vector<Record> totals;
+	{
+		Registry &r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		totals = r.totals;
+	}
+	std::stable_sort(totals.begin(), totals.end(),
+		[](const Record &a, const Record &b) {
+			return a.totalTicks > b.totalTicks;
+		});
+	return totals;
+}
+
+void IOStats::writeCsv(std::ostream &out)
+{
+	out << "name,count,bytesRead,bytesWritten,reads,writes,seeks,"
+		"ioSeconds,totalSeconds\n";
+	for(const Record &record : totals()) {
+		// quotes are escaped by doubling them
+		out << '"';
+		for(char c : record.name) {
+			out << (c == '"' ? "\"\"" : std::string(1, c));
+		}
+		out << "\"," << record.count << ',' << record.bytesRead << ','
+			<< record.bytesWritten << ',' << record.reads << ','
+			<< record.writes << ',' << record.seeks << ','
+			<< toSeconds(record.ioTicks) << ','
+			<< toSeconds(record.totalTicks) << '\n';
+	}
+}
+
+void IOStats::writeJson(std::ostream &out)
+{
+	out << "[";
+	const char *separator = "\n";
+	for(const Record &record : totals()) {
+		out << separator << "{\"name\": ";
+		writeString(out, record.name);
+		out << ", \"count\": " << record.count
+			<< ", \"bytesRead\": " << record.bytesRead
+			<< ", \"bytesWritten\": " << record.bytesWritten
+			<< ", \"reads\": " << record.reads
+			<< ", \"writes\": " << record.writes
+			<< ", \"seeks\": " << record.seeks
+			<< ", \"ioSeconds\": " << toSeconds(record.ioTicks)
+			<< ", \"totalSeconds\": " << toSeconds(record.totalTicks)
+			<< "}";
+		separator = ",\n";
+	}
+	out << "\n]\n";
+}
+
+void IOStats::writeTrace(std::ostream &out)
+{
+	Registry &r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	double microseconds = 1e6 / SDL_GetPerformanceFrequency();
+	out << "{\"traceEvents\": [";
+	const char *separator = "\n";
+	for(const Event &event : r.events) {
+		// "X" is a complete event: a start and a duration
+		out << separator << "{\"name\": ";
+		writeString(out, event.name);
+		out << ", \"cat\": \"io\", \"ph\": \"X\", \"pid\": 1"
+			<< ", \"tid\": " << event.thread
+			<< ", \"ts\": " << (event.start - r.epoch) * microseconds
+			<< ", \"dur\": " << event.ticks * microseconds
+			<< ", \"args\": {\"bytes\": " << event.bytes << "}}";
+		separator = ",\n";
+	}
+	out << "\n]}\n";
+}
+
+void IOStats::add(const Record &record, Uint64 start)
+{
+	Registry &r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	int thread = r.threads.insert({std::this_thread::get_id(),
+		int(r.threads.size()) + 1}).first->second;
+	auto found = r.index.find(record.name);
+	if(found == r.index.end()) {
+		found = r.index.insert({record.name, r.totals.size()}).first;
+		r.totals.emplace_back();
+		r.totals.back().name = record.name;
+	}
+	Record &total = r.totals[found->second];
+	total.count += record.count;
+	total.bytesRead += record.bytesRead;
+	total.bytesWritten += record.bytesWritten;
+	total.reads += record.reads;
+	total.writes += record.writes;
+	total.seeks += record.seeks;
+	total.ioTicks += record.ioTicks;
+	total.totalTicks += record.totalTicks;
+	// events from before the last clear() would have a negative start
+	if(r.events.size() < MAX_EVENTS && start >= r.epoch) {
+		r.events.push_back({record.name, start, record.totalTicks,
+			record.bytesRead + record.bytesWritten, thread});
+	}
+}
+
+void IOStats::writeString(std::ostream &out, const std::string &s)
+{
+	const char *hex = "0123456789abcdef";
+	out << '"';
+	for(char c : s) {
+		unsigned char u = c;
+		if(c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else if(u < 0x20) {
+			out << "\\u00" << hex[u >> 4] << hex[u & 0xf];
+		} else {
+			out << c; // UTF-8 is fine as it is
+		}
+	}
+	out << '"';
+}
+
+IOStats::Span::Span(std::string name)
+	: start_{SDL_GetPerformanceCounter()}
+{
+	record_.name = name.empty() ? "(unnamed)" : std::move(name);
+	record_.count = 1;
+}
+
+IOStats::Span::~Span()
+{
+	record_.totalTicks = SDL_GetPerformanceCounter() - start_;
+	add(record_, start_);
+}
+
+SDL_RWops *IOStats::Span::wrap(SDL_RWops *rwops)
+{
+	wrapper_.reset(SDL_AllocRW());
+	if(!wrapper_) {
+		return rwops;
+	}
+	wrapper_->size = size;
+	wrapper_->seek = seek;
+	wrapper_->read = read;
+	wrapper_->write = write;
+	wrapper_->close = close;
+	wrapper_->type = rwops->type;
+	wrapper_->hidden.unknown.data1 = rwops;
+	wrapper_->hidden.unknown.data2 = this;
+	return wrapper_.get();
+}
+
+void IOStats::Span::countRead(size_t bytes, Uint64 ticks)
+{
+	++record_.reads;
+	record_.bytesRead += bytes;
+	record_.ioTicks += ticks;
+}
+
+void IOStats::Span::countWrite(size_t bytes, Uint64 ticks)
+{
+	++record_.writes;
+	record_.bytesWritten += bytes;
+	record_.ioTicks += ticks;
+}
+
+void IOStats::Span::countSeek(Uint64 ticks)
+{
+	++record_.seeks;
+	record_.ioTicks += ticks;
+}
+
+Sint64 IOStats::Span::size(SDL_RWops *rwops)
+{
+	// size() is usually a seek to the end and back, so it counts as one
+	Uint64 start = SDL_GetPerformanceCounter();
+	Sint64 result = SDL_RWsize(target(rwops));
+	self(rwops).countSeek(SDL_GetPerformanceCounter() - start);
+	return result;
+}
+
+Sint64 IOStats::Span::seek(SDL_RWops *rwops, Sint64 offset, int whence)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	Sint64 result = SDL_RWseek(target(rwops), offset, whence);
+	self(rwops).countSeek(SDL_GetPerformanceCounter() - start);
+	return result;
+}
+
+size_t IOStats::Span::read(SDL_RWops *rwops, void *ptr, size_t size,
+	size_t maxnum)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	size_t result = SDL_RWread(target(rwops), ptr, size, maxnum);
+	self(rwops).countRead(result * size,
+		SDL_GetPerformanceCounter() - start);
+	return result;
+}
+
+size_t IOStats::Span::write(SDL_RWops *rwops, const void *ptr, size_t size,
+	size_t num)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	size_t result = SDL_RWwrite(target(rwops), ptr, size, num);
+	self(rwops).countWrite(result * size,
+		SDL_GetPerformanceCounter() - start);
+	return result;
+}
+
+} // namespace SDL
+
+#endif // SCC_IOSTATS_HPP
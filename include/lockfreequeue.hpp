@@ -0,0 +1,154 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_LOCKFREEQUEUE_HPP
+#define SCC_LOCKFREEQUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+namespace SDL {
+
+// A bounded queue that any number of threads may push to and pop from,
+// without locks (Dmitry Vyukov's MPMC queue). Neither ever waits: push()
+// returns false when the queue is full, and pop() when it's empty, so it's
+// safe to use from the audio thread.
+//
+// Notes:
+// - the capacity is rounded up to a power of 2
+// - T must be default constructible and copyable, and should be cheap to
+//   copy (it's copied in and out of the queue)
+// - each slot has a sequence number telling whether it's been written or
+//   read for the current lap, so a push and a pop only contend on the same
+//   slot when the queue is full or empty
+template <typename T>
+class LockFreeQueue {
+public:
+	explicit LockFreeQueue(size_t capacity);
+
+	bool push(const T &value);
+	bool pop(T &value);
+
+	size_t capacity() const { return mask_ + 1; }
+	// only a hint, since others may be pushing and popping
+	size_t sizeApprox() const
+	{
+		// head first, so it can't overtake the tail in between
+		size_t head = head_.load(std::memory_order_acquire);
+		return tail_.load(std::memory_order_acquire) - head;
+	}
+
+	LockFreeQueue(const LockFreeQueue &that) = delete;
+	LockFreeQueue & operator=(const LockFreeQueue &that) = delete;
+private:
+	// keeps head_ and tail_ on separate cache lines
+	static const size_t CACHE_LINE = 64;
+
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells_;
+	size_t mask_;
+	char pad0_[CACHE_LINE];
+	std::atomic<size_t> tail_; // where the next push goes
+	char pad1_[CACHE_LINE];
+	std::atomic<size_t> head_; // where the next pop comes from
+	char pad2_[CACHE_LINE];
+};
+
+template <typename T>
+LockFreeQueue<T>::LockFreeQueue(size_t capacity)
+	: tail_{0}, head_{0}
+{
+	size_t size = 2;
+	while(size < capacity) {
+		size *= 2;
+	}
+	mask_ = size - 1;
+	cells_.reset(new Cell[size]);
+	for(size_t i = 0; i < size; ++i) {
+		cells_[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+template <typename T>
+bool LockFreeQueue<T>::push(const T &value)
+{
+	size_t position = tail_.load(std::memory_order_relaxed);
+	for(;;) {
+		Cell &cell = cells_[position & mask_];
+		size_t sequence = cell.sequence.load(std::memory_order_acquire);
+		std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence)
+			- static_cast<std::ptrdiff_t>(position);
+		if(diff == 0) {
+			// free for this lap; claim it
+			if(tail_.compare_exchange_weak(position, position + 1,
+				std::memory_order_relaxed))
+			{
+				cell.value = value;
+				cell.sequence.store(position + 1,
+					std::memory_order_release);
+				return true;
+			}
+			// position was updated by the failed exchange
+		} else if(diff < 0) {
+			// not read since the last lap
+			return false;
+		} else {
+			position = tail_.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+template <typename T>
+bool LockFreeQueue<T>::pop(T &value)
+{
+	size_t position = head_.load(std::memory_order_relaxed);
+	for(;;) {
+		Cell &cell = cells_[position & mask_];
+		size_t sequence = cell.sequence.load(std::memory_order_acquire);
+		std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence)
+			- static_cast<std::ptrdiff_t>(position + 1);
+		if(diff == 0) {
+			if(head_.compare_exchange_weak(position, position + 1,
+				std::memory_order_relaxed))
+			{
+				value = cell.value;
+				// free for the next lap
+				cell.sequence.store(position + mask_ + 1,
+					std::memory_order_release);
+				return true;
+			}
+		} else if(diff < 0) {
+			// not written yet
+			return false;
+		} else {
+			position = head_.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_LOCKFREEQUEUE_HPP
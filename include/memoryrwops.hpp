@@ -0,0 +1,215 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_MEMORYRWOPS_HPP
+#define SCC_MEMORYRWOPS_HPP
+
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include "null.hpp"
+#include "rwops.hpp"
+
+namespace SDL {
+
+// A RWops that owns its memory and grows as it's written to, for when the
+// final size isn't known beforehand (eg serializing a save game or encoding
+// a screenshot in memory).
+//
+// Notes:
+// - the memory grows geometrically, so writing n bytes costs O(n) overall
+// - sizes and positions are 64 bits, unlike RWops(void*, int)'s
+// - seeking past the end is fine; writing there fills the gap with zeroes
+// - the memory is a std::vector<Uint8, Allocator>. To have it come from an
+//   arena of yours, use an allocator that allocates from it. You may also
+//   start with a buffer of your own, whose capacity will be reused.
+// - release() moves the contents out without copying them
+//
+// Since this is a RWops, it can be passed anywhere a RWops is expected.
+template <typename Allocator = std::allocator<Uint8>>
+class MemoryRWops : public RWops {
+public:
+	using Buffer = std::vector<Uint8, Allocator>;
+
+	explicit MemoryRWops(const Allocator &allocator = Allocator())
+		: MemoryRWops(Buffer(allocator))
+	{}
+	// starts with buffer's contents, at position 0
+	explicit MemoryRWops(Buffer buffer);
+
+	// The contents written so far. The pointer is invalidated by
+	// writing past the capacity.
+	const Uint8 *data() const { return stream_->buffer.data(); }
+	Uint64 capacity() const { return stream_->buffer.capacity(); }
+	// so that writing up to bytes doesn't reallocate. Throws
+	// std::bad_alloc or std::length_error on failure.
+	void reserve(Uint64 bytes);
+
+	// Moves the contents out, leaving this empty (with position 0).
+	Buffer release();
+
+	MemoryRWops(const MemoryRWops &that) = delete;
+	MemoryRWops(MemoryRWops &&that) = default;
+	~MemoryRWops() = default;
+	MemoryRWops & operator=(MemoryRWops that)
+	{
+		swap(*this, that);
+		return *this;
+	}
+	friend void swap(MemoryRWops &first, MemoryRWops &second) noexcept
+	{
+		using std::swap;
+		swap(static_cast<RWops&>(first), static_cast<RWops&>(second));
+		swap(first.stream_, second.stream_);
+	}
+
+private:
+	// what's adapted into the RWops
+	struct Stream {
+		Buffer buffer;
+		Uint64 position;
+
+		Sint64 size() const { return buffer.size(); }
+		Sint64 seek(Sint64 offset, int whence);
+		size_t read(void *ptr, size_t size, size_t maxnum);
+		size_t write(const void *ptr, size_t size, size_t num);
+		void grow(Uint64 bytes);
+	};
+
+	// owned by the RWops
+	Stream *stream_;
+};
+
+template <typename Allocator>
+MemoryRWops<Allocator>::MemoryRWops(Buffer buffer)
+	: RWops(RWops::adapt(std::unique_ptr<Stream>(
+		new Stream{std::move(buffer), 0}))),
+	stream_{target<Stream>()}
+{}
+
+template <typename Allocator>
+void MemoryRWops<Allocator>::reserve(Uint64 bytes)
+{
+	if(bytes > stream_->buffer.max_size()) {
+		throw std::length_error("MemoryRWops: can't reserve that much");
+	}
+	stream_->buffer.reserve(static_cast<size_t>(bytes));
+}
+
+template <typename Allocator>
+typename MemoryRWops<Allocator>::Buffer MemoryRWops<Allocator>::release()
+{
+	Buffer contents(std::move(stream_->buffer));
+	stream_->buffer.clear(); // moved-from vectors are valid, not empty
+	stream_->position = 0;
+	return contents;
+}
+
+template <typename Allocator>
+Sint64 MemoryRWops<Allocator>::Stream::seek(Sint64 offset, int whence)
+{
+	Sint64 base;
+	switch(whence) {
+	case RW_SEEK_SET:
+		base = 0;
+	break;
+	case RW_SEEK_CUR:
+		base = position;
+	break;
+	case RW_SEEK_END:
+		base = buffer.size();
+	break;
+	default:
+		SDL_SetError("MemoryRWops: unknown value for 'whence'");
+		return -1;
+	}
+	if(base + offset < 0) {
+		SDL_SetError("MemoryRWops: can't seek before the beginning");
+		return -1;
+	}
+	position = base + offset;
+	return position;
+}
+
+template <typename Allocator>
+size_t MemoryRWops<Allocator>::Stream::read(void *ptr, size_t size,
+	size_t maxnum)
+{
+	if(size == 0 || position >= buffer.size()) {
+		return 0;
+	}
+	// like SDL's own RWops, whole objects only
+	size_t count = std::min<Uint64>(maxnum,
+		(buffer.size() - position) / size);
+	std::copy_n(buffer.begin() + position, count * size,
+		static_cast<Uint8*>(ptr));
+	position += count * size;
+	return count;
+}
+
+template <typename Allocator>
+size_t MemoryRWops<Allocator>::Stream::write(const void *ptr, size_t size,
+	size_t num)
+{
+	Uint64 bytes = static_cast<Uint64>(size) * num;
+	if(bytes == 0) {
+		return 0;
+	}
+	const Uint8 *src = static_cast<const Uint8*>(ptr);
+	// exceptions mustn't get through SDL's C code
+	try {
+		grow(position + bytes);
+		if(position > buffer.size()) {
+			buffer.resize(position); // the gap after a seek
+		}
+		Uint64 overwritten = std::min<Uint64>(bytes,
+			buffer.size() - position);
+		std::copy_n(src, overwritten, buffer.begin() + position);
+		buffer.insert(buffer.end(), src + overwritten, src + bytes);
+	} catch(const std::exception &) {
+		SDL_SetError("MemoryRWops: out of memory");
+		return 0;
+	}
+	position += bytes;
+	return num;
+}
+
+template <typename Allocator>
+void MemoryRWops<Allocator>::Stream::grow(Uint64 bytes)
+{
+	if(bytes <= buffer.capacity()) {
+		return;
+	}
+	if(bytes > buffer.max_size()) {
+		throw std::length_error("MemoryRWops: too big");
+	}
+	// not left to vector::insert(), because resize() for a gap doesn't
+	// grow geometrically
+	Uint64 doubled = std::min<Uint64>(buffer.capacity() * 2,
+		buffer.max_size());
+	buffer.reserve(static_cast<size_t>(std::max(bytes, doubled)));
+}
+
+} // namespace SDL
+
+#endif // SCC_MEMORYRWOPS_HPP
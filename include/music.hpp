@@ -36,9 +36,19 @@ namespace SDL {
 
 class RWops;
 
+// Notes:
+// - SDL_mixer reads music from its file as it plays, not all at once, so
+//   the file must be there for as long as the Music is. Music made from a
+//   filename, or from a RWops it's given (moved into it), owns its file;
+//   one made from a const RWops& only borrows it.
+// - to keep slow storage from holding up the audio thread, give it a
+//   PrefetchRWops, which reads ahead on a worker thread
+// - IOStats doesn't count music's reads (they go on after loading); use
+//   an InstrumentedRWops for that
 class Music {
 public:
 	Music(const char *filename) : Music(RWops(filename, "rb")) {}
+	Music(RWops &&file);
 	Music(const RWops &file);
 
 	int play(int loops = -1) { return Mix_PlayMusic(music_.get(), loops); }
@@ -78,6 +88,7 @@ public:
 	friend void swap(Music &first, Music &second) noexcept
 	{
 		using std::swap;
+		swap(first.source_, second.source_);
 		swap(first.music_, second.music_);
 	}
 
@@ -85,11 +96,20 @@ public:
 		void operator()(Mix_Music *music) { Mix_FreeMusic(music); }
 	};
 private:
+	// declared first, so it's destroyed after music_, which reads from it.
+	// NULL when the file's borrowed.
+	std::unique_ptr<RWops> source_;
 	std::unique_ptr<Mix_Music, Deleter> music_;
 };
 
+Music::Music(RWops &&file)
+	: source_{new RWops(std::move(file))},
+	music_{FromRWops<Music::Deleter>::stream(*source_, Mix_LoadMUS_RW,
+		"Loading music from file failed")}
+{}
+
 Music::Music(const RWops &file)
-	: music_{FromRWops<Music::Deleter>::load(file, Mix_LoadMUS_RW,
+	: music_{FromRWops<Music::Deleter>::stream(file, Mix_LoadMUS_RW,
 		"Loading music from file failed")}
 {}
 
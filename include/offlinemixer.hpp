@@ -0,0 +1,275 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_OFFLINEMIXER_HPP
+#define SCC_OFFLINEMIXER_HPP
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdlib>
+#include "null.hpp"
+#include "rwops.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use OfflineMixer class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Opens SDL_mixer's audio on SDL's disk driver, with no delay between
+// callbacks, so it mixes as fast as it can rather than in real time, and
+// keeps what's mixed. Everything that plays through SDL_mixer (chunks,
+// channels, music and their effects) may then be rendered headless, to
+// check what comes out or to time it.
+//
+// Notes:
+// - audio's paused but between render()s, so things may be set up
+//   beforehand, and nothing's missed. Everything that's mixed is kept,
+//   with Mix_SetPostMix() (which it takes up).
+// - SDL's audio must not be initialized when it's made: it's initialized
+//   for the disk driver, and quit when it's destroyed. The driver's own
+//   output goes nowhere (the null device).
+// - the throughput counts every channel and the music that's playing as a
+//   voice, for however long it's mixed, and divides by the real time taken
+class OfflineMixer {
+public:
+	static const int DEFAULT_CHUNK_SIZE = 4096;
+
+	struct Stats {
+		Uint64 frames; // mixed by the last render()
+		double seconds; // of audio, in those frames
+		double realSeconds; // it took
+		double voiceSeconds; // seconds of each voice, summed
+		double speed; // seconds / realSeconds
+		double throughput; // voiceSeconds / realSeconds
+	};
+
+	// the same as Mix_OpenAudio()'s. Throws std::runtime_error if audio's
+	// already initialized, or opening it fails.
+	OfflineMixer(int frequency = MIX_DEFAULT_FREQUENCY,
+		Uint16 format = MIX_DEFAULT_FORMAT, int channels = 2,
+		int chunkSize = DEFAULT_CHUNK_SIZE);
+	~OfflineMixer();
+
+	// mixes at least seconds more of audio (up to a chunk past it) and
+	// returns how long it took
+	Stats render(double seconds);
+
+	// the samples mixed so far, in the mixer's format
+	const std::vector<Uint8> & getSamples() const { return samples_; }
+	void clearSamples() { samples_.clear(); }
+	// writes them as a WAV. Returns false on error (see SDL_GetError()).
+	bool writeWav(RWops &file) const;
+
+	int getFrequency() const { return frequency_; }
+	Uint16 getFormat() const { return format_; }
+	int getChannels() const { return channels_; }
+
+	OfflineMixer(const OfflineMixer &that) = delete;
+	OfflineMixer & operator=(const OfflineMixer &that) = delete;
+private:
+	static void postMix(void *udata, Uint8 *stream, int len);
+	// SDL_setenv() can only set it
+	static void unsetEnv(const char *name);
+
+	int frequency_;
+	Uint16 format_;
+	int channels_;
+	int frameSize_;
+	std::vector<Uint8> samples_; // only touched while audio's paused
+	std::atomic<Uint64> frames_;
+	double voiceSeconds_; // audio thread's, read while paused
+	std::mutex mutex_;
+	std::condition_variable cond_;
+};
+
+OfflineMixer::OfflineMixer(int frequency, Uint16 format, int channels,
+	int chunkSize)
+	: frequency_{frequency}, format_{format}, channels_{channels},
+	samples_(), frames_{0}, voiceSeconds_{0}
+{
+	if(SDL_WasInit(SDL_INIT_AUDIO)) {
+		throw std::runtime_error("Opening offline mixer failed: audio's "
+			"already initialized");
+	}
+	// read when audio's initialized and opened, so they're put back after
+	const char *names[] = {
+		"SDL_AUDIODRIVER", "SDL_DISKAUDIODELAY", "SDL_DISKAUDIOFILE"
+	};
+	const char *values[] = {
+		"disk", "0",
+#ifdef _WIN32
+		"NUL"
+#else
+		"/dev/null"
+#endif
+	};
+	std::string old[3];
+	bool wasSet[3];
+	for(int i = 0; i < 3; ++i) {
+		const char *value = SDL_getenv(names[i]);
+		wasSet[i] = value != NULL;
+		old[i] = wasSet[i] ? value : "";
+		SDL_setenv(names[i], values[i], 1);
+	}
+	bool failed = SDL_InitSubSystem(SDL_INIT_AUDIO) < 0;
+	if(!failed && Mix_OpenAudio(frequency, format, channels,
+		chunkSize) < 0)
+	{
+		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		failed = true;
+	}
+	for(int i = 0; i < 3; ++i) {
+		if(wasSet[i]) {
+			SDL_setenv(names[i], old[i].c_str(), 1);
+		} else {
+			unsetEnv(names[i]);
+		}
+	}
+	if(failed) {
+		throw std::runtime_error(std::string("Opening offline mixer "
+			"failed: ") + SDL_GetError());
+	}
+	SDL_PauseAudio(1);
+	Mix_QuerySpec(&frequency_, &format_, &channels_);
+	frameSize_ = SDL_AUDIO_BITSIZE(format_) / 8 * channels_;
+	Mix_SetPostMix(postMix, this);
+}
+
+OfflineMixer::~OfflineMixer()
+{
+	Mix_SetPostMix(NULL, NULL);
+	Mix_CloseAudio();
+	SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+OfflineMixer::Stats OfflineMixer::render(double seconds)
+{
+	// when the audio thread doesn't get to notify while we're waiting
+	const std::chrono::milliseconds POLL_INTERVAL(1);
+
+	Uint64 target = static_cast<Uint64>(seconds * frequency_ + 0.5);
+	Uint64 first = frames_.load();
+	double voiceSeconds = voiceSeconds_;
+	samples_.reserve(samples_.size() + target * frameSize_);
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	SDL_PauseAudio(0);
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		while(frames_.load() - first < target) {
+			cond_.wait_for(lock, POLL_INTERVAL);
+		}
+	}
+	// waits for the callback that's running
+	SDL_PauseAudio(1);
+	Uint64 end = SDL_GetPerformanceCounter();
+
+	Stats stats;
+	stats.frames = frames_.load() - first;
+	stats.seconds = static_cast<double>(stats.frames) / frequency_;
+	stats.realSeconds = static_cast<double>(end - start)
+		/ SDL_GetPerformanceFrequency();
+	stats.voiceSeconds = voiceSeconds_ - voiceSeconds;
+	stats.speed = stats.realSeconds > 0
+		? stats.seconds / stats.realSeconds : 0;
+	stats.throughput = stats.realSeconds > 0
+		? stats.voiceSeconds / stats.realSeconds : 0;
+	return stats;
+}
+
+void OfflineMixer::postMix(void *udata, Uint8 *stream, int len)
+{
+	OfflineMixer &self = *static_cast<OfflineMixer*>(udata);
+	int frames = len / self.frameSize_;
+	int voices = Mix_Playing(-1) + (Mix_PlayingMusic() ? 1 : 0);
+	self.voiceSeconds_ += static_cast<double>(voices) * frames
+		/ self.frequency_;
+	self.samples_.insert(self.samples_.end(), stream, stream + len);
+	self.frames_ += frames;
+	self.cond_.notify_one();
+}
+
+void OfflineMixer::unsetEnv(const char *name)
+{
+#ifdef _WIN32
+	// an empty value removes it
+	_putenv((std::string(name) + "=").c_str());
+#else
+	unsetenv(name);
+#endif
+}
+
+bool OfflineMixer::writeWav(RWops &file) const
+{
+	const int bits = SDL_AUDIO_BITSIZE(format_);
+	const int bytes = bits / 8;
+	const Uint32 length = samples_.size();
+	Uint8 header[44];
+	auto put = [&header](int at, Uint32 value, int size) {
+		for(int i = 0; i < size; ++i) {
+			header[at + i] = static_cast<Uint8>(value >> 8 * i);
+		}
+	};
+	std::copy_n("RIFF", 4, header);
+	put(4, 36 + length, 4);
+	std::copy_n("WAVEfmt ", 8, header + 8);
+	put(16, 16, 4);
+	put(20, SDL_AUDIO_ISFLOAT(format_) ? 3 : 1, 2); // float or PCM
+	put(22, channels_, 2);
+	put(24, frequency_, 4);
+	put(28, frequency_ * frameSize_, 4);
+	put(32, frameSize_, 2);
+	put(34, bits, 2);
+	std::copy_n("data", 4, header + 36);
+	put(40, length, 4);
+	if(file.write(header, sizeof(header), 1) != 1) {
+		return false;
+	}
+
+	// WAVs are little-endian, with unsigned 8-bit and signed wider samples
+	bool swap = bytes > 1 && SDL_AUDIO_ISBIGENDIAN(format_);
+	bool flip = SDL_AUDIO_ISSIGNED(format_) != (bytes > 1);
+	if(!swap && !flip) {
+		return length == 0 || file.write(samples_.data(), length, 1) == 1;
+	}
+	std::vector<Uint8> converted(samples_);
+	for(size_t i = 0; i < converted.size(); i += bytes) {
+		if(swap) {
+			std::reverse(&converted[i], &converted[i] + bytes);
+		}
+		if(flip) {
+			// the most significant byte's sign bit, now it's last
+			converted[i + bytes - 1] ^= 0x80;
+		}
+	}
+	return length == 0 || file.write(converted.data(), length, 1) == 1;
+}
+
+} // namespace SDL
+
+#endif // SCC_OFFLINEMIXER_HPP
@@ -0,0 +1,93 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_PARALLELFOR_HPP
+#define SCC_PARALLELFOR_HPP
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <algorithm>
+
+namespace SDL {
+
+// Calls f(i) for each i in [begin, end), on up to threadCount threads (the
+// calling one included), each taking the next i as soon as it's done with
+// the last. 0 threads means one per core. Returns once every call has.
+//
+// If any call throws, the i's not started yet are skipped, and the first
+// exception thrown is rethrown (once the other threads are done).
+// Meant for coarse work like loading files; each call should take much
+// longer than starting a thread does.
+template <typename F>
+void parallelFor(size_t begin, size_t end, F f, unsigned threadCount = 0)
+{
+	if(begin >= end) {
+		return;
+	}
+	if(threadCount == 0) {
+		// hardware_concurrency() may not know, and say 0
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	threadCount = static_cast<unsigned>(
+		std::min<size_t>(threadCount, end - begin));
+
+	std::atomic<size_t> next{begin};
+	std::atomic<bool> failed{false};
+	std::exception_ptr error;
+	std::mutex errorMutex;
+	auto work = [&]() {
+		for(size_t i = next++; i < end && !failed; i = next++) {
+			try {
+				f(i);
+			} catch(...) {
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if(!failed) {
+					error = std::current_exception();
+					failed = true;
+				}
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	try {
+		for(unsigned i = 1; i < threadCount; ++i) {
+			threads.emplace_back(work);
+		}
+	} catch(...) {
+		// couldn't start them all; the ones that did (and this one)
+		// will do
+	}
+	work();
+	for(std::thread &thread : threads) {
+		thread.join();
+	}
+	if(error) {
+		std::rethrow_exception(error);
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_PARALLELFOR_HPP
@@ -0,0 +1,630 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_PLAYLIST_HPP
+#define SCC_PLAYLIST_HPP
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include "null.hpp"
+#include "music.hpp"
+#include "audiochunk.hpp"
+#include "lockfreequeue.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use Playlist class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Plays music files one after the other, without gaps. The next track is
+// opened on a worker thread while the current one plays, and started from
+// Mix_HookMusicFinished(), in the same callback the current one ends in
+// (SDL_mixer fills the rest of it with the new track).
+//
+// With a crossfade, each track fades into the next over its last
+// crossfade ms, instead (and next() fades into the next one at once).
+// SDL_mixer plays one music at a time, so the tracks are then decoded whole
+// on the worker thread (Mix_LoadWAV_RW() takes OGG and MP3 too) and mixed by
+// the playlist itself, in a MIX_CHANNEL_POST effect, to the frame.
+//
+// Notes:
+// - without a crossfade, setFade() makes next() fade the current track
+//   out and the next one in. Tracks that end by themselves go on to the
+//   next at once, since SDL_mixer can't tell how long a track is.
+// - decoded tracks take about 10 MB a minute (44100 Hz stereo, 16 bit),
+//   and up to three are kept: the next, the current, and the one fading
+//   out. Mix_VolumeMusic() doesn't apply to them, and the mixer's format
+//   must be AUDIO_S16SYS or AUDIO_F32SYS.
+// - if the next track isn't open in time (or fails to open), the worker
+//   starts it as soon as it can, and the tracks that fail are skipped. The
+//   last error is kept for getError() (SDL's error is per thread, so the
+//   worker can't report it itself).
+// - only one may exist at a time. Without a crossfade, it sets
+//   Mix_HookMusicFinished(), and no other music should be played meanwhile.
+// - it must be used from one thread (plus its worker)
+class Playlist {
+public:
+	static const int NONE = -1;
+
+	// repeat goes back to the first track after the last. crossfade is in
+	// ms (0 streams the tracks as music instead). Starts opening the first
+	// track. Throws std::runtime_error if there's another Playlist, or if
+	// there's a crossfade and audio isn't open, or its format isn't
+	// supported.
+	explicit Playlist(std::vector<std::string> paths, bool repeat = true,
+		Uint32 crossfade = 0);
+	// stops the music
+	~Playlist();
+
+	// starts with the first track (opening it here, if it isn't yet).
+	// Returns false on error (see SDL_GetError()).
+	bool play();
+	// skips to the next track (crossfading or fading, if either is set)
+	void next();
+	void stop();
+
+	// the track playing, or NONE. While crossfading, the one fading in.
+	int getCurrent() const { return current_.load(); }
+	size_t size() const { return paths_.size(); }
+	const std::string &getPath(size_t index) const { return paths_[index]; }
+
+	Uint32 getCrossfade() const { return crossfade_; }
+	Uint32 getFade() const { return fade_.load(); }
+	// ms. 0 switches at once. Not used with a crossfade.
+	void setFade(Uint32 ms) { fade_.store(ms); }
+
+	std::string getError() const;
+
+	Playlist(const Playlist &that) = delete;
+	Playlist & operator=(const Playlist &that) = delete;
+private:
+	// an open track, and the one it was opened to follow. Decoded whole
+	// with a crossfade, and streamed without.
+	struct Track {
+		Track(const std::string &path, int after, int index, bool decode)
+			: after{after}, index{index},
+			music{decode ? NULL : new Music(path.c_str())},
+			chunk{decode ? new AudioChunk(path.c_str()) : NULL}
+		{}
+
+		int after, index;
+		std::unique_ptr<Music> music;
+		std::unique_ptr<AudioChunk> chunk;
+	};
+
+	// a decoded track being mixed, with a crossfade. With the audio locked
+	// only.
+	struct Deck {
+		Track *track; // NULL if there's none
+		const Uint8 *data;
+		Uint32 length, position; // in frames
+		float gain;
+		float step; // added to gain every frame, while fading
+		bool ending; // fading into the next track already, or tried to
+	};
+
+	static Playlist *&instance()
+	{
+		static Playlist *playlist = NULL;
+		return playlist;
+	}
+	static void finished();
+	static void deck(int channel, void *stream, int len, void *udata);
+
+	// the track after index, or NONE
+	int following(int index) const;
+	// the ready track, if it's the one after the current. From any thread.
+	Track *take();
+	// for the worker to free. From any thread.
+	void retire(Track *track);
+	// from any thread
+	bool start(Track *track, bool fade);
+	void wake();
+	void work();
+	// opens the track after current, or the first after it that opens.
+	// Returns NULL if none does.
+	Track *open(int current);
+
+	// these are with the audio locked
+	void mixDecks(Uint8 *stream, int len);
+	template <typename Sample>
+	void mixDeck(Deck &deck, Uint8 *stream, Uint32 frames);
+	static Sint16 mixSample(Sint16 out, Sint16 in, float gain);
+	static float mixSample(float out, float in, float gain);
+	// starts fading the current track into the ready one, over frames.
+	// Returns false if it isn't ready (the worker does it once it is).
+	bool cross(Uint32 frames);
+	void load(Deck &deck, Track *track);
+	void end(Deck &deck);
+
+	std::vector<std::string> paths_;
+	bool repeat_;
+	Uint32 crossfade_;
+	std::atomic<Uint32> fade_;
+	std::atomic<bool> fadeNext_; // the next start is after a next()
+	std::atomic<bool> stopped_;
+	// the next track wasn't open when the current one ended
+	std::atomic<bool> starved_;
+	std::atomic<int> current_;
+	std::atomic<Track*> playing_, ready_;
+	// played tracks, for the worker to free
+	LockFreeQueue<Track*> retired_;
+
+	// with a crossfade
+	Uint16 format_;
+	int channels_;
+	int frameSize_;
+	Uint32 crossfadeFrames_;
+	Deck decks_[2];
+	int on_; // the current track's deck
+
+	mutable std::mutex mutex_;
+	std::condition_variable wakeup_;
+	std::atomic<bool> wake_;
+	bool quit_;
+	std::string error_;
+	std::thread worker_;
+};
+
+Playlist::Playlist(std::vector<std::string> paths, bool repeat,
+	Uint32 crossfade)
+	: paths_(std::move(paths)), repeat_{repeat}, crossfade_{crossfade},
+	fade_{0}, fadeNext_{false}, stopped_{true}, starved_{false},
+	current_{NONE}, playing_{NULL}, ready_{NULL}, retired_(16), format_{0},
+	channels_{0}, frameSize_{0}, crossfadeFrames_{0}, decks_(), on_{0},
+	wake_{false}, quit_{false}
+{
+	if(instance() != NULL) {
+		throw std::runtime_error("Making playlist failed: there's one "
+			"already");
+	}
+	if(crossfade_ > 0) {
+		int frequency;
+		if(Mix_QuerySpec(&frequency, &format_, &channels_) == 0) {
+			throw std::runtime_error("Making playlist failed: audio "
+				"isn't open");
+		}
+		if(format_ != AUDIO_S16SYS && format_ != AUDIO_F32SYS) {
+			throw std::runtime_error("Making playlist failed: the "
+				"mixer's format must be AUDIO_S16SYS or AUDIO_F32SYS");
+		}
+		frameSize_ = SDL_AUDIO_BITSIZE(format_) / 8 * channels_;
+		crossfadeFrames_ = static_cast<Uint32>(
+			static_cast<Uint64>(crossfade_) * frequency / 1000);
+		if(Mix_RegisterEffect(MIX_CHANNEL_POST, deck, NULL, this) == 0) {
+			throw std::runtime_error(std::string("Making playlist "
+				"failed: ") + SDL_GetError());
+		}
+	} else {
+		Mix_HookMusicFinished(finished);
+	}
+	instance() = this;
+	worker_ = std::thread(&Playlist::work, this);
+}
+
+Playlist::~Playlist()
+{
+	// no more switching, from either thread
+	if(crossfade_ > 0) {
+		Mix_UnregisterEffect(MIX_CHANNEL_POST, deck);
+	} else {
+		Mix_HookMusicFinished(NULL);
+	}
+	stopped_.store(true);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	wakeup_.notify_one();
+	worker_.join();
+	if(crossfade_ == 0) {
+		Mix_HaltMusic();
+	}
+	instance() = NULL;
+	Track *track;
+	while(retired_.pop(track)) {
+		delete track;
+	}
+	for(Deck &deck : decks_) {
+		delete deck.track;
+	}
+	delete playing_.load();
+	delete ready_.load();
+}
+
+bool Playlist::play()
+{
+	if(paths_.empty()) {
+		SDL_SetError("Playlist: no tracks");
+		return false;
+	}
+	stop();
+	Track *track = ready_.exchange(NULL);
+	if(track != NULL && track->index != 0) {
+		// opened to follow a track, but not the first
+		delete track;
+		track = NULL;
+	}
+	if(track == NULL) {
+		try {
+			track = new Track(paths_[0], NONE, 0, crossfade_ > 0);
+		} catch(const std::runtime_error &) {
+			return false;
+		}
+	}
+	stopped_.store(false);
+	bool ok = true;
+	if(crossfade_ > 0) {
+		SDL_LockAudio();
+		load(decks_[on_], track);
+		current_.store(0);
+		SDL_UnlockAudio();
+	} else {
+		ok = start(track, false);
+	}
+	wake();
+	return ok;
+}
+
+void Playlist::next()
+{
+	if(stopped_.load()) {
+		return;
+	}
+	if(crossfade_ > 0) {
+		SDL_LockAudio();
+		Deck &current = decks_[on_];
+		if(current.track != NULL) {
+			current.ending = true;
+			Uint32 frames = std::min(crossfadeFrames_,
+				current.length - current.position);
+			if(!cross(frames) && following(current_.load()) == NONE) {
+				// the last one; it only fades out
+				current.step = -current.gain / std::max(frames, 1u);
+			}
+		}
+		SDL_UnlockAudio();
+		return;
+	}
+	Uint32 fade = fade_.load();
+	if(fade > 0) {
+		fadeNext_.store(true);
+		Mix_FadeOutMusic(fade);
+	} else {
+		// calls finished(), which starts the next one
+		Mix_HaltMusic();
+	}
+}
+
+void Playlist::stop()
+{
+	stopped_.store(true);
+	starved_.store(false);
+	if(crossfade_ > 0) {
+		Track *tracks[2];
+		SDL_LockAudio();
+		for(int i = 0; i < 2; ++i) {
+			tracks[i] = decks_[i].track;
+			decks_[i].track = NULL;
+		}
+		current_.store(NONE);
+		SDL_UnlockAudio();
+		delete tracks[0];
+		delete tracks[1];
+	} else {
+		Mix_HaltMusic();
+		current_.store(NONE);
+	}
+}
+
+std::string Playlist::getError() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return error_;
+}
+
+void Playlist::finished()
+{
+	// on the audio thread, usually, with the audio locked
+	Playlist *self = instance();
+	if(self == NULL || self->stopped_.load()) {
+		return;
+	}
+	Track *track = self->take();
+	if(track == NULL) {
+		if(self->following(self->current_.load()) != NONE) {
+			self->starved_.store(true);
+		} else {
+			// the end
+			self->current_.store(NONE);
+		}
+	} else {
+		self->start(track, self->fadeNext_.exchange(false));
+	}
+	self->wake();
+}
+
+void Playlist::deck(int channel, void *stream, int len, void *udata)
+{
+	static_cast<Playlist*>(udata)->mixDecks(static_cast<Uint8*>(stream),
+		len);
+}
+
+int Playlist::following(int index) const
+{
+	if(index + 1 < static_cast<int>(paths_.size())) {
+		return index + 1;
+	}
+	return repeat_ && !paths_.empty() ? 0 : NONE;
+}
+
+Playlist::Track *Playlist::take()
+{
+	Track *track = ready_.exchange(NULL);
+	if(track != NULL && track->after != current_.load()) {
+		// opened before the current track changed (by play(), or by a
+		// start the worker didn't see yet), so it may not be the next
+		retire(track);
+		track = NULL;
+	}
+	return track;
+}
+
+void Playlist::retire(Track *track)
+{
+	if(track != NULL && !retired_.push(track)) {
+		// the worker's way behind; this shouldn't happen
+		delete track;
+	}
+}
+
+bool Playlist::start(Track *track, bool fade)
+{
+	// played once (1 means once, too, but only in newer SDL_mixers)
+	Music &music = *track->music;
+	int result = fade ? music.fadeIn(0, fade_.load()) : music.play(0);
+	retire(playing_.exchange(track));
+	current_.store(track->index);
+	if(result < 0) {
+		// on to the one after it
+		starved_.store(true);
+		return false;
+	}
+	return true;
+}
+
+void Playlist::wake()
+{
+	// without the mutex, since this may be the audio thread. A wakeup
+	// lost to a race only waits for the next poll.
+	wake_.store(true);
+	wakeup_.notify_one();
+}
+
+Playlist::Track *Playlist::open(int current)
+{
+	int index = current;
+	for(size_t tries = 0; tries < paths_.size(); ++tries) {
+		index = following(index);
+		if(index == NONE) {
+			return NULL;
+		}
+		try {
+			return new Track(paths_[index], current, index,
+				crossfade_ > 0);
+		} catch(const std::runtime_error &) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			error_ = paths_[index] + ": " + SDL_GetError();
+		}
+	}
+	return NULL;
+}
+
+void Playlist::work()
+{
+	// how often to look for work, when nobody says there's some
+	const std::chrono::milliseconds POLL_INTERVAL(50);
+	std::unique_lock<std::mutex> lock(mutex_);
+	while(!quit_) {
+		lock.unlock();
+		Track *track;
+		while(retired_.pop(track)) {
+			delete track;
+		}
+		int current = current_.load();
+		track = ready_.load();
+		if(track != NULL && track->after != current) {
+			// the track changed since it was opened. Unless it's
+			// been taken meanwhile, the one after the new one's needed.
+			delete ready_.exchange(NULL);
+			track = NULL;
+		}
+		if(track == NULL) {
+			track = open(current);
+			if(track != NULL && current_.load() != current) {
+				// the track changed meanwhile (play(), or finished()
+				// taking the one that was ready), so this may not be
+				// the one after it
+				delete track;
+				lock.lock();
+				continue;
+			}
+			if(track != NULL) {
+				// with everything about it, so it's never seen half
+				// published
+				ready_.store(track);
+			}
+		}
+		if(starved_.load() && !stopped_.load()) {
+			if(crossfade_ > 0) {
+				SDL_LockAudio();
+				Deck &playing = decks_[on_];
+				if(!stopped_.load()) {
+					cross(playing.track == NULL ? 0
+						: std::min(crossfadeFrames_,
+						playing.length - playing.position));
+				}
+				SDL_UnlockAudio();
+			} else {
+				track = take();
+				if(track != NULL) {
+					starved_.store(false);
+					start(track, false);
+				}
+			}
+		}
+		lock.lock();
+		wakeup_.wait_for(lock, POLL_INTERVAL,
+			[this]() { return quit_ || wake_.load(); });
+		wake_.store(false);
+	}
+}
+
+void Playlist::mixDecks(Uint8 *stream, int len)
+{
+	Uint32 frames = len / frameSize_;
+	Uint32 done = 0;
+	while(done < frames) {
+		Uint32 span = frames - done;
+		Deck &current = decks_[on_];
+		if(current.track != NULL && !current.ending) {
+			Uint32 left = current.length - current.position;
+			if(left <= crossfadeFrames_) {
+				// into the next one, for the rest of this one
+				current.ending = true;
+				cross(left);
+				continue;
+			}
+			// up to where that starts
+			span = std::min(span, left - crossfadeFrames_);
+		}
+		for(Deck &deck : decks_) {
+			if(deck.track == NULL) {
+				continue;
+			}
+			Uint32 n = std::min(span, deck.length - deck.position);
+			Uint8 *out = stream + done * frameSize_;
+			if(format_ == AUDIO_F32SYS) {
+				mixDeck<float>(deck, out, n);
+			} else {
+				mixDeck<Sint16>(deck, out, n);
+			}
+			if(deck.position == deck.length
+				|| (deck.step < 0.0f && deck.gain <= 0.0f)) {
+				end(deck);
+			}
+		}
+		done += span;
+	}
+}
+
+template <typename Sample>
+void Playlist::mixDeck(Deck &deck, Uint8 *stream, Uint32 frames)
+{
+	const Sample *in = reinterpret_cast<const Sample*>(deck.data)
+		+ deck.position * channels_;
+	Sample *out = reinterpret_cast<Sample*>(stream);
+	for(Uint32 i = 0; i < frames; ++i) {
+		for(int c = 0; c < channels_; ++c) {
+			*out = mixSample(*out, *in++, deck.gain);
+			++out;
+		}
+		deck.gain = std::max(0.0f, std::min(deck.gain + deck.step, 1.0f));
+	}
+	deck.position += frames;
+}
+
+Sint16 Playlist::mixSample(Sint16 out, Sint16 in, float gain)
+{
+	float s = out + in * gain;
+	return static_cast<Sint16>(std::max(-32768.0f, std::min(s, 32767.0f)));
+}
+
+float Playlist::mixSample(float out, float in, float gain)
+{
+	return out + in * gain;
+}
+
+bool Playlist::cross(Uint32 frames)
+{
+	Track *track = take();
+	if(track == NULL) {
+		if(following(current_.load()) != NONE) {
+			starved_.store(true);
+		}
+		return false;
+	}
+	starved_.store(false);
+	Deck &out = decks_[on_];
+	Deck &in = decks_[1 - on_];
+	if(in.track != NULL) {
+		// still fading out from the last crossfade; cut short
+		end(in);
+	}
+	load(in, track);
+	on_ = 1 - on_;
+	current_.store(track->index);
+	if(out.track != NULL && frames > 0) {
+		out.step = -out.gain / frames;
+		in.gain = 0.0f;
+		in.step = 1.0f / frames;
+	} else if(out.track != NULL) {
+		end(out);
+	}
+	wake();
+	return true;
+}
+
+void Playlist::load(Deck &deck, Track *track)
+{
+	const Mix_Chunk *chunk = track->chunk->chunk_.get();
+	deck.track = track;
+	deck.data = chunk->abuf;
+	deck.length = chunk->alen / frameSize_;
+	deck.position = 0;
+	deck.gain = 1.0f;
+	deck.step = 0.0f;
+	deck.ending = false;
+}
+
+void Playlist::end(Deck &deck)
+{
+	retire(deck.track);
+	deck.track = NULL;
+	if(&deck == &decks_[on_] && following(current_.load()) == NONE) {
+		// the end (otherwise, the next one's on its way)
+		current_.store(NONE);
+	}
+	wake();
+}
+
+} // namespace SDL
+
+#endif // SCC_PLAYLIST_HPP
@@ -0,0 +1,297 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_PREFETCHRWOPS_HPP
+#define SCC_PREFETCHRWOPS_HPP
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <SDL.h>
+#include "null.hpp"
+#include "rwops.hpp"
+#include "spscring.hpp"
+
+namespace SDL {
+
+// A RWops that reads another one (typically a file) ahead, on a worker
+// thread, into a ring buffer, so that whoever reads it (eg SDL_mixer's
+// decoder, on the audio thread, for Music) gets its data from memory
+// instead of waiting for slow storage. Reading takes no locks while the
+// ring has what's asked for.
+//
+// Notes:
+// - it can't be written to
+// - read() only waits if the worker is behind by a whole buffer (or after
+//   a seek, below)
+// - seeking forward within what's been read ahead skips over it; any other
+//   seek waits for the worker to seek the source and start over from there
+// - if reading the source fails, read() returns what there was and fails
+//   once, with SDL_GetError() saying why. SDL's error is per thread, so the
+//   worker can't report it itself.
+// - size() is the source's, as it was when this was made
+class PrefetchRWops : public RWops {
+public:
+	static const size_t DEFAULT_BUFFER_SIZE = 256 * 1024;
+	static const size_t DEFAULT_READ_SIZE = 16 * 1024;
+
+	// readSize is how much the worker reads from the source at once.
+	// Throws std::runtime_error if either size is 0, or readSize is
+	// bigger than bufferSize.
+	explicit PrefetchRWops(RWops source,
+		size_t bufferSize = DEFAULT_BUFFER_SIZE,
+		size_t readSize = DEFAULT_READ_SIZE);
+
+	// how many bytes are read ahead, right now
+	size_t getBuffered() const;
+
+	PrefetchRWops(const PrefetchRWops &that) = delete;
+	PrefetchRWops(PrefetchRWops &&that) = default;
+	~PrefetchRWops() = default;
+	PrefetchRWops & operator=(PrefetchRWops that)
+	{
+		swap(*this, that);
+		return *this;
+	}
+	friend void swap(PrefetchRWops &first, PrefetchRWops &second) noexcept
+	{
+		using std::swap;
+		swap(static_cast<RWops&>(first), static_cast<RWops&>(second));
+		swap(first.stream_, second.stream_);
+	}
+
+private:
+	// what's adapted into the RWops
+	class Stream;
+
+	// owned by the RWops
+	Stream *stream_;
+};
+
+class PrefetchRWops::Stream {
+public:
+	Stream(RWops source, size_t bufferSize, size_t readSize);
+	~Stream();
+
+	// for RWops::adapt(). There's no write(), so writing fails.
+	Sint64 size() { return size_; }
+	Sint64 seek(Sint64 offset, int whence);
+	size_t read(void *ptr, size_t size, size_t maxnum);
+
+	size_t getBuffered() const { return ring_.available(); }
+
+	Stream(const Stream &that) = delete;
+	Stream & operator=(const Stream &that) = delete;
+private:
+	void work();
+
+	RWops source_;
+	Sint64 size_;
+	size_t readSize_;
+	SpscRing<Uint8> ring_;
+	// the reader's position
+	Sint64 position_;
+
+	// shared with the worker
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	// set by the worker; the reader may check them without the mutex
+	std::atomic<bool> end_; // of the source, or an error
+	std::atomic<bool> idle_; // waiting for room in the ring
+	bool seeking_;
+	Sint64 seekTo_;
+	std::string error_;
+	bool quit_;
+	std::thread worker_;
+};
+
+PrefetchRWops::PrefetchRWops(RWops source, size_t bufferSize,
+	size_t readSize)
+	: RWops(RWops::adapt(std::unique_ptr<Stream>(new Stream(
+		std::move(source), bufferSize, readSize)))),
+	stream_{target<Stream>()}
+{}
+
+size_t PrefetchRWops::getBuffered() const
+{
+	return stream_->getBuffered();
+}
+
+PrefetchRWops::Stream::Stream(RWops source, size_t bufferSize,
+	size_t readSize)
+	: source_(std::move(source)), size_{source_.size()},
+	readSize_{readSize}, ring_(bufferSize), end_{false}, idle_{false},
+	seeking_{false}, seekTo_{0}, quit_{false}
+{
+	if(bufferSize == 0 || readSize == 0 || readSize > bufferSize) {
+		throw std::runtime_error("PrefetchRWops: invalid buffer or "
+			"read size");
+	}
+	// not all sources can tell (pipes, for instance)
+	position_ = std::max<Sint64>(source_.tell(), 0);
+	// started last, so the ctor can still throw without joining it
+	worker_ = std::thread(&Stream::work, this);
+}
+
+PrefetchRWops::Stream::~Stream()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	cond_.notify_all();
+	worker_.join();
+}
+
+Sint64 PrefetchRWops::Stream::seek(Sint64 offset, int whence)
+{
+	Sint64 target;
+	switch(whence) {
+	case RW_SEEK_SET: target = offset; break;
+	case RW_SEEK_CUR: target = position_ + offset; break;
+	case RW_SEEK_END:
+		if(size_ < 0) {
+			SDL_SetError("PrefetchRWops: the source's size is unknown");
+			return -1;
+		}
+		target = size_ + offset;
+		break;
+	default:
+		SDL_SetError("PrefetchRWops: invalid whence");
+		return -1;
+	}
+	if(target < 0) {
+		SDL_SetError("PrefetchRWops: seeking before the start");
+		return -1;
+	}
+	if(target == position_) {
+		return position_; // tell() mustn't wait
+	}
+	Sint64 ahead = target - position_;
+	if(ahead > 0 && static_cast<size_t>(ahead) <= ring_.available()) {
+		ring_.skip(ahead);
+		position_ = target;
+		if(idle_.load()) {
+			cond_.notify_all();
+		}
+		return position_;
+	}
+	// the worker clears the ring and seeks the source; this waits for it
+	std::unique_lock<std::mutex> lock(mutex_);
+	seeking_ = true;
+	seekTo_ = target;
+	cond_.notify_all();
+	cond_.wait(lock, [this]() { return !seeking_; });
+	if(!error_.empty()) {
+		SDL_SetError("%s", error_.c_str());
+		error_.clear();
+		return -1;
+	}
+	position_ = target;
+	return position_;
+}
+
+size_t PrefetchRWops::Stream::read(void *ptr, size_t size, size_t maxnum)
+{
+	if(size == 0 || maxnum == 0) {
+		return 0;
+	}
+	Uint8 *dst = static_cast<Uint8*>(ptr);
+	size_t wanted = size * maxnum;
+	size_t done = ring_.pop(dst, wanted);
+	while(done < wanted) {
+		// the worker's behind (or done); only now is the mutex needed
+		std::unique_lock<std::mutex> lock(mutex_);
+		cond_.notify_all(); // in case it's idle
+		cond_.wait(lock, [this]() {
+			return ring_.available() > 0 || end_.load();
+		});
+		size_t count = ring_.pop(dst + done, wanted - done);
+		done += count;
+		if(count == 0) {
+			// the end of the source
+			if(!error_.empty()) {
+				SDL_SetError("%s", error_.c_str());
+				error_.clear();
+			}
+			break;
+		}
+	}
+	if(idle_.load()) {
+		// there's room for it now. If the notification's lost, it'll
+		// look again soon anyway.
+		cond_.notify_all();
+	}
+	position_ += done;
+	return done / size;
+}
+
+void PrefetchRWops::Stream::work()
+{
+	// how often to look for room, when nobody says there's some
+	const std::chrono::milliseconds POLL_INTERVAL(10);
+	std::vector<Uint8> chunk(readSize_);
+	std::unique_lock<std::mutex> lock(mutex_);
+	while(!quit_) {
+		if(seeking_) {
+			// the reader's waiting, so it's safe to clear the ring
+			ring_.clear();
+			end_.store(false);
+			if(source_.seek(seekTo_, RW_SEEK_SET) < 0) {
+				error_ = SDL_GetError();
+				end_.store(true);
+			}
+			seeking_ = false;
+			cond_.notify_all();
+			continue;
+		}
+		if(end_.load() || ring_.space() < readSize_) {
+			idle_.store(true);
+			cond_.wait_for(lock, POLL_INTERVAL);
+			idle_.store(false);
+			continue;
+		}
+		lock.unlock();
+		SDL_ClearError();
+		size_t count = source_.read(chunk.data(), 1, readSize_);
+		std::string error = count == 0 ? SDL_GetError() : "";
+		ring_.push(chunk.data(), count);
+		lock.lock();
+		if(count == 0) {
+			// SDL_RWread() returns 0 both at the end and on errors
+			error_ = error;
+			end_.store(true);
+		}
+		cond_.notify_all();
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_PREFETCHRWOPS_HPP
@@ -28,6 +28,11 @@
 #include "cstylealloc.hpp"
 #include "texture.hpp"
 
+#ifdef HAVE_SDL_TTF
+# include <unordered_map>
+# include "glyphatlas.hpp"
+#endif
+
 namespace SDL {
 
 class Window;
@@ -189,8 +194,24 @@ public:
 			rects.size()) >= 0;
 	}
 
-	// TODO readPixels(), updateTexture(), setClip(), getClip(),
-	// isClipEnabled()
+#ifdef HAVE_SDL_TTF
+	// Draws utf8 on one line, with its top-left at (x, y), from the font's
+	// glyph atlas for this renderer (made on first use; see GlyphAtlas).
+	// Unlike making a Texture from the text, this allocates nothing once
+	// the glyphs have been drawn before.
+	bool drawText(TrueTypeFont &font, const char *utf8, int x, int y,
+		SDL_Color color);
+	// how wide drawText() would draw it
+	int measureText(TrueTypeFont &font, const char *utf8);
+	// frees the font's atlas now. Atlases of fonts that are gone are
+	// freed anyway, the next time one's made for a new font.
+	void forgetFont(const TrueTypeFont &font)
+	{
+		atlases_.erase(font.getId());
+	}
+#endif
+
+	// TODO readPixels(), setClip(), getClip(), isClipEnabled()
 
 	// renderers must NOT be copied. They belong to 1 window only.
 	Renderer(const Renderer &that) = delete;
@@ -201,6 +222,9 @@ public:
 	{
 		using std::swap;
 		swap(first.renderer_, second.renderer_);
+#ifdef HAVE_SDL_TTF
+		swap(first.atlases_, second.atlases_);
+#endif
 	}
 
 	struct Deleter {
@@ -210,7 +234,16 @@ public:
 		}
 	};
 private:
+#ifdef HAVE_SDL_TTF
+	GlyphAtlas &atlasOf(const TrueTypeFont &font);
+#endif
+
 	std::unique_ptr<SDL_Renderer, Deleter> renderer_;
+#ifdef HAVE_SDL_TTF
+	// by font id. Declared after renderer_, so their textures are
+	// destroyed before it.
+	std::unordered_map<Uint64, std::unique_ptr<GlyphAtlas>> atlases_;
+#endif
 };
 
 Renderer::Renderer(SDL_Window *window, Uint32 flags)
@@ -247,6 +280,38 @@ bool Renderer::setTarget(SDL_Texture *texture)
 	return SDL_SetRenderTarget(renderer_.get(), texture) >= 0;
 }
 
+#ifdef HAVE_SDL_TTF
+bool Renderer::drawText(TrueTypeFont &font, const char *utf8, int x, int y,
+	SDL_Color color)
+{
+	return atlasOf(font).draw(font, utf8, x, y, color);
+}
+
+int Renderer::measureText(TrueTypeFont &font, const char *utf8)
+{
+	return atlasOf(font).measure(font, utf8);
+}
+
+GlyphAtlas &Renderer::atlasOf(const TrueTypeFont &font)
+{
+	auto found = atlases_.find(font.getId());
+	if(found != atlases_.end()) {
+		return *found->second;
+	}
+	// font ids aren't reused, so otherwise these would pile up
+	for(auto i = atlases_.begin(); i != atlases_.end(); ) {
+		if(i->second->isFontAlive()) {
+			++i;
+		} else {
+			i = atlases_.erase(i);
+		}
+	}
+	std::unique_ptr<GlyphAtlas> &atlas = atlases_[font.getId()];
+	atlas.reset(new GlyphAtlas(renderer_.get(), font));
+	return *atlas;
+}
+#endif
+
 } // namespace SDL
 
 #endif
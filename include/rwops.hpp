@@ -23,15 +23,28 @@
 #define SCC_RWOPS_HPP
 
 #include <memory>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#include <utility>
 #include "null.hpp"
 #include "cstylealloc.hpp"
 
+// loads are only counted (see IOStats) where asked for, so that the rest
+// needn't pull in its threading headers
+#ifdef HAVE_IOSTATS
+# include "iostats.hpp"
+#endif
+
 namespace SDL {
 
 class RWops {
 	template <typename Deleter> friend struct FromRWops; // defined below
 public:
 	RWops(const char *filename, const char *mode); // fromFile
+	// note: for memory that grows as it's written to, or that's bigger
+	// than an int can tell, see MemoryRWops
 	RWops(void *memory, int size); // fromMem
 	RWops(const void *memory, int size); // fromConstMem
 
@@ -48,6 +61,7 @@ public:
 	//   responsible for deallocating what they point to, but if you do
 	//   that and the ctor throws, the dtor will never be called
 	//   (hence, neither will close()) and you'll have a memory leak.
+	// - adapt() (below) has none of these problems, so prefer it
 	RWops(
 		decltype(SDL_RWops::size) size,
 		decltype(SDL_RWops::seek) seek,
@@ -59,6 +73,31 @@ public:
 		void *data2 = NULL  // hidden.unknown
 	);
 
+	// Makes a RWops out of any object that has some of these members:
+	//	Sint64 size();
+	//	Sint64 seek(Sint64 offset, int whence);
+	//	size_t read(void *ptr, size_t size, size_t maxnum);
+	//	size_t write(const void *ptr, size_t size, size_t num);
+	// with the same meaning as their SDL_RWops counterparts. Operations
+	// the object doesn't have fail (and call SDL_SetError()).
+	// std::istream, std::ostream and std::iostream (and derived classes,
+	// eg std::stringstream) are adapted through their own interface.
+	//
+	// Notes:
+	// - the object is moved (or copied) into the RWops, which owns it from
+	//   then on: it's destroyed when the RWops is. For objects that can't
+	//   be moved, pass a std::unique_ptr to them instead.
+	// - nothing leaks if this throws
+	// - the SDL_RWops callbacks are generated for T at compile time and
+	//   call T's members directly, so they can be inlined into them
+	template <typename T>
+	static RWops adapt(T &&object, Uint32 type = SDL_RWOPS_UNKNOWN);
+
+	// Like std::function::target(): the object inside a RWops made by
+	// adapt(), or NULL if this RWops wasn't made by adapt() from a T.
+	template <typename T> T *target();
+	template <typename T> const T *target() const;
+
 	// wrappers around SDL_RW* functions. The args and return value are the
 	// same as in SDL.
 	// There's no wrapper around SDL_RWclose() because that will only be
@@ -78,6 +117,11 @@ public:
 	}
 	Sint64 tell() const { return SDL_RWtell(rwops_.get()); }
 
+	// What IOStats counts loads from this under. Only the file ctor sets
+	// it (to the filename); name the others for them to be told apart.
+	const std::string &getName() const { return name_; }
+	void setName(std::string name) { name_ = std::move(name); }
+
 	RWops(const RWops &that) = delete;
 	RWops(RWops &&that) = default;
 	~RWops() = default;
@@ -86,15 +130,224 @@ public:
 	{
 		using std::swap;
 		swap(first.rwops_, second.rwops_);
+		swap(first.name_, second.name_);
 	}
 
 	struct Deleter {
 		void operator()(SDL_RWops *rwops) { SDL_RWclose(rwops); }
 	};
 private:
+	// the SDL_RWops callbacks for adapt<T>()
+	template <typename T> struct Adapter;
+
+	template <typename T>
+	static std::unique_ptr<T> own(std::unique_ptr<T> &&object)
+	{
+		return std::move(object);
+	}
+	template <typename T>
+	static std::unique_ptr<typename std::decay<T>::type> own(T &&object)
+	{
+		using U = typename std::decay<T>::type;
+		return std::unique_ptr<U>(new U(std::forward<T>(object)));
+	}
+
 	std::unique_ptr<SDL_RWops, Deleter> rwops_;
+	std::string name_;
 };
 
+// Each operation is dispatched at compile time to (in order of preference):
+// T's own member, T's std::istream/std::ostream interface, or a stub that
+// fails. The preference is expressed by overload ranking: Member converts
+// to Stream, which converts to Missing.
+template <typename T>
+struct RWops::Adapter {
+	// its address tells RWops made from different types apart
+	static char tag;
+
+	static Sint64 size(SDL_RWops *rwops)
+	{
+		return callSize(object(rwops), Member());
+	}
+	static Sint64 seek(SDL_RWops *rwops, Sint64 offset, int whence)
+	{
+		return callSeek(object(rwops), offset, whence, Member());
+	}
+	static size_t read(SDL_RWops *rwops, void *ptr, size_t size,
+		size_t maxnum)
+	{
+		return callRead(object(rwops), ptr, size, maxnum, Member());
+	}
+	static size_t write(SDL_RWops *rwops, const void *ptr, size_t size,
+		size_t num)
+	{
+		return callWrite(object(rwops), ptr, size, num, Member());
+	}
+	static int close(SDL_RWops *rwops)
+	{
+		if(rwops != NULL) {
+			delete &object(rwops);
+			SDL_FreeRW(rwops);
+		}
+		return 0;
+	}
+
+private:
+	struct Missing {};
+	struct Stream : Missing {};
+	struct Member : Stream {};
+
+	template <typename U>
+	using IsIn = std::is_base_of<std::istream, U>;
+	template <typename U>
+	using IsOut = std::is_base_of<std::ostream, U>;
+
+	static T &object(SDL_RWops *rwops)
+	{
+		return *static_cast<T*>(rwops->hidden.unknown.data1);
+	}
+
+	// size()
+	template <typename U>
+	static auto callSize(U &u, Member) -> decltype(Sint64(u.size()))
+	{
+		return u.size();
+	}
+	template <typename U>
+	static auto callSize(U &u, Stream) -> typename std::enable_if<
+		IsIn<U>::value || IsOut<U>::value, Sint64>::type
+	{
+		Sint64 current = callSeek(u, 0, RW_SEEK_CUR, Stream());
+		Sint64 end = callSeek(u, 0, RW_SEEK_END, Stream());
+		callSeek(u, current, RW_SEEK_SET, Stream());
+		return current < 0 ? -1 : end;
+	}
+	static Sint64 callSize(T &, Missing)
+	{
+		SDL_SetError("RWops: adapted object has no size");
+		return -1;
+	}
+
+	// seek()
+	template <typename U>
+	static auto callSeek(U &u, Sint64 offset, int whence, Member)
+	-> decltype(Sint64(u.seek(offset, whence)))
+	{
+		return u.seek(offset, whence);
+	}
+	template <typename U>
+	static auto callSeek(U &u, Sint64 offset, int whence, Stream)
+	-> typename std::enable_if<
+		IsIn<U>::value || IsOut<U>::value, Sint64>::type
+	{
+		std::ios_base::seekdir direction;
+		switch(whence) {
+		case RW_SEEK_SET:
+			direction = std::ios_base::beg;
+		break;
+		case RW_SEEK_CUR:
+			direction = std::ios_base::cur;
+		break;
+		case RW_SEEK_END:
+			direction = std::ios_base::end;
+		break;
+		default:
+			SDL_SetError("RWops: unknown value for 'whence'");
+			return -1;
+		}
+		// input and output positions move together, like in a file
+		u.clear();
+		Sint64 in = seekIn(u, offset, direction, IsIn<U>());
+		Sint64 out = seekOut(u, offset, direction, IsOut<U>());
+		if(in < 0 && out < 0) {
+			SDL_SetError("RWops: seeking adapted stream failed");
+			return -1;
+		}
+		return in >= 0 ? in : out;
+	}
+	static Sint64 callSeek(T &, Sint64, int, Missing)
+	{
+		SDL_SetError("RWops: adapted object can't seek");
+		return -1;
+	}
+
+	static Sint64 seekIn(std::istream &s, Sint64 offset,
+		std::ios_base::seekdir direction, std::true_type)
+	{
+		s.seekg(offset, direction);
+		return s.fail() ? -1 : static_cast<Sint64>(s.tellg());
+	}
+	static Sint64 seekIn(T &, Sint64, std::ios_base::seekdir,
+		std::false_type)
+	{
+		return -1;
+	}
+	static Sint64 seekOut(std::ostream &s, Sint64 offset,
+		std::ios_base::seekdir direction, std::true_type)
+	{
+		s.seekp(offset, direction);
+		return s.fail() ? -1 : static_cast<Sint64>(s.tellp());
+	}
+	static Sint64 seekOut(T &, Sint64, std::ios_base::seekdir,
+		std::false_type)
+	{
+		return -1;
+	}
+
+	// read()
+	template <typename U>
+	static auto callRead(U &u, void *ptr, size_t size, size_t maxnum,
+		Member) -> decltype(size_t(u.read(ptr, size, maxnum)))
+	{
+		return u.read(ptr, size, maxnum);
+	}
+	template <typename U>
+	static auto callRead(U &u, void *ptr, size_t size, size_t maxnum,
+		Stream) -> typename std::enable_if<IsIn<U>::value, size_t>::type
+	{
+		if(size == 0) {
+			return 0;
+		}
+		u.read(static_cast<char*>(ptr), size * maxnum);
+		size_t bytes = static_cast<size_t>(u.gcount());
+		u.clear(); // for SDL, reaching the end isn't an error
+		return bytes / size;
+	}
+	static size_t callRead(T &, void *, size_t, size_t, Missing)
+	{
+		SDL_SetError("RWops: adapted object can't be read from");
+		return 0;
+	}
+
+	// write()
+	template <typename U>
+	static auto callWrite(U &u, const void *ptr, size_t size, size_t num,
+		Member) -> decltype(size_t(u.write(ptr, size, num)))
+	{
+		return u.write(ptr, size, num);
+	}
+	template <typename U>
+	static auto callWrite(U &u, const void *ptr, size_t size, size_t num,
+		Stream) -> typename std::enable_if<IsOut<U>::value, size_t>::type
+	{
+		u.write(static_cast<const char*>(ptr), size * num);
+		if(!u) {
+			u.clear();
+			SDL_SetError("RWops: writing to adapted stream failed");
+			return 0;
+		}
+		return num;
+	}
+	static size_t callWrite(T &, const void *, size_t, size_t, Missing)
+	{
+		SDL_SetError("RWops: adapted object can't be written to");
+		return 0;
+	}
+};
+
+template <typename T>
+char RWops::Adapter<T>::tag = 0;
+
 // Class that actually allows loading from RWops, while ensuring freesrc will
 // always be false (only the dtor should free the SDL_RWops)
 //
@@ -108,6 +361,8 @@ struct FromRWops {
 	// after the rwops pointer (otherwise, use std::bind or a lambda).
 	// freesrc is assumed to mean whether or not rwops should be freed,
 	// and 0 means it shouldn't.
+	// With HAVE_IOSTATS defined, and while IOStats is enabled, the load
+	// is counted under rwops' name.
 	template<typename F, typename ... Args>
 	static auto load(const RWops& rwops, F f, const char *errorMsg,
 		Args&& ... args)
@@ -115,14 +370,67 @@ struct FromRWops {
 		std::declval<const char*>(), std::declval<SDL_RWops*>(),
 		std::declval<int>(), std::declval<Args>()...))
 	{
+#ifdef HAVE_IOSTATS
+		if(IOStats::isEnabled()) {
+			IOStats::Span span(rwops.name_);
+			return CStyleAlloc<Deleter>::alloc(f, errorMsg,
+				span.wrap(rwops.rwops_.get()), 0,
+				std::forward<Args>(args)...);
+		}
+#endif
+		return CStyleAlloc<Deleter>::alloc(f, errorMsg,
+			rwops.rwops_.get(), 0, std::forward<Args>(args)...);
+	}
+
+	// Same as load(), for things that keep reading from rwops after f
+	// returns (eg Mix_Music), so the read can't be counted: the span would
+	// be gone by then.
+	template<typename F, typename ... Args>
+	static auto stream(const RWops& rwops, F f, const char *errorMsg,
+		Args&& ... args)
+	-> decltype(CStyleAlloc<Deleter>::alloc(std::declval<F>(),
+		std::declval<const char*>(), std::declval<SDL_RWops*>(),
+		std::declval<int>(), std::declval<Args>()...))
+	{
 		return CStyleAlloc<Deleter>::alloc(f, errorMsg,
 			rwops.rwops_.get(), 0, std::forward<Args>(args)...);
 	}
 };
 
+template <typename T>
+RWops RWops::adapt(T &&object, Uint32 type)
+{
+	// if the RWops ctor throws, owned still deletes the object
+	auto owned = own(std::forward<T>(object));
+	using U = typename decltype(owned)::element_type;
+	RWops rwops(Adapter<U>::size, Adapter<U>::seek, Adapter<U>::read,
+		Adapter<U>::write, Adapter<U>::close, type, owned.get(),
+		&Adapter<U>::tag);
+	owned.release(); // now it's Adapter<U>::close()'s job
+	return rwops;
+}
+
+template <typename T>
+T *RWops::target()
+{
+	if(!rwops_ || rwops_->close != Adapter<T>::close
+		|| rwops_->hidden.unknown.data2 != &Adapter<T>::tag)
+	{
+		return NULL;
+	}
+	return static_cast<T*>(rwops_->hidden.unknown.data1);
+}
+
+template <typename T>
+const T *RWops::target() const
+{
+	return const_cast<RWops*>(this)->target<T>();
+}
+
 RWops::RWops(const char *filename, const char *mode)
 	: rwops_{CStyleAlloc<RWops::Deleter>::alloc(SDL_RWFromFile,
-		"Making RWops from file failed", filename, mode)}
+		"Making RWops from file failed", filename, mode)},
+	name_{filename}
 {}
 
 RWops::RWops(void *mem, int size)
@@ -37,24 +37,65 @@
 # error "at least SDL 2.0 is needed."
 #endif
 
+// The classes that run threads or take locks are only included if
+// HAVE_THREADS is defined before this (link with -pthread then, or your
+// platform's equivalent). It turns on HAVE_IOSTATS too, so that while
+// IOStats is enabled, every load through FromRWops is counted.
+#if defined(HAVE_THREADS) && !defined(HAVE_IOSTATS)
+# define HAVE_IOSTATS
+#endif
+
 #ifdef SDL_IMAGE_MAJOR_VERSION
 # define HAVE_SDL_IMAGE
+# include "imagecache.hpp"
 #endif
 
 #ifdef SDL_TTF_MAJOR_VERSION
 # define HAVE_SDL_TTF
 # include "truetypefont.hpp"
+# include "fontregistry.hpp"
+# include "textcache.hpp"
+# include "textlayout.hpp"
 #endif
 
 #ifdef SDL_MIXER_MAJOR_VERSION
 # define HAVE_SDL_MIXER
 # include "audiochunk.hpp"
 # include "audiochannels.hpp"
+# include "audiobuses.hpp"
+# include "audiocommandqueue.hpp"
+# include "audiodevice.hpp"
+# include "audioeffects.hpp"
+# include "compressedchunk.hpp"
 # include "music.hpp"
+# include "soundtriggers.hpp"
+# include "spatialaudio.hpp"
+# include "voicemanager.hpp"
+# include "voicemixer.hpp"
+# ifdef HAVE_THREADS
+#  include "audioloader.hpp"
+#  include "offlinemixer.hpp"
+#  include "playlist.hpp"
+#  include "soundbank.hpp"
+#  include "spectrumanalyzer.hpp"
+# endif
+#endif
+
+#ifdef HAVE_THREADS
+# include "chunkedrwops.hpp"
+# include "instrumentedrwops.hpp"
+# include "iostats.hpp"
+# include "parallelfor.hpp"
+# include "prefetchrwops.hpp"
+# include "writebehindrwops.hpp"
 #endif
 
 #include "glcontext.hpp"
+#include "lockfreequeue.hpp"
+#include "memoryrwops.hpp"
 #include "renderer.hpp"
+#include "spscring.hpp"
+#include "triplebuffer.hpp"
 #include "rect.hpp"
 #include "rwops.hpp"
 #include "surface.hpp"
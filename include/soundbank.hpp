@@ -0,0 +1,227 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_SOUNDBANK_HPP
+#define SCC_SOUNDBANK_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <utility>
+#include "null.hpp"
+#include "audiochunk.hpp"
+#include "audioloader.hpp"
+#include "parallelfor.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use SoundBank class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Hands out shared AudioChunks by name, so that the same sound asked for by
+// several systems is loaded (and held in memory) once. The name is the path
+// the chunk is loaded from.
+//
+// Notes:
+// - an entry is unused when no handle to it exists outside the bank and it
+//   isn't playing. Only unused entries are evicted, least recently gotten
+//   first, whenever the PCM bytes held go over the budget; so the bank
+//   can't go over it by more than what's in use.
+// - getting an evicted entry loads it again
+// - sounds are loaded with AudioLoader, by get() and preload() alike, so
+//   a name gives the same samples whichever loaded it. preload() loads on
+//   several threads at once.
+// - every member may be called from any thread, but the handles'
+//   AudioChunks should be played from one
+class SoundBank {
+public:
+	using Handle = std::shared_ptr<AudioChunk>;
+
+	static const Uint64 NO_BUDGET = ~Uint64(0);
+
+	explicit SoundBank(Uint64 budget = NO_BUDGET)
+		: bytes_{0}, budget_{budget}, clock_{0}
+	{}
+
+	// Loads name if it isn't in the bank yet. Throws std::runtime_error
+	// if it can't be loaded.
+	Handle get(const std::string &name);
+	// Loads those of names that aren't in the bank yet, on up to
+	// threadCount threads (0 means one per core), and returns once all
+	// are loaded. Throws the first load's error, skipping the rest.
+	void preload(const std::vector<std::string> &names,
+		unsigned threadCount = 0);
+
+	bool contains(const std::string &name) const;
+	size_t size() const;
+	// the PCM bytes held, in use or not
+	Uint64 getBytes() const;
+
+	Uint64 getBudget() const;
+	// evicts what's needed to fit in the new budget
+	void setBudget(Uint64 budget);
+	// evicts every unused entry
+	void trim();
+
+	SoundBank(const SoundBank &that) = delete;
+	SoundBank & operator=(const SoundBank &that) = delete;
+private:
+	struct Entry {
+		Handle chunk;
+		Uint64 lastUse;
+	};
+
+	// all of these must be called with mutex_ locked
+	// returns the one already there, if another thread got there first
+	Handle insert(const std::string &name, Handle chunk);
+	void evict(Uint64 budget);
+
+	std::unordered_map<std::string, Entry> entries_;
+	Uint64 bytes_;
+	Uint64 budget_;
+	Uint64 clock_;
+	mutable std::mutex mutex_;
+};
+
+SoundBank::Handle SoundBank::get(const std::string &name)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto found = entries_.find(name);
+		if(found != entries_.end()) {
+			found->second.lastUse = ++clock_;
+			return found->second.chunk;
+		}
+	}
+	// loaded unlocked, so other names can be gotten meanwhile
+	Handle chunk = std::make_shared<AudioChunk>(
+		AudioLoader().load(name.c_str()));
+	std::lock_guard<std::mutex> lock(mutex_);
+	return insert(name, std::move(chunk));
+}
+
+void SoundBank::preload(const std::vector<std::string> &names,
+	unsigned threadCount)
+{
+	std::vector<std::string> missing;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for(const std::string &name : names) {
+			if(entries_.find(name) == entries_.end()) {
+				missing.push_back(name);
+			}
+		}
+	}
+	if(missing.empty()) {
+		return; // not even making the loader, which needs audio open
+	}
+	// inserted as they're loaded, so that a failure doesn't waste the
+	// others
+	AudioLoader loader;
+	parallelFor(0, missing.size(), [&](size_t i) {
+		Handle chunk = std::make_shared<AudioChunk>(
+			loader.load(missing[i].c_str()));
+		std::lock_guard<std::mutex> lock(mutex_);
+		insert(missing[i], std::move(chunk));
+	}, threadCount);
+}
+
+bool SoundBank::contains(const std::string &name) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.find(name) != entries_.end();
+}
+
+size_t SoundBank::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.size();
+}
+
+Uint64 SoundBank::getBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return bytes_;
+}
+
+Uint64 SoundBank::getBudget() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return budget_;
+}
+
+void SoundBank::setBudget(Uint64 budget)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	budget_ = budget;
+	evict(budget_);
+}
+
+void SoundBank::trim()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	evict(0);
+}
+
+SoundBank::Handle SoundBank::insert(const std::string &name, Handle chunk)
+{
+	auto inserted = entries_.insert({name, Entry{chunk, ++clock_}});
+	if(!inserted.second) {
+		// ours is dropped, and the bytes it held with it
+		inserted.first->second.lastUse = clock_;
+		return inserted.first->second.chunk;
+	}
+	bytes_ += chunk->getByteLength();
+	evict(budget_);
+	return chunk;
+}
+
+void SoundBank::evict(Uint64 budget)
+{
+	// Least recently used first. A linear search per eviction is fine:
+	// banks hold hundreds of sounds, not millions, and evicting is rare.
+	while(bytes_ > budget) {
+		auto oldest = entries_.end();
+		for(auto it = entries_.begin(); it != entries_.end(); ++it) {
+			// the bank's is the only handle, so no one else can
+			// copy it meanwhile (they'd need the mutex)
+			bool unused = it->second.chunk.use_count() == 1
+				&& !it->second.chunk->isPlaying();
+			if(unused && (oldest == entries_.end()
+				|| it->second.lastUse < oldest->second.lastUse))
+			{
+				oldest = it;
+			}
+		}
+		if(oldest == entries_.end()) {
+			return; // everything left is in use
+		}
+		bytes_ -= oldest->second.chunk->getByteLength();
+		entries_.erase(oldest);
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_SOUNDBANK_HPP
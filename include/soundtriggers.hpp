@@ -0,0 +1,244 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_SOUNDTRIGGERS_HPP
+#define SCC_SOUNDTRIGGERS_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include "null.hpp"
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "voicemanager.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use SoundTriggers class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Fire-and-forget sounds, batched per frame: trigger() only takes note, and
+// flush() (once per frame) plays one voice per sound, however many times it
+// was triggered. Triggers of a sound that started playing less than the
+// merge window ago are merged into that voice instead, raising its volume.
+//
+// Notes:
+// - gains add up like uncorrelated sounds do, as the square root of the
+//   sum of their squares: 100 hits at gain 0.1 play once at gain 1. The
+//   result is capped at 1, so the output doesn't clip.
+// - the gain is the channel's volume (see AudioChannels::setVolume()),
+//   not the chunk's, so each voice has its own. The channel's volume is
+//   put back as it was once the voice ends, is halted or is replaced.
+// - a sound may be rate limited to one new voice per so many ms. Triggers
+//   in between are merged if its voice is still playing, and dropped if
+//   not.
+// - voices are played through a VoiceManager, if one is given (with the
+//   highest priority the sound was triggered with), and on the first free
+//   channel otherwise
+// - sounds are told apart by address, like in VoiceManager
+// - everything must be called from the same thread
+class SoundTriggers {
+public:
+	static const Uint32 DEFAULT_MERGE_WINDOW = 50; // ms
+
+	struct Stats {
+		Uint64 triggered;
+		Uint64 played; // new voices
+		Uint64 merged; // triggers that didn't make a voice of their own
+		Uint64 dropped; // by the rate limit or for lack of channels
+	};
+
+	// voices may be NULL
+	explicit SoundTriggers(VoiceManager *voices = NULL,
+		Uint32 mergeWindow = DEFAULT_MERGE_WINDOW)
+		: voices_{voices}, mergeWindow_{mergeWindow}, stats_()
+	{}
+
+	// gain goes from 0 to 1
+	void trigger(AudioChunk &chunk, float gain = 1.0f, Uint8 priority = 0);
+	// plays (or merges) everything triggered since the last call
+	void flush();
+
+	Uint32 getMergeWindow() const { return mergeWindow_; }
+	void setMergeWindow(Uint32 ms) { mergeWindow_ = ms; }
+	// 0 means no limit
+	void setRateLimit(const AudioChunk &chunk, Uint32 minInterval);
+
+	const Stats &getStats() const { return stats_; }
+	void resetStats() { stats_ = Stats(); }
+
+	SoundTriggers(const SoundTriggers &that) = delete;
+	SoundTriggers & operator=(const SoundTriggers &that) = delete;
+private:
+	struct Sound {
+		AudioChunk *chunk;
+		// this frame's triggers
+		float pendingPower; // the sum of the gains' squares
+		Uint64 pendingCount;
+		Uint8 priority;
+		// the last voice
+		int channel;
+		VoiceManager::Voice voice;
+		Uint32 start;
+		float power;
+		Uint32 minInterval;
+	};
+
+	Sound &soundOf(const AudioChunk &chunk);
+	bool isPlaying(const Sound &sound) const;
+	void play(Sound &sound, Uint32 now);
+
+	// Registered on each voice's channel for its done callback, which
+	// SDL_mixer calls whenever the voice stops playing; udata is the
+	// volume to put back.
+	static void keepVolume(int channel, void *stream, int len, void *udata)
+	{}
+	static void restoreVolume(int channel, void *udata)
+	{
+		AudioChannels::setVolume(channel,
+			static_cast<int>(reinterpret_cast<intptr_t>(udata)));
+	}
+	static int toVolume(float power)
+	{
+		float gain = std::min(std::sqrt(power), 1.0f);
+		return static_cast<int>(gain * MIX_MAX_VOLUME + 0.5f);
+	}
+
+	VoiceManager *voices_;
+	Uint32 mergeWindow_;
+	std::unordered_map<const AudioChunk*, Sound> sounds_;
+	// those with pending triggers, so flush() doesn't visit every sound
+	std::vector<Sound*> pending_;
+	Stats stats_;
+};
+
+void SoundTriggers::trigger(AudioChunk &chunk, float gain, Uint8 priority)
+{
+	++stats_.triggered;
+	Sound &sound = soundOf(chunk);
+	// the chunk isn't const here, for play()
+	sound.chunk = &chunk;
+	if(sound.pendingCount == 0) {
+		pending_.push_back(&sound);
+		sound.priority = priority;
+	}
+	gain = std::max(gain, 0.0f);
+	sound.pendingPower += gain * gain;
+	++sound.pendingCount;
+	sound.priority = std::max(sound.priority, priority);
+}
+
+void SoundTriggers::flush()
+{
+	Uint32 now = SDL_GetTicks();
+	for(Sound *sound : pending_) {
+		Uint32 age = now - sound->start;
+		bool limited = age < sound->minInterval;
+		if(isPlaying(*sound) && (age < mergeWindow_ || limited)) {
+			// into the voice that's already there
+			sound->power += sound->pendingPower;
+			AudioChannels::setVolume(sound->channel,
+				toVolume(sound->power));
+			stats_.merged += sound->pendingCount;
+		} else if(limited) {
+			stats_.dropped += sound->pendingCount;
+		} else {
+			play(*sound, now);
+		}
+		sound->pendingPower = 0;
+		sound->pendingCount = 0;
+	}
+	pending_.clear();
+}
+
+void SoundTriggers::setRateLimit(const AudioChunk &chunk, Uint32 minInterval)
+{
+	soundOf(chunk).minInterval = minInterval;
+}
+
+SoundTriggers::Sound &SoundTriggers::soundOf(const AudioChunk &chunk)
+{
+	auto found = sounds_.find(&chunk);
+	if(found == sounds_.end()) {
+		// a start long ago, so neither the window nor the limit apply
+		Sound sound{NULL, 0, 0, 0, -1, VoiceManager::Voice{-1, 0},
+			SDL_GetTicks() - 0x80000000u, 0, 0};
+		found = sounds_.insert({&chunk, sound}).first;
+	}
+	return found->second;
+}
+
+bool SoundTriggers::isPlaying(const Sound &sound) const
+{
+	if(sound.channel < 0) {
+		return false;
+	}
+	if(voices_ != NULL) {
+		return voices_->isPlaying(sound.voice);
+	}
+	// the channel may have moved on to another sound
+	return sound.chunk->isPlaying(sound.channel);
+}
+
+void SoundTriggers::play(Sound &sound, Uint32 now)
+{
+	// locked, so the voice isn't mixed before its volume is set (the
+	// channel isn't known before it starts)
+	SDL_LockAudio();
+	int channel;
+	if(voices_ != NULL) {
+		sound.voice = voices_->play(*sound.chunk, sound.priority);
+		channel = sound.voice.channel;
+	} else {
+		channel = sound.chunk->play(-1, 0);
+	}
+	if(channel >= 0) {
+		void *previous = reinterpret_cast<void*>(
+			static_cast<intptr_t>(AudioChannels::getVolume(channel)));
+		if(Mix_RegisterEffect(channel, keepVolume, restoreVolume,
+			previous) != 0)
+		{
+			AudioChannels::setVolume(channel,
+				toVolume(sound.pendingPower));
+		} else {
+			// its volume couldn't be put back
+			Mix_HaltChannel(channel);
+			channel = -1;
+		}
+	}
+	SDL_UnlockAudio();
+	if(channel < 0) {
+		stats_.dropped += sound.pendingCount;
+		return;
+	}
+	sound.channel = channel;
+	sound.start = now;
+	sound.power = sound.pendingPower;
+	++stats_.played;
+	stats_.merged += sound.pendingCount - 1;
+}
+
+} // namespace SDL
+
+#endif // SCC_SOUNDTRIGGERS_HPP
@@ -0,0 +1,492 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_SPATIALAUDIO_HPP
+#define SCC_SPATIALAUDIO_HPP
+
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "null.hpp"
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "voicemanager.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use SpatialAudio class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Positions sounds around a listener, with the channels of a VoiceManager.
+// Positions are only stored when they're set; update(), once a frame,
+// works out every emitter's gain and panning in one pass, gives channels
+// to the ones that are loud enough (the most important and loudest, up to
+// the manager's channel count) and sets the volume and panning of all of
+// them while holding the audio lock once, so they change together, in
+// the same callback.
+//
+// Emitters that don't get a channel are virtual: they keep being
+// positioned, and get one when they're loud enough again.
+// Notes:
+// - looping emitters start over when they come back. One-shots that
+//   haven't started yet wait, virtual, for as long as they would have
+//   played; once they've started, going virtual stops them for good.
+// - distances attenuate as minDistance / (minDistance + rolloff *
+//   (distance - minDistance)) past minDistance, and emitters past
+//   maxDistance are silent. The units don't matter, as long as they're
+//   all the same.
+// - it uses each voice's channel volume and SDL_mixer's panning, so
+//   nothing else should set those on its channels. The volume's put back
+//   as it was once the voice stops.
+// - update() calls the manager's update(). Voices the manager stops
+//   (to make room for others played through it) become virtual.
+// - everything must be called from the same thread as the manager's calls
+class SpatialAudio {
+public:
+	struct Vector {
+		float x, y, z;
+	};
+
+	// a positioned sound. Becomes stale when it ends or is stopped.
+	struct Emitter {
+		int index;
+		Uint32 serial;
+	};
+
+	struct Stats {
+		int active; // emitters, real or virtual
+		int real; // of those, how many have a channel
+		Uint64 culled; // one-shots stopped for being too quiet
+	};
+
+	// Throws std::runtime_error if audio isn't open.
+	explicit SpatialAudio(VoiceManager &voices);
+	// stops its voices
+	~SpatialAudio();
+
+	// right is the direction to the listener's right, of length 1
+	void setListener(Vector position, Vector right);
+	void setDistanceModel(float minDistance, float maxDistance,
+		float rolloff = 1.0f);
+	// below this gain, emitters are virtual. 0.01 (-40 dB) by default.
+	void setThreshold(float gain) { threshold_ = gain; }
+
+	// It's played (or not) by the next update(). Priority goes from 0 (the
+	// least important) to 255.
+	Emitter play(AudioChunk &chunk, Vector position, float gain = 1.0f,
+		Uint8 priority = 0, int loops = 0);
+	void stop(Emitter emitter);
+	// whether it hasn't ended, even if it's virtual
+	bool isPlaying(Emitter emitter) const;
+	bool isReal(Emitter emitter) const;
+
+	void setPosition(Emitter emitter, Vector position);
+	// for many at once; stale emitters are skipped
+	void setPositions(const Emitter *emitters, const Vector *positions,
+		size_t count);
+	void setGain(Emitter emitter, float gain);
+
+	void update();
+
+	Stats getStats() const;
+
+	SpatialAudio(const SpatialAudio &that) = delete;
+	SpatialAudio & operator=(const SpatialAudio &that) = delete;
+private:
+	struct State {
+		AudioChunk *chunk;
+		Uint32 serial;
+		bool active;
+		Uint8 priority;
+		int loops;
+		bool started; // one-shots only start once
+		Uint32 end; // in ticks, for one-shots
+		VoiceManager::Voice voice; // channel -1 while virtual
+		// what was last set on the channel
+		Uint8 volume, left, right;
+		int oldVolume; // the channel's, from before
+	};
+
+	bool valid(Emitter emitter) const;
+	int allocate();
+	void release(int index);
+	// works out level_ and pan_, for every emitter
+	void spatialize();
+	// the square root of squared, which must be finite and not negative,
+	// to within float's precision. std::sqrt() may set errno, and that
+	// branch keeps spatialize() from being vectorized.
+	static float root(float squared);
+	// stops the voice, if any, putting the channel back as it was
+	void virtualize(State &state);
+	void apply(int index);
+
+	VoiceManager &voices_;
+	int frequency_;
+	int frameSize_;
+	Vector listener_, right_;
+	float minDistance_, maxDistance_, rolloff_, threshold_;
+	std::vector<State> states_;
+	std::vector<int> free_;
+	// one per emitter, apart from states_, so spatialize() runs
+	// through plain arrays
+	std::vector<float> x_, y_, z_, gain_;
+	std::vector<float> level_, pan_;
+	std::vector<int> candidates_;
+	std::vector<float> scores_;
+	std::vector<bool> chosen_;
+	Uint64 culled_;
+};
+
+SpatialAudio::SpatialAudio(VoiceManager &voices)
+	: voices_(voices), listener_{0, 0, 0}, right_{1, 0, 0},
+	minDistance_{1.0f}, maxDistance_{1000.0f}, rolloff_{1.0f},
+	threshold_{0.01f}, culled_{0}
+{
+	Uint16 format;
+	int channels;
+	if(Mix_QuerySpec(&frequency_, &format, &channels) == 0) {
+		throw std::runtime_error("Making spatial audio failed: audio "
+			"isn't open");
+	}
+	frameSize_ = SDL_AUDIO_BITSIZE(format) / 8 * channels;
+}
+
+SpatialAudio::~SpatialAudio()
+{
+	SDL_LockAudio();
+	for(State &state : states_) {
+		if(state.active) {
+			virtualize(state);
+		}
+	}
+	SDL_UnlockAudio();
+}
+
+void SpatialAudio::setListener(Vector position, Vector right)
+{
+	listener_ = position;
+	right_ = right;
+}
+
+void SpatialAudio::setDistanceModel(float minDistance, float maxDistance,
+	float rolloff)
+{
+	minDistance_ = minDistance;
+	maxDistance_ = maxDistance;
+	rolloff_ = rolloff;
+}
+
+SpatialAudio::Emitter SpatialAudio::play(AudioChunk &chunk,
+	Vector position, float gain, Uint8 priority, int loops)
+{
+	int index = allocate();
+	State &state = states_[index];
+	state.chunk = &chunk;
+	state.active = true;
+	state.priority = priority;
+	state.loops = loops;
+	state.started = false;
+	state.end = 0;
+	if(loops >= 0) {
+		Uint64 frames = chunk.getByteLength() / frameSize_;
+		Uint64 ms = (frames * 1000 + frequency_ - 1) / frequency_;
+		state.end = SDL_GetTicks() + static_cast<Uint32>(ms * (loops + 1));
+	}
+	state.voice = VoiceManager::Voice{-1, 0};
+	x_[index] = position.x;
+	y_[index] = position.y;
+	z_[index] = position.z;
+	gain_[index] = gain;
+	return Emitter{index, state.serial};
+}
+
+void SpatialAudio::stop(Emitter emitter)
+{
+	if(!valid(emitter)) {
+		return;
+	}
+	SDL_LockAudio();
+	virtualize(states_[emitter.index]);
+	SDL_UnlockAudio();
+	release(emitter.index);
+}
+
+bool SpatialAudio::isPlaying(Emitter emitter) const
+{
+	return valid(emitter);
+}
+
+bool SpatialAudio::isReal(Emitter emitter) const
+{
+	return valid(emitter) && states_[emitter.index].voice.channel >= 0;
+}
+
+void SpatialAudio::setPosition(Emitter emitter, Vector position)
+{
+	if(valid(emitter)) {
+		x_[emitter.index] = position.x;
+		y_[emitter.index] = position.y;
+		z_[emitter.index] = position.z;
+	}
+}
+
+void SpatialAudio::setPositions(const Emitter *emitters,
+	const Vector *positions, size_t count)
+{
+	for(size_t i = 0; i < count; ++i) {
+		setPosition(emitters[i], positions[i]);
+	}
+}
+
+void SpatialAudio::setGain(Emitter emitter, float gain)
+{
+	if(valid(emitter)) {
+		gain_[emitter.index] = gain;
+	}
+}
+
+void SpatialAudio::update()
+{
+	// emitters hold on to their channel unless others are this much louder
+	const float HYSTERESIS = 2.0f; // 6 dB
+
+	voices_.update();
+	spatialize();
+	Uint32 now = SDL_GetTicks();
+
+	// what's ended, and what's loud enough for a channel
+	candidates_.clear();
+	for(int i = 0; i < static_cast<int>(states_.size()); ++i) {
+		State &state = states_[i];
+		if(!state.active) {
+			continue;
+		}
+		bool real = state.voice.channel >= 0;
+		if(real && !voices_.isPlaying(state.voice)) {
+			// it ended, or the manager stopped it
+			state.voice.channel = -1;
+			real = false;
+			if(state.loops >= 0) {
+				release(i);
+				continue;
+			}
+		}
+		if(state.loops >= 0 && !state.started
+			&& static_cast<Sint32>(now - state.end) >= 0)
+		{
+			// it'd be over by now
+			release(i);
+			continue;
+		}
+		// one-shots only get one go
+		bool due = real || state.loops < 0 || !state.started;
+		if(level_[i] >= threshold_ && due) {
+			candidates_.push_back(i);
+		}
+	}
+
+	// the most important, then loudest, get the channels
+	size_t channels = voices_.getChannelCount();
+	if(candidates_.size() > channels) {
+		scores_.assign(states_.size(), 0.0f);
+		for(int i : candidates_) {
+			float level = level_[i];
+			if(states_[i].voice.channel >= 0) {
+				level *= HYSTERESIS;
+			}
+			scores_[i] = states_[i].priority + std::min(level, 0.999f);
+		}
+		std::nth_element(candidates_.begin(),
+			candidates_.begin() + channels, candidates_.end(),
+			[this](int a, int b) { return scores_[a] > scores_[b]; });
+		candidates_.resize(channels);
+	}
+
+	chosen_.assign(states_.size(), false);
+	for(int i : candidates_) {
+		chosen_[i] = true;
+	}
+
+	SDL_LockAudio();
+	// channels are freed first, so the ones played don't steal ours
+	for(int i = 0; i < static_cast<int>(states_.size()); ++i) {
+		State &state = states_[i];
+		if(state.active && state.voice.channel >= 0 && !chosen_[i]) {
+			virtualize(state);
+			if(state.loops >= 0) {
+				++culled_;
+				release(i);
+			}
+		}
+	}
+	for(int i : candidates_) {
+		apply(i);
+	}
+	SDL_UnlockAudio();
+}
+
+SpatialAudio::Stats SpatialAudio::getStats() const
+{
+	Stats stats = Stats();
+	for(const State &state : states_) {
+		if(state.active) {
+			++stats.active;
+			if(state.voice.channel >= 0) {
+				++stats.real;
+			}
+		}
+	}
+	stats.culled = culled_;
+	return stats;
+}
+
+bool SpatialAudio::valid(Emitter emitter) const
+{
+	return emitter.index >= 0
+		&& emitter.index < static_cast<int>(states_.size())
+		&& states_[emitter.index].active
+		&& states_[emitter.index].serial == emitter.serial;
+}
+
+int SpatialAudio::allocate()
+{
+	if(!free_.empty()) {
+		int index = free_.back();
+		free_.pop_back();
+		return index;
+	}
+	states_.push_back(State());
+	states_.back().serial = 0;
+	for(std::vector<float> *array : {&x_, &y_, &z_, &gain_, &level_,
+		&pan_})
+	{
+		array->push_back(0.0f);
+	}
+	return static_cast<int>(states_.size()) - 1;
+}
+
+void SpatialAudio::release(int index)
+{
+	State &state = states_[index];
+	state.active = false;
+	state.chunk = NULL;
+	++state.serial;
+	gain_[index] = 0.0f;
+	free_.push_back(index);
+}
+
+void SpatialAudio::spatialize()
+{
+	// no branches (root() has none either), and arrays apart, so GCC
+	// vectorizes this at -O3
+	const int n = static_cast<int>(states_.size());
+	const float lx = listener_.x, ly = listener_.y, lz = listener_.z;
+	const float rx = right_.x, ry = right_.y, rz = right_.z;
+	const float minDistance = minDistance_, maxDistance = maxDistance_;
+	const float rolloff = rolloff_;
+	const float *x = x_.data(), *y = y_.data(), *z = z_.data();
+	const float *gain = gain_.data();
+	float *level = level_.data(), *pan = pan_.data();
+	for(int i = 0; i < n; ++i) {
+		float dx = x[i] - lx, dy = y[i] - ly, dz = z[i] - lz;
+		float distance = root(dx * dx + dy * dy + dz * dz);
+		float clamped = std::max(distance, minDistance);
+		float attenuation = minDistance
+			/ (minDistance + rolloff * (clamped - minDistance));
+		float audible = distance <= maxDistance ? 1.0f : 0.0f;
+		level[i] = gain[i] * attenuation * audible;
+		// right's length is 1, and so's pan's at most
+		pan[i] = (dx * rx + dy * ry + dz * rz) / std::max(clamped, 1e-6f);
+	}
+}
+
+float SpatialAudio::root(float squared)
+{
+	// Newton's method on the reciprocal square root, from the usual
+	// guess; three steps get it to float's precision. 0 gives 0.
+	Uint32 bits;
+	std::memcpy(&bits, &squared, sizeof(bits));
+	bits = 0x5f3759df - (bits >> 1);
+	float reciprocal;
+	std::memcpy(&reciprocal, &bits, sizeof(reciprocal));
+	for(int i = 0; i < 3; ++i) {
+		reciprocal *= 1.5f - 0.5f * squared * reciprocal * reciprocal;
+	}
+	return squared * reciprocal;
+}
+
+void SpatialAudio::virtualize(State &state)
+{
+	if(state.voice.channel < 0) {
+		return;
+	}
+	int channel = state.voice.channel;
+	if(voices_.isPlaying(state.voice)) {
+		voices_.stop(state.voice);
+	}
+	// the panning went with the voice
+	AudioChannels::setVolume(channel, state.oldVolume);
+	state.voice.channel = -1;
+}
+
+void SpatialAudio::apply(int index)
+{
+	const float PI = 3.14159265f;
+
+	State &state = states_[index];
+	bool started = state.voice.channel >= 0;
+	if(!started) {
+		state.voice = voices_.play(*state.chunk, state.priority,
+			state.loops);
+		if(state.voice.channel < 0) {
+			return;
+		}
+		state.started = true;
+		state.oldVolume = AudioChannels::getVolume(state.voice.channel);
+	}
+	float level = std::min(level_[index], 1.0f);
+	Uint8 volume = static_cast<Uint8>(level * MIX_MAX_VOLUME + 0.5f);
+	// equal power, with both at full in the middle
+	float angle = (std::max(-1.0f, std::min(pan_[index], 1.0f)) + 1.0f)
+		* PI / 4;
+	float scale = 255 * std::sqrt(2.0f);
+	Uint8 left = static_cast<Uint8>(std::min(std::cos(angle) * scale,
+		255.0f));
+	Uint8 right = static_cast<Uint8>(std::min(std::sin(angle) * scale,
+		255.0f));
+	int channel = state.voice.channel;
+	if(!started || volume != state.volume) {
+		AudioChannels::setVolume(channel, volume);
+		state.volume = volume;
+	}
+	if(!started || left != state.left || right != state.right) {
+		AudioChannels::setPanning(channel, left, right);
+		state.left = left;
+		state.right = right;
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_SPATIALAUDIO_HPP
@@ -0,0 +1,324 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_SPECTRUMANALYZER_HPP
+#define SCC_SPECTRUMANALYZER_HPP
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include "null.hpp"
+#include "spscring.hpp"
+#include "triplebuffer.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use SpectrumAnalyzer class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Analyzes what's being played, for visualizers and meters, without the
+// game's thread touching any audio. A post-mix effect copies the mix
+// (down to mono) into a lock-free ring; a worker takes it from there and
+// works out its spectrum (a Hann-windowed FFT), RMS and peak, every
+// half-window of samples, publishing each result for getLatest().
+//
+// Notes:
+// - the mixer's format must be AUDIO_S16SYS or AUDIO_F32SYS
+// - magnitudes go from 0 to 1 (a full-scale sine's bin), one per bin of
+//   the FFT's frequencies, from 0 to half the mixer's frequency (see
+//   getBinFrequency()). RMS and peak are of the window's samples, before
+//   windowing.
+// - if the worker falls behind, it skips ahead to the latest samples;
+//   if the ring's full, samples are dropped (and counted)
+// - only one may exist at a time: it's registered as a post-mix effect,
+//   and removed by function
+class SpectrumAnalyzer {
+public:
+	static const int DEFAULT_WINDOW_SIZE = 2048;
+
+	struct Snapshot {
+		std::vector<float> magnitudes; // windowSize / 2 + 1 of them
+		float rms;
+		float peak;
+		Uint64 sequence; // how many came before; 0 is none yet
+	};
+
+	// windowSize must be a power of 2. Throws std::runtime_error if it
+	// isn't, if audio isn't open or if its format isn't supported.
+	explicit SpectrumAnalyzer(int windowSize = DEFAULT_WINDOW_SIZE);
+	~SpectrumAnalyzer();
+
+	// the latest analysis; stays valid until the next call
+	const Snapshot & getLatest();
+	float getBinFrequency(int bin) const
+	{
+		return static_cast<float>(bin) * frequency_ / windowSize_;
+	}
+	int getWindowSize() const { return windowSize_; }
+	Uint64 getDroppedSamples() const { return dropped_.load(); }
+
+	SpectrumAnalyzer(const SpectrumAnalyzer &that) = delete;
+	SpectrumAnalyzer & operator=(const SpectrumAnalyzer &that) = delete;
+private:
+	static const int BLOCK_FRAMES = 512;
+
+	static void effect(int channel, void *stream, int len, void *udata);
+	void tap(const void *stream, int len);
+	void work();
+	void analyze(Snapshot &snapshot);
+	void fft();
+	static void butterflies(float *__restrict re0, float *__restrict im0,
+		float *__restrict re1, float *__restrict im1,
+		const float *__restrict twiddleCos,
+		const float *__restrict twiddleSin, int half);
+
+	int windowSize_;
+	int frequency_;
+	Uint16 format_;
+	int channels_;
+	SpscRing<float> ring_;
+	std::atomic<Uint64> dropped_;
+	std::vector<float> block_; // the audio thread's
+	TripleBuffer<Snapshot> snapshots_;
+
+	// the worker's
+	std::vector<float> samples_; // the latest windowSize_
+	std::vector<float> hann_;
+	std::vector<float> real_, imag_;
+	std::vector<int> reversed_; // bit-reversed indices
+	// each stage's twiddles, one after the other, so they're read in order
+	std::vector<float> cos_, sin_;
+	Uint64 sequence_;
+
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	bool quit_;
+	std::thread worker_;
+};
+
+SpectrumAnalyzer::SpectrumAnalyzer(int windowSize)
+	: windowSize_{windowSize}, ring_(std::max(windowSize, 2) * 4),
+	dropped_{0}, block_(), snapshots_(Snapshot{std::vector<float>(
+		std::max(windowSize, 2) / 2 + 1, 0.0f), 0.0f, 0.0f, 0}),
+	sequence_{0}, quit_{false}
+{
+	if(windowSize < 2 || (windowSize & (windowSize - 1)) != 0) {
+		throw std::runtime_error("Making spectrum analyzer failed: the "
+			"window size must be a power of 2");
+	}
+	if(Mix_QuerySpec(&frequency_, &format_, &channels_) == 0) {
+		throw std::runtime_error("Making spectrum analyzer failed: audio "
+			"isn't open");
+	}
+	if(format_ != AUDIO_S16SYS && format_ != AUDIO_F32SYS) {
+		throw std::runtime_error("Making spectrum analyzer failed: the "
+			"mixer's format must be AUDIO_S16SYS or AUDIO_F32SYS");
+	}
+	block_.resize(BLOCK_FRAMES);
+	samples_.assign(windowSize, 0.0f);
+	real_.resize(windowSize);
+	imag_.resize(windowSize);
+	hann_.resize(windowSize);
+	const double PI = 3.14159265358979323846;
+	for(int i = 0; i < windowSize; ++i) {
+		hann_[i] = static_cast<float>(
+			0.5 - 0.5 * std::cos(2 * PI * i / windowSize));
+	}
+	int bits = 0;
+	while((1 << bits) < windowSize) {
+		++bits;
+	}
+	reversed_.resize(windowSize);
+	for(int i = 0; i < windowSize; ++i) {
+		int reversed = 0;
+		for(int bit = 0; bit < bits; ++bit) {
+			reversed |= (i >> bit & 1) << (bits - 1 - bit);
+		}
+		reversed_[i] = reversed;
+	}
+	for(int half = 1; half < windowSize; half *= 2) {
+		for(int k = 0; k < half; ++k) {
+			cos_.push_back(static_cast<float>(std::cos(PI * k / half)));
+			sin_.push_back(static_cast<float>(-std::sin(PI * k / half)));
+		}
+	}
+	worker_ = std::thread(&SpectrumAnalyzer::work, this);
+	if(!Mix_RegisterEffect(MIX_CHANNEL_POST, effect, NULL, this)) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			quit_ = true;
+		}
+		cond_.notify_all();
+		worker_.join();
+		throw std::runtime_error(std::string("Making spectrum analyzer "
+			"failed: ") + SDL_GetError());
+	}
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+	// fails harmlessly if audio's been closed, which removed it already
+	Mix_UnregisterEffect(MIX_CHANNEL_POST, effect);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	cond_.notify_all();
+	worker_.join();
+}
+
+const SpectrumAnalyzer::Snapshot & SpectrumAnalyzer::getLatest()
+{
+	snapshots_.update();
+	return snapshots_.front();
+}
+
+void SpectrumAnalyzer::effect(int, void *stream, int len, void *udata)
+{
+	static_cast<SpectrumAnalyzer*>(udata)->tap(stream, len);
+}
+
+void SpectrumAnalyzer::tap(const void *stream, int len)
+{
+	const int sampleSize = SDL_AUDIO_BITSIZE(format_) / 8;
+	int frames = len / (sampleSize * channels_);
+	const float scale = 1.0f / channels_;
+	for(int done = 0; done < frames; done += BLOCK_FRAMES) {
+		int count = std::min(done + BLOCK_FRAMES, frames) - done;
+		for(int i = 0; i < count; ++i) {
+			float sum = 0.0f;
+			int at = (done + i) * channels_;
+			for(int c = 0; c < channels_; ++c) {
+				sum += format_ == AUDIO_F32SYS
+					? static_cast<const float*>(stream)[at + c]
+					: static_cast<const Sint16*>(stream)[at + c]
+						* (1.0f / 32768);
+			}
+			block_[i] = sum * scale;
+		}
+		dropped_ += count - ring_.push(block_.data(), count);
+	}
+	// no lock: the worker also looks now and then
+	cond_.notify_one();
+}
+
+void SpectrumAnalyzer::work()
+{
+	// when the audio thread doesn't get to notify while we're waiting
+	const std::chrono::milliseconds POLL_INTERVAL(10);
+	const size_t hop = windowSize_ / 2;
+	std::unique_lock<std::mutex> lock(mutex_);
+	while(!quit_) {
+		size_t available = ring_.available();
+		if(available < hop) {
+			cond_.wait_for(lock, POLL_INTERVAL);
+			continue;
+		}
+		lock.unlock();
+		// only the latest window's worth matters
+		if(available > static_cast<size_t>(windowSize_)) {
+			ring_.skip((available - windowSize_) / hop * hop);
+		}
+		while(ring_.available() >= hop) {
+			std::copy(samples_.begin() + hop, samples_.end(),
+				samples_.begin());
+			ring_.pop(&samples_[windowSize_ - hop], hop);
+		}
+		Snapshot &back = snapshots_.back();
+		analyze(back);
+		back.sequence = ++sequence_;
+		snapshots_.publish();
+		lock.lock();
+	}
+}
+
+void SpectrumAnalyzer::analyze(Snapshot &snapshot)
+{
+	const int n = windowSize_;
+	float sumSquares = 0.0f, peak = 0.0f;
+	for(int i = 0; i < n; ++i) {
+		float sample = samples_[i];
+		sumSquares += sample * sample;
+		peak = std::max(peak, std::fabs(sample));
+	}
+	snapshot.rms = std::sqrt(sumSquares / n);
+	snapshot.peak = peak;
+
+	for(int i = 0; i < n; ++i) {
+		int from = reversed_[i];
+		real_[i] = samples_[from] * hann_[from];
+		imag_[i] = 0.0f;
+	}
+	fft();
+	// a full-scale sine comes to n / 4 through the Hann window
+	const float scale = 4.0f / n;
+	snapshot.magnitudes.resize(n / 2 + 1);
+	for(int i = 0; i <= n / 2; ++i) {
+		snapshot.magnitudes[i] = std::sqrt(real_[i] * real_[i]
+			+ imag_[i] * imag_[i]) * scale;
+	}
+}
+
+void SpectrumAnalyzer::fft()
+{
+	// radix 2, in place, on the bit-reversed input
+	const int n = windowSize_;
+	float *re = real_.data(), *im = imag_.data();
+	const float *twiddleCos = cos_.data(), *twiddleSin = sin_.data();
+	for(int half = 1; half < n; half *= 2) {
+		for(int start = 0; start < n; start += 2 * half) {
+			butterflies(re + start, im + start, re + start + half,
+				im + start + half, twiddleCos, twiddleSin, half);
+		}
+		twiddleCos += half;
+		twiddleSin += half;
+	}
+}
+
+void SpectrumAnalyzer::butterflies(float *__restrict re0,
+	float *__restrict im0, float *__restrict re1, float *__restrict im1,
+	const float *__restrict twiddleCos, const float *__restrict twiddleSin,
+	int half)
+{
+	// the two halves of a block never overlap, and telling the compiler so
+	// spares it the alias checks that kept GCC from vectorizing this
+	for(int k = 0; k < half; ++k) {
+		float wr = twiddleCos[k], wi = twiddleSin[k];
+		float tr = wr * re1[k] - wi * im1[k];
+		float ti = wr * im1[k] + wi * re1[k];
+		re1[k] = re0[k] - tr;
+		im1[k] = im0[k] - ti;
+		re0[k] += tr;
+		im0[k] += ti;
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_SPECTRUMANALYZER_HPP
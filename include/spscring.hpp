@@ -0,0 +1,158 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_SPSCRING_HPP
+#define SCC_SPSCRING_HPP
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace SDL {
+
+// A ring buffer for one thread to push to and another to pop from, without
+// locks. Both copy as many elements as they can at once and never wait, so
+// it's meant for streams of samples or bytes between the audio thread and
+// another.
+//
+// Notes:
+// - the capacity is rounded up to a power of 2
+// - T should be cheap to copy (bytes, samples); they're copied in and out
+// - clear() may only be called while neither side is using it
+template <typename T>
+class SpscRing {
+public:
+	explicit SpscRing(size_t capacity);
+
+	// these return how many were copied, which may be fewer than count
+	size_t push(const T *data, size_t count);
+	size_t pop(T *data, size_t count);
+	// drops up to count, as if popped
+	size_t skip(size_t count);
+
+	// exact for the side asking: the other one may only make them larger
+	size_t available() const;
+	size_t space() const { return capacity() - available(); }
+	size_t capacity() const { return buffer_.size(); }
+
+	void clear()
+	{
+		head_.store(tail_.load(std::memory_order_relaxed),
+			std::memory_order_relaxed);
+	}
+
+	SpscRing(const SpscRing &that) = delete;
+	SpscRing & operator=(const SpscRing &that) = delete;
+private:
+	// copies count elements between the ring, from position on, and data
+	void copyOut(size_t position, T *data, size_t count) const;
+	void copyIn(size_t position, const T *data, size_t count);
+
+	static const size_t CACHE_LINE = 64;
+
+	std::vector<T> buffer_;
+	size_t mask_;
+	// both only ever grow (wrapping around); their difference is the fill
+	char pad0_[CACHE_LINE];
+	std::atomic<size_t> tail_; // written by the pushing side
+	char pad1_[CACHE_LINE];
+	std::atomic<size_t> head_; // written by the popping side
+	char pad2_[CACHE_LINE];
+};
+
+template <typename T>
+SpscRing<T>::SpscRing(size_t capacity)
+	: tail_{0}, head_{0}
+{
+	size_t size = 2;
+	while(size < capacity) {
+		size *= 2;
+	}
+	buffer_.resize(size);
+	mask_ = size - 1;
+}
+
+template <typename T>
+size_t SpscRing<T>::available() const
+{
+	// head first, so it can't overtake the tail in between
+	size_t head = head_.load(std::memory_order_acquire);
+	return tail_.load(std::memory_order_acquire) - head;
+}
+
+template <typename T>
+size_t SpscRing<T>::push(const T *data, size_t count)
+{
+	size_t tail = tail_.load(std::memory_order_relaxed);
+	// acquire, so the popping side is done with what it's freed
+	size_t head = head_.load(std::memory_order_acquire);
+	count = std::min(count, capacity() - (tail - head));
+	copyIn(tail, data, count);
+	tail_.store(tail + count, std::memory_order_release);
+	return count;
+}
+
+template <typename T>
+size_t SpscRing<T>::pop(T *data, size_t count)
+{
+	size_t head = head_.load(std::memory_order_relaxed);
+	size_t tail = tail_.load(std::memory_order_acquire);
+	count = std::min(count, tail - head);
+	copyOut(head, data, count);
+	head_.store(head + count, std::memory_order_release);
+	return count;
+}
+
+template <typename T>
+size_t SpscRing<T>::skip(size_t count)
+{
+	size_t head = head_.load(std::memory_order_relaxed);
+	size_t tail = tail_.load(std::memory_order_acquire);
+	count = std::min(count, tail - head);
+	head_.store(head + count, std::memory_order_release);
+	return count;
+}
+
+template <typename T>
+void SpscRing<T>::copyOut(size_t position, T *data, size_t count) const
+{
+	// in up to two pieces, if it wraps around
+	size_t start = position & mask_;
+	size_t first = std::min(count, capacity() - start);
+	std::copy(buffer_.begin() + start, buffer_.begin() + start + first,
+		data);
+	std::copy(buffer_.begin(), buffer_.begin() + (count - first),
+		data + first);
+}
+
+template <typename T>
+void SpscRing<T>::copyIn(size_t position, const T *data, size_t count)
+{
+	size_t start = position & mask_;
+	size_t first = std::min(count, capacity() - start);
+	std::copy(data, data + first, buffer_.begin() + start);
+	std::copy(data + first, data + count, buffer_.begin());
+}
+
+} // namespace SDL
+
+#endif // SCC_SPSCRING_HPP
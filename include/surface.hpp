@@ -27,6 +27,10 @@
 #include "cstylealloc.hpp"
 #include "rwops.hpp"
 
+#ifdef HAVE_SDL_IMAGE
+# include "imagecache.hpp"
+#endif
+
 #ifdef HAVE_SDL_TTF
 # include "truetypefont.hpp"
 #endif
@@ -61,6 +65,17 @@ public:
 	{
 		return Surface(image, FromImage::dummy);
 	}
+	// decoded pixels come from (and go to) cache, in format
+	static Surface fromImage(const char *path, ImageCache &cache,
+		Uint32 format = SDL_PIXELFORMAT_ARGB8888)
+	{
+		return Surface(RWops(path, "rb"), cache, format);
+	}
+	static Surface fromImage(const RWops &image, ImageCache &cache,
+		Uint32 format = SDL_PIXELFORMAT_ARGB8888)
+	{
+		return Surface(image, cache, format);
+	}
 #endif
 
 #ifdef HAVE_SDL_TTF
@@ -143,6 +158,14 @@ private:
 		: surface_{FromRWops<Surface::Deleter>::load(image,
 			IMG_Load_RW, "Making surface from image failed")}
 	{}
+	Surface(const RWops &image, ImageCache &cache, Uint32 format)
+		: surface_{CStyleAlloc<Surface::Deleter>::alloc(
+			[](const RWops &image, ImageCache &cache, Uint32 format)
+			{
+				return cache.loadSurface(image, format);
+			}
+			, "Making surface from image failed", image, cache, format)}
+	{}
 #endif
 #ifdef HAVE_SDL_TTF
 	Surface(const char *text, TrueTypeFont &font, SDL_Color color)
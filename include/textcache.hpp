@@ -0,0 +1,243 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_TEXTCACHE_HPP
+#define SCC_TEXTCACHE_HPP
+
+#include <list>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+#include <SDL.h>
+#include "null.hpp"
+#include "renderer.hpp"
+#include "texture.hpp"
+#include "truetypefont.hpp"
+
+#ifndef HAVE_SDL_TTF
+# error "can't use TextCache without SDL_ttf"
+#endif
+
+namespace SDL {
+
+// Textures of rendered text, kept so that the same label in the same font,
+// size, style and color is rendered and uploaded only once. Meant for text
+// that's made again and again without changing, like menus rebuilt on
+// every navigation; for text that changes every frame, use
+// Renderer::drawText() instead.
+//
+// Notes:
+// - textures are made like Renderer::makeTexture(text, font, color)
+//   makes them, and get() throws like it does
+// - the textures are shared: evicting one only drops the cache's
+//   reference, so it's still good for whoever holds it
+// - the budget counts the bytes of the textures the cache holds (width,
+//   height and bytes per pixel), whether or not they're held elsewhere
+//   too. When it's exceeded, the least recently used ones go first; one
+//   texture bigger than the whole budget is still returned, just not kept.
+// - fonts are told apart by TrueTypeFont::getId(), so a font that's gone
+//   needn't be forgotten; its entries just get old and are evicted
+// - textures belong to renderer, so it must outlive the cache
+// - it isn't thread-safe; like the renderer, use it from one thread
+class TextCache {
+public:
+	TextCache(Renderer &renderer, size_t byteBudget);
+
+	std::shared_ptr<Texture> get(TrueTypeFont &font, const char *text,
+		SDL_Color color);
+
+	// evicts right away if needed
+	void setBudget(size_t byteBudget);
+	size_t getBudget() const { return budget_; }
+	size_t getBytes() const { return bytes_; }
+	size_t getCount() const { return entries_.size(); }
+
+	// drops the entries of font, or all of them
+	void forget(const TrueTypeFont &font);
+	void clear();
+
+	Uint64 getHits() const { return hits_; }
+	Uint64 getMisses() const { return misses_; }
+	Uint64 getEvictions() const { return evictions_; }
+	// hits / (hits + misses), or 0 before the first get()
+	double getHitRate() const;
+	void resetStats() { hits_ = misses_ = evictions_ = 0; }
+
+	TextCache(const TextCache &that) = delete;
+	TextCache & operator=(const TextCache &that) = delete;
+private:
+	struct Key {
+		Uint64 font;
+		int size;
+		int style;
+		Uint32 color; // RGBA, one byte each
+		Uint64 hash; // of text
+		std::string text;
+
+		bool operator==(const Key &that) const
+		{
+			return hash == that.hash && font == that.font
+				&& size == that.size && style == that.style
+				&& color == that.color && text == that.text;
+		}
+	};
+	struct KeyHash {
+		size_t operator()(const Key &key) const
+		{
+			// the text's hash does most of the work
+			Uint64 hash = key.hash ^ (key.font * 0x9e3779b97f4a7c15ULL);
+			hash ^= (Uint64(key.color) << 16) ^ (Uint64(key.size) << 8)
+				^ Uint64(key.style);
+			return size_t(hash ^ (hash >> 32));
+		}
+	};
+	struct Entry {
+		Key key;
+		std::shared_ptr<Texture> texture;
+		size_t bytes;
+	};
+	// most recently used first
+	typedef std::list<Entry> Entries;
+
+	static Uint64 hash(const char *text);
+	static size_t bytesOf(const Texture &texture);
+	void evict(size_t budget);
+	void erase(Entries::iterator entry);
+
+	Renderer &renderer_;
+	size_t budget_;
+	size_t bytes_;
+	Entries entries_;
+	std::unordered_map<Key, Entries::iterator, KeyHash> index_;
+	Uint64 hits_;
+	Uint64 misses_;
+	Uint64 evictions_;
+};
+
+TextCache::TextCache(Renderer &renderer, size_t byteBudget)
+	: renderer_(renderer), budget_{byteBudget}, bytes_{0},
+	hits_{0}, misses_{0}, evictions_{0}
+{}
+
+std::shared_ptr<Texture> TextCache::get(TrueTypeFont &font,
+	const char *text, SDL_Color color)
+{
+	Key key{font.getId(), font.getSize(), font.getStyle(),
+		Uint32(color.r) << 24 | Uint32(color.g) << 16
+			| Uint32(color.b) << 8 | Uint32(color.a),
+		hash(text), text};
+	auto found = index_.find(key);
+	if(found != index_.end()) {
+		++hits_;
+		entries_.splice(entries_.begin(), entries_, found->second);
+		return found->second->texture;
+	}
+
+	++misses_;
+	std::shared_ptr<Texture> texture = std::make_shared<Texture>(
+		renderer_.makeTexture(text, font, color));
+	size_t bytes = bytesOf(*texture);
+	if(bytes > budget_) {
+		return texture;
+	}
+	evict(budget_ - bytes);
+	entries_.push_front(Entry{key, texture, bytes});
+	index_.emplace(std::move(key), entries_.begin());
+	bytes_ += bytes;
+	return texture;
+}
+
+void TextCache::setBudget(size_t byteBudget)
+{
+	budget_ = byteBudget;
+	evict(budget_);
+}
+
+void TextCache::forget(const TrueTypeFont &font)
+{
+	Uint64 id = font.getId();
+	for(auto entry = entries_.begin(); entry != entries_.end(); ) {
+		auto next = std::next(entry);
+		if(entry->key.font == id) {
+			erase(entry);
+		}
+		entry = next;
+	}
+}
+
+void TextCache::clear()
+{
+	index_.clear();
+	entries_.clear();
+	bytes_ = 0;
+}
+
+double TextCache::getHitRate() const
+{
+	Uint64 lookups = hits_ + misses_;
+	return lookups == 0 ? 0.0 : double(hits_) / lookups;
+}
+
+Uint64 TextCache::hash(const char *text)
+{
+	Uint64 hash = 0xcbf29ce484222325ULL; // FNV-1a's offset basis
+	for(; *text != '\0'; ++text) {
+		hash ^= Uint8(*text);
+		hash *= 0x100000001b3ULL; // and its prime
+	}
+	return hash;
+}
+
+size_t TextCache::bytesOf(const Texture &texture)
+{
+	Uint32 format;
+	int width, height;
+	if(texture.query(&format, NULL, &width, &height) < 0) {
+		return 0;
+	}
+	size_t bytesPerPixel = SDL_BYTESPERPIXEL(format);
+	if(bytesPerPixel == 0) { // a FOURCC format; a guess is good enough
+		bytesPerPixel = 4;
+	}
+	return size_t(width) * height * bytesPerPixel;
+}
+
+// until the entries fit in budget
+void TextCache::evict(size_t budget)
+{
+	while(bytes_ > budget && !entries_.empty()) {
+		erase(std::prev(entries_.end()));
+		++evictions_;
+	}
+}
+
+void TextCache::erase(Entries::iterator entry)
+{
+	bytes_ -= entry->bytes;
+	index_.erase(entry->key);
+	entries_.erase(entry);
+}
+
+} // namespace SDL
+
+#endif // SCC_TEXTCACHE_HPP
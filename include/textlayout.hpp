@@ -0,0 +1,631 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_TEXTLAYOUT_HPP
+#define SCC_TEXTLAYOUT_HPP
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+#include <SDL.h>
+#include "null.hpp"
+#include "utf8.hpp"
+#include "truetypefont.hpp"
+
+#ifndef HAVE_SDL_TTF
+# error "can't use TextLayout without SDL_ttf"
+#endif
+
+namespace SDL {
+
+// Breaks UTF-8 text into lines no wider than a width, and keeps them broken
+// as the text is edited, measuring with the font's glyph advances and
+// kerning (instead of TTF_SizeUTF8() on ever longer substrings).
+//
+// Notes:
+// - '\n' ends a paragraph, and lines break at spaces. A word wider than
+//   the width gets a line of its own, and sticks out of it.
+// - widths are pen advances: the sum of the glyphs' advances and the
+//   kerning between them
+// - each glyph's advance, and each word's width, are measured once and
+//   cached. Code points past U+FFFF are measured as U+FFFD, like SDL_ttf
+//   draws them.
+// - an edit lays out again only the paragraphs it touches. Within one,
+//   GREEDY lays out from the line before the edit until a line starts
+//   where one used to, and reuses the rest; OPTIMAL lays out the whole
+//   paragraph, since any of its lines may change.
+// - offsets are in bytes, and should fall between code points
+// - the font must outlive the layout. Call setFont() again after changing
+//   its style, to measure it anew.
+class TextLayout {
+public:
+	// GREEDY puts as many words on each line as fit. OPTIMAL makes the
+	// lines as even as it can: the least sum of the squares of the room
+	// left at the end of each (but the last) line of a paragraph.
+	enum Wrap { GREEDY, OPTIMAL };
+	enum Align { LEFT, CENTER, RIGHT };
+
+	struct Line {
+		// offsets into getText(), without the spaces the line broke at
+		size_t begin;
+		size_t end;
+		// where it goes, relative to the layout's top left, after
+		// alignment
+		int x;
+		int y;
+		int width;
+	};
+
+	TextLayout(TrueTypeFont &font, int width, Wrap wrap = GREEDY,
+		Align align = LEFT);
+
+	const std::string &getText() const { return text_; }
+	void setText(std::string text);
+	// replaces length bytes at offset with utf8
+	void replace(size_t offset, size_t length, const char *utf8);
+	void insert(size_t offset, const char *utf8)
+	{
+		replace(offset, 0, utf8);
+	}
+	void erase(size_t offset, size_t length)
+	{
+		replace(offset, length, "");
+	}
+	void append(const char *utf8) { replace(text_.size(), 0, utf8); }
+
+	// these lay everything out again
+	void setFont(TrueTypeFont &font);
+	void setWidth(int width);
+	void setWrap(Wrap wrap);
+	int getWidth() const { return width_; }
+	Wrap getWrap() const { return wrap_; }
+
+	// this one doesn't; it's applied in getLine()
+	void setAlign(Align align) { align_ = align; }
+	Align getAlign() const { return align_; }
+
+	size_t getLineCount() const { return lineCount_; }
+	Line getLine(size_t index) const;
+	// the index of the line offset is on (or of the spaces after it)
+	size_t getLineAt(size_t offset) const;
+	int getHeight() const { return int(lineCount_) * lineSkip_; }
+
+	// the width of utf8's first length bytes
+	int measure(const char *utf8, size_t length);
+
+	// lines laid out (again or not) since the last resetStats()
+	Uint64 getLinesLaidOut() const { return linesLaidOut_; }
+	// words whose width was cached, and those that had to be measured
+	Uint64 getWordHits() const { return wordHits_; }
+	Uint64 getWordMisses() const { return wordMisses_; }
+	void resetStats() { linesLaidOut_ = wordHits_ = wordMisses_ = 0; }
+
+	TextLayout(const TextLayout &that) = delete;
+	TextLayout & operator=(const TextLayout &that) = delete;
+private:
+	// the words cached; past that, the cache starts over
+	static const size_t MAX_CACHED_WORDS = 4096;
+	static const int UNKNOWN = std::numeric_limits<int>::min();
+
+	struct Glyph {
+		int advance;
+		// the kerning between this and a space, on either side of it
+		int kerningBeforeSpace;
+		int kerningAfterSpace;
+	};
+
+	// a word's measure
+	struct Run {
+		int width;
+		Uint16 first; // its glyphs; 0 if it's empty
+		Uint16 last;
+	};
+
+	// offsets are relative to the paragraph's beginning, so that edits
+	// elsewhere don't move them
+	struct Word {
+		size_t begin;
+		size_t end;
+		Run run;
+		// from its end to the next word's beginning; 0 for the last word,
+		// since a paragraph's trailing spaces don't count
+		int space;
+	};
+	struct Row {
+		size_t begin;
+		size_t end;
+		int width;
+	};
+	struct Paragraph {
+		size_t begin; // offset into text_
+		size_t length; // without the '\n'
+		size_t firstLine;
+		std::vector<Word> words; // at least one, maybe empty
+		std::vector<Row> rows;
+	};
+
+	static Uint16 glyphOf(Uint32 codepoint)
+	{
+		return codepoint > 0xFFFF ? UTF8::REPLACEMENT : codepoint;
+	}
+	const Glyph &glyph(Uint16 glyph);
+	Run measureWord(const char *begin, size_t length);
+
+	void layOut(size_t begin, size_t end, std::vector<Paragraph> &made);
+	void split(Paragraph &paragraph);
+	// lays out paragraph's rows, keeping the first keep. After an edit
+	// that ended at editEnd (in new offsets) and moved what followed by
+	// delta, it stops once a row starts where one did after the edit, and
+	// reuses the rest.
+	void breakGreedy(Paragraph &paragraph, size_t keep = 0,
+		size_t editEnd = std::string::npos, Sint64 delta = 0);
+	void breakOptimal(Paragraph &paragraph);
+	void breakLines(Paragraph &paragraph);
+	// fixes the paragraphs' offsets and first lines, from first on
+	void renumber(size_t first);
+
+	size_t paragraphAt(size_t offset) const;
+	static size_t rowAt(const Paragraph &paragraph, size_t offset);
+	static size_t wordAt(const Paragraph &paragraph, size_t offset);
+
+	TrueTypeFont *font_;
+	int width_;
+	Wrap wrap_;
+	Align align_;
+	int lineSkip_;
+	int spaceAdvance_;
+	int spaceKerning_; // between two spaces
+
+	std::string text_;
+	std::vector<Paragraph> paragraphs_; // at least one
+	size_t lineCount_;
+
+	std::vector<Glyph> latin_; // the first 256 glyphs, for speed
+	std::unordered_map<Uint16, Glyph> glyphs_; // the rest
+	std::unordered_map<std::string, Run> words_;
+
+	Uint64 linesLaidOut_;
+	Uint64 wordHits_;
+	Uint64 wordMisses_;
+};
+
+TextLayout::TextLayout(TrueTypeFont &font, int width, Wrap wrap,
+	Align align)
+	: font_{&font}, width_{width}, wrap_{wrap}, align_{align},
+	lineSkip_{0}, spaceAdvance_{0}, spaceKerning_{0}, lineCount_{0},
+	linesLaidOut_{0}, wordHits_{0}, wordMisses_{0}
+{
+	setFont(font);
+}
+
+void TextLayout::setText(std::string text)
+{
+	text_ = std::move(text);
+	paragraphs_.clear();
+	layOut(0, text_.size(), paragraphs_);
+	renumber(0);
+}
+
+void TextLayout::replace(size_t offset, size_t length, const char *utf8)
+{
+	offset = std::min(offset, text_.size());
+	length = std::min(length, text_.size() - offset);
+	size_t inserted = std::strlen(utf8);
+	size_t first = paragraphAt(offset);
+	size_t last = paragraphAt(offset + length);
+	bool newlines = first != last
+		|| std::memchr(utf8, '\n', inserted) != NULL;
+	Sint64 delta = Sint64(inserted) - Sint64(length);
+	text_.replace(offset, length, utf8, inserted);
+
+	if(!newlines) {
+		Paragraph &paragraph = paragraphs_[first];
+		size_t begin = offset - paragraph.begin;
+		// a word on the edited row may fit on the one before it now
+		size_t row = rowAt(paragraph, begin);
+		paragraph.length += delta;
+		split(paragraph);
+		if(wrap_ == GREEDY) {
+			breakGreedy(paragraph, row > 0 ? row - 1 : 0,
+				begin + inserted, delta);
+		} else {
+			breakOptimal(paragraph);
+		}
+	} else {
+		// the paragraphs touched are made anew, since '\n's come and go;
+		// but for the first one, if it keeps its text and its '\n' (as
+		// when appending lines)
+		size_t from = first;
+		size_t begin = paragraphs_[first].begin;
+		if(offset == begin + paragraphs_[first].length && utf8[0] == '\n') {
+			++from;
+			begin = offset + 1;
+		}
+		const Paragraph &end = paragraphs_[last];
+		std::vector<Paragraph> made;
+		layOut(begin, end.begin + end.length + delta, made);
+		paragraphs_.erase(paragraphs_.begin() + from,
+			paragraphs_.begin() + last + 1);
+		paragraphs_.insert(paragraphs_.begin() + from,
+			std::make_move_iterator(made.begin()),
+			std::make_move_iterator(made.end()));
+	}
+	renumber(first);
+}
+
+void TextLayout::setFont(TrueTypeFont &font)
+{
+	font_ = &font;
+	latin_.assign(256, Glyph{UNKNOWN, 0, 0});
+	glyphs_.clear();
+	words_.clear();
+	lineSkip_ = font_->getLineSkip();
+	spaceAdvance_ = glyph(' ').advance;
+	spaceKerning_ = font_->getKerning(' ', ' ');
+	setText(std::move(text_));
+}
+
+void TextLayout::setWidth(int width)
+{
+	width_ = width;
+	for(Paragraph &paragraph : paragraphs_) {
+		breakLines(paragraph);
+	}
+	renumber(0);
+}
+
+void TextLayout::setWrap(Wrap wrap)
+{
+	wrap_ = wrap;
+	setWidth(width_);
+}
+
+TextLayout::Line TextLayout::getLine(size_t index) const
+{
+	// the last paragraph starting at or before index
+	auto found = std::upper_bound(paragraphs_.begin(), paragraphs_.end(),
+		index, [](size_t index, const Paragraph &paragraph)
+		{
+			return index < paragraph.firstLine;
+		});
+	const Paragraph &paragraph = *(found - 1);
+	const Row &row = paragraph.rows[index - paragraph.firstLine];
+	int x = 0;
+	if(align_ == CENTER) {
+		x = (width_ - row.width) / 2;
+	} else if(align_ == RIGHT) {
+		x = width_ - row.width;
+	}
+	// lines too wide stick out to the right only
+	return Line{paragraph.begin + row.begin, paragraph.begin + row.end,
+		std::max(x, 0), int(index) * lineSkip_, row.width};
+}
+
+size_t TextLayout::getLineAt(size_t offset) const
+{
+	const Paragraph &paragraph = paragraphs_[paragraphAt(offset)];
+	return paragraph.firstLine
+		+ rowAt(paragraph, offset - paragraph.begin);
+}
+
+int TextLayout::measure(const char *utf8, size_t length)
+{
+	const char *end = utf8 + length;
+	int width = 0;
+	Uint16 previous = 0;
+	while(utf8 < end) {
+		Uint32 codepoint = UTF8::next(utf8);
+		if(codepoint == 0) {
+			break;
+		}
+		Uint16 current = glyphOf(codepoint);
+		const Glyph &metrics = glyph(current);
+		if(previous == ' ') {
+			width += current == ' ' ? spaceKerning_
+				: metrics.kerningAfterSpace;
+		} else if(previous != 0) {
+			width += current == ' ' ? glyph(previous).kerningBeforeSpace
+				: font_->getKerning(previous, current);
+		}
+		width += metrics.advance;
+		previous = current;
+	}
+	return width;
+}
+
+const TextLayout::Glyph &TextLayout::glyph(Uint16 glyph)
+{
+	Glyph *metrics;
+	if(glyph < latin_.size()) {
+		metrics = &latin_[glyph];
+	} else {
+		auto inserted = glyphs_.insert({glyph, Glyph{UNKNOWN, 0, 0}});
+		metrics = &inserted.first->second;
+	}
+	if(metrics->advance == UNKNOWN) {
+		int advance;
+		if(!font_->getGlyphMetrics(glyph, NULL, NULL, NULL, NULL,
+			&advance))
+		{
+			advance = 0;
+		}
+		*metrics = Glyph{advance, font_->getKerning(glyph, ' '),
+			font_->getKerning(' ', glyph)};
+	}
+	return *metrics;
+}
+
+TextLayout::Run TextLayout::measureWord(const char *begin, size_t length)
+{
+	if(length == 0) {
+		return Run{0, 0, 0};
+	}
+	std::string key(begin, length);
+	auto found = words_.find(key);
+	if(found != words_.end()) {
+		++wordHits_;
+		return found->second;
+	}
+	++wordMisses_;
+	Run run{measure(begin, length), 0, 0};
+	// a word has no '\0' in it, so next() stops at its end
+	const char *end = begin + length;
+	for(const char *next = begin; next < end; ) {
+		run.last = glyphOf(UTF8::next(next));
+		if(run.first == 0) {
+			run.first = run.last;
+		}
+	}
+	if(words_.size() >= MAX_CACHED_WORDS) {
+		words_.clear();
+	}
+	words_.emplace(std::move(key), run);
+	return run;
+}
+
+// lays out text_'s [begin, end) as paragraphs, appended to made
+void TextLayout::layOut(size_t begin, size_t end,
+	std::vector<Paragraph> &made)
+{
+	for(;;) {
+		size_t newline = text_.find('\n', begin);
+		if(newline >= end) {
+			newline = end;
+		}
+		Paragraph paragraph{begin, newline - begin, 0, {}, {}};
+		split(paragraph);
+		breakLines(paragraph);
+		made.push_back(std::move(paragraph));
+		if(newline == end) {
+			return;
+		}
+		begin = newline + 1;
+	}
+}
+
+// into words
+void TextLayout::split(Paragraph &paragraph)
+{
+	const char *text = text_.data() + paragraph.begin;
+	size_t length = paragraph.length;
+	paragraph.words.clear();
+	// leading spaces go after an empty word, so they're kept
+	size_t i = 0;
+	for(;;) {
+		Word word;
+		word.begin = i;
+		while(i < length && text[i] != ' ') {
+			++i;
+		}
+		word.end = i;
+		word.run = measureWord(text + word.begin, word.end - word.begin);
+		word.space = 0;
+		if(!paragraph.words.empty() && word.run.first != 0) {
+			paragraph.words.back().space +=
+				glyph(word.run.first).kerningAfterSpace;
+		}
+		size_t spaces = i;
+		while(i < length && text[i] == ' ') {
+			++i;
+		}
+		spaces = i - spaces;
+		if(i < length) {
+			word.space = int(spaces) * spaceAdvance_
+				+ int(spaces - 1) * spaceKerning_;
+			if(word.run.last != 0) {
+				word.space += glyph(word.run.last).kerningBeforeSpace;
+			}
+		}
+		paragraph.words.push_back(word);
+		if(i == length) {
+			return;
+		}
+	}
+}
+
+void TextLayout::breakGreedy(Paragraph &paragraph, size_t keep,
+	size_t editEnd, Sint64 delta)
+{
+	const std::vector<Word> &words = paragraph.words;
+	std::vector<Row> old;
+	old.swap(paragraph.rows);
+	size_t word = 0;
+	if(keep > 0 && keep < old.size()) {
+		// rows before the edit start at the same words they did
+		word = wordAt(paragraph, old[keep].begin);
+		if(word == words.size()) {
+			word = keep = 0;
+		}
+	} else {
+		keep = 0;
+	}
+	paragraph.rows.assign(old.begin(), old.begin() + keep);
+	size_t reusable = keep;
+
+	while(word < words.size()) {
+		// as many words as fit, and at least one
+		Row row{words[word].begin, words[word].end, words[word].run.width};
+		for(++word; word < words.size(); ++word) {
+			int width = row.width + words[word - 1].space
+				+ words[word].run.width;
+			if(width > width_) {
+				break;
+			}
+			row.width = width;
+			row.end = words[word].end;
+		}
+		paragraph.rows.push_back(row);
+		++linesLaidOut_;
+
+		if(word == words.size() || words[word].begin < editEnd) {
+			continue;
+		}
+		// past the edit, a row starting where one used to goes on like
+		// it did
+		size_t begin = size_t(Sint64(words[word].begin) - delta);
+		while(reusable < old.size() && old[reusable].begin < begin) {
+			++reusable;
+		}
+		if(reusable < old.size() && old[reusable].begin == begin) {
+			for(; reusable < old.size(); ++reusable) {
+				Row moved = old[reusable];
+				moved.begin += delta;
+				moved.end += delta;
+				paragraph.rows.push_back(moved);
+			}
+			return;
+		}
+	}
+}
+
+void TextLayout::breakOptimal(Paragraph &paragraph)
+{
+	const std::vector<Word> &words = paragraph.words;
+	size_t count = words.size();
+	// the least cost of laying out the words from i on, and where the
+	// first line of that ends. The last line costs nothing.
+	std::vector<Uint64> cost(count + 1, 0);
+	std::vector<size_t> end(count + 1, count);
+	for(size_t i = count; i-- > 0; ) {
+		cost[i] = std::numeric_limits<Uint64>::max();
+		int width = words[i].run.width;
+		for(size_t j = i + 1; ; ++j) {
+			// words [i, j) on a line, width wide. A word too wide on
+			// its own has no better place to go.
+			Uint64 room = width < width_ ? Uint64(width_ - width) : 0;
+			Uint64 total = cost[j] + (j == count ? 0 : room * room);
+			if(total < cost[i]) {
+				cost[i] = total;
+				end[i] = j;
+			}
+			if(j == count) {
+				break;
+			}
+			width += words[j - 1].space + words[j].run.width;
+			if(width > width_) {
+				break;
+			}
+		}
+	}
+
+	paragraph.rows.clear();
+	for(size_t i = 0; i < count; i = end[i]) {
+		int width = words[i].run.width;
+		for(size_t j = i + 1; j < end[i]; ++j) {
+			width += words[j - 1].space + words[j].run.width;
+		}
+		paragraph.rows.push_back(
+			Row{words[i].begin, words[end[i] - 1].end, width});
+		++linesLaidOut_;
+	}
+}
+
+void TextLayout::breakLines(Paragraph &paragraph)
+{
+	if(wrap_ == GREEDY) {
+		breakGreedy(paragraph);
+	} else {
+		breakOptimal(paragraph);
+	}
+}
+
+void TextLayout::renumber(size_t first)
+{
+	for(size_t i = first; i < paragraphs_.size(); ++i) {
+		Paragraph &paragraph = paragraphs_[i];
+		if(i == 0) {
+			paragraph.begin = 0;
+			paragraph.firstLine = 0;
+		} else {
+			const Paragraph &previous = paragraphs_[i - 1];
+			paragraph.begin = previous.begin + previous.length + 1;
+			paragraph.firstLine = previous.firstLine
+				+ previous.rows.size();
+		}
+	}
+	const Paragraph &last = paragraphs_.back();
+	lineCount_ = last.firstLine + last.rows.size();
+}
+
+// the paragraph offset is in, or whose '\n' it's on
+size_t TextLayout::paragraphAt(size_t offset) const
+{
+	auto found = std::upper_bound(paragraphs_.begin(), paragraphs_.end(),
+		offset, [](size_t offset, const Paragraph &paragraph)
+		{
+			return offset < paragraph.begin;
+		});
+	return found - paragraphs_.begin() - 1;
+}
+
+// the last row starting at or before offset
+size_t TextLayout::rowAt(const Paragraph &paragraph, size_t offset)
+{
+	auto found = std::upper_bound(paragraph.rows.begin(),
+		paragraph.rows.end(), offset, [](size_t offset, const Row &row)
+		{
+			return offset < row.begin;
+		});
+	return found == paragraph.rows.begin() ? 0
+		: found - paragraph.rows.begin() - 1;
+}
+
+// the word starting at offset, or words.size() if none does
+size_t TextLayout::wordAt(const Paragraph &paragraph, size_t offset)
+{
+	auto found = std::lower_bound(paragraph.words.begin(),
+		paragraph.words.end(), offset, [](const Word &word, size_t offset)
+		{
+			return word.begin < offset;
+		});
+	if(found == paragraph.words.end() || found->begin != offset) {
+		return paragraph.words.size();
+	}
+	return found - paragraph.words.begin();
+}
+
+} // namespace SDL
+
+#endif // SCC_TEXTLAYOUT_HPP
@@ -43,6 +43,7 @@ class Renderer;
 
 class Texture {
 	friend class Renderer;
+	friend class GlyphAtlas;
 public:
 	// The ctors are meant to be called from Renderer's makeTexture().
 
@@ -57,6 +58,11 @@ public:
 	// non-bitmap images. For bitmaps, make a Surface from them first
 	Texture(SDL_Renderer *renderer, const char *imagePath);
 	Texture(SDL_Renderer *renderer, const RWops &image);
+	// decoded pixels come from (and go to) cache, in the renderer's
+	// preferred format
+	Texture(SDL_Renderer *renderer, const char *imagePath,
+		ImageCache &cache);
+	Texture(SDL_Renderer *renderer, const RWops &image, ImageCache &cache);
 #endif
 
 #ifdef HAVE_SDL_TTF
@@ -85,6 +91,13 @@ public:
 	}
 	void unlock() { SDL_UnlockTexture(texture_.get()); }
 
+	// Wrapper around SDL_UpdateTexture(), for static textures. rect may
+	// be NULL, meaning the whole texture.
+	bool update(const SDL_Rect *rect, const void *pixels, int pitch)
+	{
+		return SDL_UpdateTexture(texture_.get(), rect, pixels, pitch) >= 0;
+	}
+
 	bool setColorMod(Uint8 r, Uint8 g, Uint8 b)
 	{
 		return SDL_SetTextureColorMod(texture_.get(), r, g, b) >= 0;
@@ -176,6 +189,21 @@ Texture::Texture(SDL_Renderer *renderer, const RWops &image)
 		}
 		, "Making texture from image failed", renderer)}
 {}
+
+Texture::Texture(SDL_Renderer *renderer, const char *imagePath,
+	ImageCache &cache)
+	: Texture(renderer, RWops(imagePath, "rb"), cache)
+{}
+
+Texture::Texture(SDL_Renderer *renderer, const RWops &image,
+	ImageCache &cache)
+	: texture_{CStyleAlloc<Texture::Deleter>::alloc(
+		[](SDL_Renderer *renderer, const RWops &image, ImageCache &cache)
+		{
+			return cache.loadTexture(renderer, image);
+		}
+		, "Making texture from image failed", renderer, image, cache)}
+{}
 #endif
 
 #ifdef HAVE_SDL_TTF
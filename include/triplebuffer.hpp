@@ -0,0 +1,82 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_TRIPLEBUFFER_HPP
+#define SCC_TRIPLEBUFFER_HPP
+
+#include <atomic>
+
+namespace SDL {
+
+// Hands the latest of something from one thread to another without locks
+// or copies: one side writes the back buffer and publishes it, the other
+// picks up whatever was published last. Neither ever waits, and what's
+// published in between is skipped.
+//
+// Notes:
+// - there's one writer and one reader. Each may only touch its own
+//   buffer: back() for the writer, front() for the reader.
+// - front() is the initial value until something's published
+template <typename T>
+class TripleBuffer {
+public:
+	explicit TripleBuffer(const T &initial = T())
+		: buffers_{initial, initial, initial}, back_{0}, middle_{1},
+		front_{2}
+	{}
+
+	// the writer's
+	T & back() { return buffers_[back_]; }
+	// swaps back() for the one the reader would get next
+	void publish()
+	{
+		back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel)
+			& INDEX;
+	}
+
+	// the reader's. Returns whether there was something new.
+	bool update()
+	{
+		if((middle_.load(std::memory_order_relaxed) & FRESH) == 0) {
+			return false;
+		}
+		front_ = middle_.exchange(front_, std::memory_order_acq_rel)
+			& INDEX;
+		return true;
+	}
+	const T & front() const { return buffers_[front_]; }
+
+	TripleBuffer(const TripleBuffer &that) = delete;
+	TripleBuffer & operator=(const TripleBuffer &that) = delete;
+private:
+	// the middle's index, and whether it was published since it was read
+	static const int INDEX = 3;
+	static const int FRESH = 4;
+
+	T buffers_[3];
+	int back_;
+	std::atomic<int> middle_;
+	int front_;
+};
+
+} // namespace SDL
+
+#endif // SCC_TRIPLEBUFFER_HPP
@@ -23,9 +23,11 @@
 #define SCC_TRUETYPEFONT_HPP
 
 #include <memory>
+#include <atomic>
 #include <stdexcept>
 #include "null.hpp"
 #include "cstylealloc.hpp"
+#include "rwops.hpp"
 
 #ifndef HAVE_SDL_TTF
 # error "can't use TrueTypeFont without SDL_ttf"
@@ -35,10 +37,59 @@ namespace SDL {
 
 class Surface;
 
+// Notes:
+// - SDL_ttf reads glyphs from the font's file as it needs them, not all
+//   at once, so the file must be there for as long as the font is. A font
+//   made from a path, or from a RWops it's given (moved into it), owns its
+//   file; one made from a const RWops& only borrows it.
+// - to open the same file at several sizes without reading it again for
+//   each, see FontRegistry
 class TrueTypeFont {
 	friend class Surface;
+	friend class GlyphAtlas;
 public:
 	TrueTypeFont(const char *path, int size);
+	TrueTypeFont(RWops &&file, int size);
+	TrueTypeFont(const RWops &file, int size);
+
+	// the point size it was opened at
+	int getSize() const { return size_; }
+	// metrics, in pixels. See SDL_ttf's docs for what they mean.
+	int getHeight() const { return TTF_FontHeight(font_.get()); }
+	int getAscent() const { return TTF_FontAscent(font_.get()); }
+	int getDescent() const { return TTF_FontDescent(font_.get()); }
+	int getLineSkip() const { return TTF_FontLineSkip(font_.get()); }
+	// the size text would be rendered at, with TTF_SizeUTF8(). Either of
+	// w and h may be NULL.
+	bool getTextSize(const char *utf8, int *w, int *h) const
+	{
+		return TTF_SizeUTF8(font_.get(), utf8, w, h) == 0;
+	}
+	// any of them may be NULL
+	bool getGlyphMetrics(Uint16 glyph, int *minX, int *maxX, int *minY,
+		int *maxY, int *advance) const
+	{
+		return TTF_GlyphMetrics(font_.get(), glyph, minX, maxX, minY, maxY,
+			advance) == 0;
+	}
+	bool hasGlyph(Uint16 glyph) const
+	{
+		return TTF_GlyphIsProvided(font_.get(), glyph) != 0;
+	}
+	// what to add to the advance of previous, when glyph follows it. 0 if
+	// kerning's off (or SDL_ttf's older than 2.0.14).
+	int getKerning(Uint16 previous, Uint16 glyph) const;
+
+	// TTF_STYLE_* flags
+	int getStyle() const { return TTF_GetFontStyle(font_.get()); }
+	void setStyle(int style) { TTF_SetFontStyle(font_.get(), style); }
+
+	// Unique to each font opened, so caches can tell them apart (addresses
+	// may be reused once a font's gone). Moves with the font.
+	Uint64 getId() const { return id_; }
+	// expires once the font's gone (and moves with it too), so caches
+	// keyed by getId() can tell when to drop their entry
+	std::weak_ptr<const void> getLifetime() const { return lifetime_; }
 
 	TrueTypeFont(const TrueTypeFont &that) = delete;
 	TrueTypeFont(TrueTypeFont &&that) = default;
@@ -51,21 +102,64 @@ public:
 	friend void swap(TrueTypeFont &first, TrueTypeFont &second) noexcept
 	{
 		using std::swap;
+		swap(first.source_, second.source_);
 		swap(first.font_, second.font_);
+		swap(first.size_, second.size_);
+		swap(first.id_, second.id_);
+		swap(first.lifetime_, second.lifetime_);
 	}
 
 	struct Deleter {
 		void operator()(TTF_Font *font) { TTF_CloseFont(font); }
 	};
 private:
+	static Uint64 makeId()
+	{
+		static std::atomic<Uint64> next{0};
+		return ++next;
+	}
+
+	// declared first, so it's destroyed after font_, which reads from it.
+	// NULL when the file's borrowed (or opened by SDL_ttf itself).
+	std::unique_ptr<RWops> source_;
 	std::unique_ptr<TTF_Font, Deleter> font_;
+	int size_;
+	Uint64 id_;
+	std::shared_ptr<const void> lifetime_;
 };
 
 TrueTypeFont::TrueTypeFont(const char *path, int size)
 	: font_{CStyleAlloc<TrueTypeFont::Deleter>::alloc(TTF_OpenFont,
-		"Making TrueTypeFont failed", path, size)}
+		"Making TrueTypeFont failed", path, size)},
+	size_{size}, id_{makeId()}, lifetime_{std::make_shared<char>()}
 {}
 
+TrueTypeFont::TrueTypeFont(RWops &&file, int size)
+	: source_{new RWops(std::move(file))},
+	font_{FromRWops<TrueTypeFont::Deleter>::stream(*source_, TTF_OpenFontRW,
+		"Making TrueTypeFont failed", size)},
+	size_{size}, id_{makeId()}, lifetime_{std::make_shared<char>()}
+{}
+
+TrueTypeFont::TrueTypeFont(const RWops &file, int size)
+	: font_{FromRWops<TrueTypeFont::Deleter>::stream(file, TTF_OpenFontRW,
+		"Making TrueTypeFont failed", size)},
+	size_{size}, id_{makeId()}, lifetime_{std::make_shared<char>()}
+{}
+
+int TrueTypeFont::getKerning(Uint16 previous, Uint16 glyph) const
+{
+#if SDL_TTF_MAJOR_VERSION > 2 || SDL_TTF_MINOR_VERSION > 0 \
+	|| SDL_TTF_PATCHLEVEL >= 14
+	if(TTF_GetFontKerning(font_.get()) == 0) {
+		return 0;
+	}
+	return TTF_GetFontKerningSizeGlyphs(font_.get(), previous, glyph);
+#else
+	return 0;
+#endif
+}
+
 } // namespace SDL
 
 #endif
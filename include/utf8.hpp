@@ -0,0 +1,121 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_UTF8_HPP
+#define SCC_UTF8_HPP
+
+#include <cstddef>
+
+namespace SDL {
+
+// decoding and encoding UTF-8, one code point at a time
+struct UTF8 {
+	// what malformed sequences decode to
+	static const Uint32 REPLACEMENT = 0xFFFD;
+
+	// Decodes the code point text points to, moving text past it. Returns
+	// 0 at the end (the terminating '\0'), without moving.
+	// Malformed sequences (truncated, overlong, surrogates, past
+	// U+10FFFF) decode to REPLACEMENT, one byte at a time.
+	static Uint32 next(const char *&text);
+
+	// writes codepoint to out (which must have room for 4), returning how
+	// many bytes it took. Doesn't add a '\0'.
+	static size_t encode(Uint32 codepoint, char *out);
+};
+
+Uint32 UTF8::next(const char *&text)
+{
+	const unsigned char *bytes =
+		reinterpret_cast<const unsigned char*>(text);
+	Uint32 first = bytes[0];
+	if(first < 0x80) {
+		if(first != 0) {
+			++text;
+		}
+		return first;
+	}
+	int length;
+	Uint32 codepoint, min;
+	if((first & 0xE0) == 0xC0) {
+		length = 2;
+		codepoint = first & 0x1F;
+		min = 0x80;
+	} else if((first & 0xF0) == 0xE0) {
+		length = 3;
+		codepoint = first & 0x0F;
+		min = 0x800;
+	} else if((first & 0xF8) == 0xF0) {
+		length = 4;
+		codepoint = first & 0x07;
+		min = 0x10000;
+	} else {
+		++text;
+		return REPLACEMENT;
+	}
+	for(int i = 1; i < length; ++i) {
+		// this also stops at the '\0'
+		if((bytes[i] & 0xC0) != 0x80) {
+			++text;
+			return REPLACEMENT;
+		}
+		codepoint = codepoint << 6 | (bytes[i] & 0x3F);
+	}
+	if(codepoint < min || codepoint > 0x10FFFF
+		|| (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+	{
+		++text;
+		return REPLACEMENT;
+	}
+	text += length;
+	return codepoint;
+}
+
+size_t UTF8::encode(Uint32 codepoint, char *out)
+{
+	if(codepoint > 0x10FFFF) {
+		codepoint = REPLACEMENT;
+	}
+	if(codepoint < 0x80) {
+		out[0] = static_cast<char>(codepoint);
+		return 1;
+	}
+	if(codepoint < 0x800) {
+		out[0] = static_cast<char>(0xC0 | codepoint >> 6);
+		out[1] = static_cast<char>(0x80 | (codepoint & 0x3F));
+		return 2;
+	}
+	if(codepoint < 0x10000) {
+		out[0] = static_cast<char>(0xE0 | codepoint >> 12);
+		out[1] = static_cast<char>(0x80 | (codepoint >> 6 & 0x3F));
+		out[2] = static_cast<char>(0x80 | (codepoint & 0x3F));
+		return 3;
+	}
+	out[0] = static_cast<char>(0xF0 | codepoint >> 18);
+	out[1] = static_cast<char>(0x80 | (codepoint >> 12 & 0x3F));
+	out[2] = static_cast<char>(0x80 | (codepoint >> 6 & 0x3F));
+	out[3] = static_cast<char>(0x80 | (codepoint & 0x3F));
+	return 4;
+}
+
+} // namespace SDL
+
+#endif // SCC_UTF8_HPP
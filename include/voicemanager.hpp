@@ -0,0 +1,358 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_VOICEMANAGER_HPP
+#define SCC_VOICEMANAGER_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include "null.hpp"
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use VoiceManager class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// Decides which sounds get a channel when there are more sounds than
+// channels. Each sound is played with a priority; when every channel is
+// busy, the voice with the lowest priority (the oldest, among equals) is
+// stopped to make room, unless it's more important than the new one, in
+// which case the new one isn't played. Each sound may also have a cap on
+// how many voices it plays at once; past it, its own oldest voice is
+// stopped (again, unless it's more important).
+//
+// Notes:
+// - the manager reserves the first channelCount channels (allocating
+//   them, if needed), so that AudioChunk::play(-1, ...) doesn't use them
+// - finding the voice to stop is O(1): voices are kept in lists by
+//   priority, oldest first, with a bitmap of the non-empty ones
+// - it learns of voices that ended by themselves in update(), which should
+//   be called every frame. Until then, their channels are thought busy
+//   (so a voice may be stopped when a channel had actually just freed up).
+// - sounds are told apart by address, so a sound is an AudioChunk object
+//   (eg one from a SoundBank), not a file
+// - everything must be called from the same thread
+class VoiceManager {
+public:
+	static const int NO_CAP = -1;
+
+	// a playing sound. Becomes stale when it ends or is stopped.
+	struct Voice {
+		int channel;
+		Uint32 serial;
+	};
+
+	struct Stats {
+		Uint64 played;
+		Uint64 stolen; // voices stopped to make room for others
+		Uint64 rejected; // sounds not played at all
+		Uint64 capped; // sounds that hit their cap (played or not)
+	};
+
+	// Throws std::runtime_error if the channels can't be allocated.
+	explicit VoiceManager(int channelCount);
+	// unreserves the channels, stopping what's still playing in them
+	~VoiceManager();
+
+	// priority goes from 0 (the least important) to 255. Returns a voice
+	// whose channel is -1 if the sound wasn't played.
+	Voice play(AudioChunk &chunk, Uint8 priority, int loops = 0,
+		int ticks = -1);
+	void stop(Voice voice);
+	bool isPlaying(Voice voice) const;
+
+	// maxVoices may be NO_CAP. Doesn't stop voices already playing.
+	void setCap(const AudioChunk &chunk, int maxVoices);
+
+	// frees the channels of the voices that have ended
+	void update();
+
+	int getChannelCount() const { return static_cast<int>(slots_.size()); }
+	int getActiveCount() const
+	{
+		return getChannelCount() - static_cast<int>(free_.size());
+	}
+	const Stats &getStats() const { return stats_; }
+	void resetStats() { stats_ = Stats(); }
+
+	VoiceManager(const VoiceManager &that) = delete;
+	VoiceManager & operator=(const VoiceManager &that) = delete;
+private:
+	static const int NONE = -1;
+	static const int PRIORITIES = 256;
+	static const int WORD_BITS = 64;
+
+	// a channel, and the voice in it, if any
+	struct Slot {
+		const AudioChunk *chunk;
+		Uint8 priority;
+		bool active;
+		Uint32 serial;
+		// in the list of its priority
+		int prev;
+		int next;
+		// in the list of its sound
+		int soundPrev;
+		int soundNext;
+	};
+
+	struct Sound {
+		int cap;
+		int count;
+		int head; // the oldest
+		int tail;
+	};
+
+	struct List {
+		int head; // the oldest
+		int tail;
+	};
+
+	Sound &soundOf(const AudioChunk *chunk);
+	// the oldest voice of the lowest priority, or NONE
+	int lowest() const;
+	void link(int channel);
+	void unlink(int channel);
+	// unlinks and frees it, halting it if halt
+	void release(int channel, bool halt);
+
+	std::vector<Slot> slots_;
+	std::vector<int> free_;
+	List buckets_[PRIORITIES];
+	Uint64 bitmap_[PRIORITIES / WORD_BITS];
+	std::unordered_map<const AudioChunk*, Sound> sounds_;
+	Stats stats_;
+};
+
+VoiceManager::VoiceManager(int channelCount)
+	: stats_()
+{
+	if(channelCount <= 0) {
+		throw std::runtime_error("VoiceManager: no channels");
+	}
+	if(AudioChannels::allocate(-1) < channelCount
+		&& AudioChannels::allocate(channelCount) < channelCount)
+	{
+		throw std::runtime_error("VoiceManager: allocating channels "
+			"failed");
+	}
+	AudioChannels::reserve(channelCount);
+
+	slots_.resize(channelCount);
+	free_.reserve(channelCount);
+	// backwards, so the lowest channels are used first
+	for(int i = channelCount - 1; i >= 0; --i) {
+		slots_[i] = Slot{NULL, 0, false, 0, NONE, NONE, NONE, NONE};
+		free_.push_back(i);
+	}
+	for(List &bucket : buckets_) {
+		bucket = List{NONE, NONE};
+	}
+	for(Uint64 &word : bitmap_) {
+		word = 0;
+	}
+}
+
+VoiceManager::~VoiceManager()
+{
+	for(int i = 0; i < getChannelCount(); ++i) {
+		if(slots_[i].active) {
+			AudioChannels::halt(i);
+		}
+	}
+	AudioChannels::reserve(0);
+}
+
+VoiceManager::Voice VoiceManager::play(AudioChunk &chunk, Uint8 priority,
+	int loops, int ticks)
+{
+	Sound &sound = soundOf(&chunk);
+	int channel = NONE;
+	if(sound.cap != NO_CAP && sound.count >= sound.cap) {
+		++stats_.capped;
+		// make room among its own voices
+		int oldest = sound.head;
+		if(oldest == NONE || slots_[oldest].priority > priority) {
+			++stats_.rejected;
+			return Voice{NONE, 0};
+		}
+		channel = oldest;
+		release(channel, true);
+		++stats_.stolen;
+	} else if(free_.empty()) {
+		int victim = lowest();
+		if(victim == NONE || slots_[victim].priority > priority) {
+			++stats_.rejected;
+			return Voice{NONE, 0};
+		}
+		channel = victim;
+		// it may have ended since the last update()
+		bool ended = !AudioChannels::isPlaying(channel);
+		release(channel, !ended);
+		if(!ended) {
+			++stats_.stolen;
+		}
+	} else {
+		channel = free_.back();
+	}
+	// release() put it in free_, if it wasn't already there
+	free_.pop_back();
+
+	if(chunk.play(channel, loops, ticks) < 0) {
+		free_.push_back(channel);
+		++stats_.rejected;
+		return Voice{NONE, 0};
+	}
+	Slot &slot = slots_[channel];
+	slot.chunk = &chunk;
+	slot.priority = priority;
+	slot.active = true;
+	++slot.serial;
+	link(channel);
+	++stats_.played;
+	return Voice{channel, slot.serial};
+}
+
+void VoiceManager::stop(Voice voice)
+{
+	if(isPlaying(voice)) {
+		release(voice.channel, true);
+	}
+}
+
+bool VoiceManager::isPlaying(Voice voice) const
+{
+	return voice.channel >= 0 && voice.channel < getChannelCount()
+		&& slots_[voice.channel].active
+		&& slots_[voice.channel].serial == voice.serial
+		&& AudioChannels::isPlaying(voice.channel);
+}
+
+void VoiceManager::setCap(const AudioChunk &chunk, int maxVoices)
+{
+	soundOf(&chunk).cap = maxVoices < 0 ? NO_CAP : maxVoices;
+}
+
+void VoiceManager::update()
+{
+	for(int i = 0; i < getChannelCount(); ++i) {
+		if(slots_[i].active && !AudioChannels::isPlaying(i)) {
+			release(i, false);
+		}
+	}
+}
+
+VoiceManager::Sound &VoiceManager::soundOf(const AudioChunk *chunk)
+{
+	auto found = sounds_.find(chunk);
+	if(found == sounds_.end()) {
+		found = sounds_.insert({chunk, Sound{NO_CAP, 0, NONE, NONE}})
+			.first;
+	}
+	return found->second;
+}
+
+int VoiceManager::lowest() const
+{
+	for(int word = 0; word < PRIORITIES / WORD_BITS; ++word) {
+		if(bitmap_[word] != 0) {
+			// the lowest set bit
+			int bit = 0;
+			Uint64 bits = bitmap_[word];
+			while((bits & 1) == 0) {
+				bits >>= 1;
+				++bit;
+			}
+			return buckets_[word * WORD_BITS + bit].head;
+		}
+	}
+	return NONE;
+}
+
+void VoiceManager::link(int channel)
+{
+	Slot &slot = slots_[channel];
+	List &bucket = buckets_[slot.priority];
+	slot.prev = bucket.tail;
+	slot.next = NONE;
+	if(bucket.tail != NONE) {
+		slots_[bucket.tail].next = channel;
+	} else {
+		bucket.head = channel;
+		bitmap_[slot.priority / WORD_BITS] |=
+			Uint64(1) << (slot.priority % WORD_BITS);
+	}
+	bucket.tail = channel;
+
+	Sound &sound = soundOf(slot.chunk);
+	slot.soundPrev = sound.tail;
+	slot.soundNext = NONE;
+	if(sound.tail != NONE) {
+		slots_[sound.tail].soundNext = channel;
+	} else {
+		sound.head = channel;
+	}
+	sound.tail = channel;
+	++sound.count;
+}
+
+void VoiceManager::unlink(int channel)
+{
+	Slot &slot = slots_[channel];
+	List &bucket = buckets_[slot.priority];
+	(slot.prev != NONE ? slots_[slot.prev].next : bucket.head) = slot.next;
+	(slot.next != NONE ? slots_[slot.next].prev : bucket.tail) = slot.prev;
+	if(bucket.head == NONE) {
+		bitmap_[slot.priority / WORD_BITS] &=
+			~(Uint64(1) << (slot.priority % WORD_BITS));
+	}
+
+	auto found = sounds_.find(slot.chunk);
+	Sound &sound = found->second;
+	(slot.soundPrev != NONE ? slots_[slot.soundPrev].soundNext : sound.head)
+		= slot.soundNext;
+	(slot.soundNext != NONE ? slots_[slot.soundNext].soundPrev : sound.tail)
+		= slot.soundPrev;
+	--sound.count;
+	// so that sounds played once don't pile up
+	if(sound.count == 0 && sound.cap == NO_CAP) {
+		sounds_.erase(found);
+	}
+}
+
+void VoiceManager::release(int channel, bool halt)
+{
+	unlink(channel);
+	slots_[channel].active = false;
+	slots_[channel].chunk = NULL;
+	free_.push_back(channel);
+	if(halt) {
+		AudioChannels::halt(channel);
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_VOICEMANAGER_HPP
@@ -0,0 +1,518 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_VOICEMIXER_HPP
+#define SCC_VOICEMIXER_HPP
+
+#include <vector>
+#include <atomic>
+#include <stdexcept>
+#include <algorithm>
+#include "null.hpp"
+#include "audiochunk.hpp"
+#include "lockfreequeue.hpp"
+
+#ifndef HAVE_SDL_MIXER
+# error "cannot use VoiceMixer class without SDL_mixer"
+#endif
+
+namespace SDL {
+
+// A mixer for many voices at once (hundreds), in place of SDL_mixer's
+// channels, which get expensive past a few dozen. It's installed with
+// Mix_HookMusic(), so it mixes in SDL_mixer's callback, and channels still
+// work alongside it (but music doesn't, while it's installed).
+//
+// Each callback, every voice's audibility is worked out from its gain and
+// distance. The loudest (by priority first) up to maxReal are mixed; the
+// others are virtual: they keep their place in the sound, as if playing,
+// but cost next to nothing, and are mixed again once they're loud enough.
+// Voices going in and out of being mixed are faded over a callback, and so
+// are gain changes, so they don't click (but new ones start at once).
+//
+// Notes:
+// - the voices are mixed in floats, straight from the chunks (which are in
+//   the mixer's format already). The mixer's format must be AUDIO_S16SYS or
+//   AUDIO_F32SYS.
+// - the calls may be made from any thread and never lock: they're queued
+//   (lock-free) for the audio thread. A voice starts on the next callback.
+// - distances attenuate as 1/distance past minDistance (scaled by
+//   rolloff), and voices past maxDistance are always virtual. The units
+//   don't matter, as long as they're all the same.
+// - the chunks must outlive their voices, as with chunk.play()
+// - only one may exist at a time, since there's a single music hook
+class VoiceMixer {
+public:
+	static const int DEFAULT_MAX_VOICES = 1024;
+	static const int DEFAULT_MAX_REAL = 64;
+	static const int BLOCK_FRAMES = 512;
+
+	// a playing sound. Becomes stale when it ends or is stopped.
+	struct Voice {
+		int index;
+		Uint32 serial;
+	};
+
+	struct Stats {
+		int active; // voices playing, real or virtual
+		int real; // of those, how many were mixed
+		Uint64 callbacks;
+		double mixSeconds; // spent mixing, over every callback
+	};
+
+	// maxVoices is how many may play at once; maxReal, how many of those
+	// are mixed. Throws std::runtime_error if audio isn't open, or if its
+	// format isn't supported.
+	explicit VoiceMixer(int maxVoices = DEFAULT_MAX_VOICES,
+		int maxReal = DEFAULT_MAX_REAL);
+	// uninstalls the hook, stopping every voice
+	~VoiceMixer();
+
+	// priority goes from 0 (the least important) to 255. Returns a voice
+	// whose index is -1 if there are too many, or the queue is full.
+	Voice play(AudioChunk &chunk, float gain = 1.0f, Uint8 priority = 0,
+		int loops = 0);
+	// these return false if the queue is full
+	bool stop(Voice voice);
+	bool setGain(Voice voice, float gain);
+	bool setDistance(Voice voice, float distance);
+	// whether it hasn't ended yet (or isn't started yet)
+	bool isPlaying(Voice voice) const;
+
+	void setDistanceModel(float minDistance, float maxDistance,
+		float rolloff = 1.0f);
+	// below this gain, voices are virtual. 0.001 (-60 dB) by default.
+	void setThreshold(float gain) { threshold_.store(gain); }
+	void setMaxReal(int maxReal) { maxReal_.store(maxReal); }
+
+	Stats getStats() const;
+
+	VoiceMixer(const VoiceMixer &that) = delete;
+	VoiceMixer & operator=(const VoiceMixer &that) = delete;
+private:
+	enum Type { PLAY, STOP, GAIN, DISTANCE };
+
+	struct Command {
+		Type type;
+		int index;
+		Uint32 serial;
+		const Mix_Chunk *chunk;
+		float value; // the gain or distance
+		int loops;
+		Uint8 priority;
+	};
+
+	// what every thread may see of a voice
+	struct Slot {
+		std::atomic<Uint32> serial;
+		std::atomic<bool> playing;
+	};
+
+	// the rest of it, audio thread only
+	struct State {
+		const Uint8 *data;
+		Uint32 length; // in frames
+		Uint32 position;
+		int loops;
+		Uint32 serial;
+		float gain;
+		float distance;
+		Uint8 priority;
+		float audibility;
+		// what it was mixed at, at the end of the last call. Negative
+		// before the first, so sounds start at once.
+		float lastGain;
+		bool real, wasReal;
+		bool active;
+	};
+
+	static void hook(void *udata, Uint8 *stream, int len);
+	void mix(Uint8 *stream, int len);
+	void apply(const Command &command);
+	void finish(int index);
+	void sweep();
+	void cull();
+	template <typename Sample>
+	void mixVoice(State &voice, float *out, int frames, float from,
+		float to);
+	// moves a virtual voice along; false when it ends
+	bool skip(State &voice, int frames);
+	bool push(const Command &command) { return commands_.push(command); }
+
+	Uint16 format_;
+	int channels_;
+	int frameSize_;
+	std::vector<Slot> slots_;
+	LockFreeQueue<Command> commands_;
+	LockFreeQueue<int> free_; // slots' indices
+	std::atomic<float> minDistance_, maxDistance_, rolloff_, threshold_;
+	std::atomic<int> maxReal_;
+	std::atomic<int> activeCount_, realCount_;
+	std::atomic<Uint64> callbacks_, mixTicks_;
+	// audio thread only; allocated up front, so mixing doesn't
+	std::vector<State> states_;
+	std::vector<int> active_; // indices of the active voices
+	std::vector<int> audible_;
+	std::vector<float> block_;
+};
+
+VoiceMixer::VoiceMixer(int maxVoices, int maxReal)
+	: slots_(maxVoices), commands_(maxVoices * 4), free_(maxVoices),
+	minDistance_{1.0f}, maxDistance_{1000.0f}, rolloff_{1.0f},
+	threshold_{0.001f}, maxReal_{maxReal}, activeCount_{0},
+	realCount_{0}, callbacks_{0}, mixTicks_{0}, states_(maxVoices),
+	block_()
+{
+	int frequency;
+	if(Mix_QuerySpec(&frequency, &format_, &channels_) == 0) {
+		throw std::runtime_error("Making voice mixer failed: audio "
+			"isn't open");
+	}
+	if(format_ != AUDIO_S16SYS && format_ != AUDIO_F32SYS) {
+		throw std::runtime_error("Making voice mixer failed: the mixer's "
+			"format must be AUDIO_S16SYS or AUDIO_F32SYS");
+	}
+	frameSize_ = SDL_AUDIO_BITSIZE(format_) / 8 * channels_;
+	for(int i = 0; i < maxVoices; ++i) {
+		slots_[i].serial.store(0);
+		slots_[i].playing.store(false);
+		states_[i].active = false;
+		free_.push(i);
+	}
+	active_.reserve(maxVoices);
+	audible_.reserve(maxVoices);
+	block_.resize(BLOCK_FRAMES * channels_);
+	Mix_HookMusic(hook, this);
+}
+
+VoiceMixer::~VoiceMixer()
+{
+	// waits for the callback to be done
+	Mix_HookMusic(NULL, NULL);
+}
+
+VoiceMixer::Voice VoiceMixer::play(AudioChunk &chunk, float gain,
+	Uint8 priority, int loops)
+{
+	Voice voice = { -1, 0 };
+	int index;
+	if(!free_.pop(index)) {
+		return voice;
+	}
+	Slot &slot = slots_[index];
+	Uint32 serial = slot.serial.load() + 1;
+	slot.serial.store(serial);
+	slot.playing.store(true);
+	Command command = { PLAY, index, serial, chunk.chunk_.get(), gain,
+		loops, priority };
+	if(!push(command)) {
+		// never got to the audio thread, so it isn't in active_
+		slot.playing.store(false);
+		free_.push(index);
+		return voice;
+	}
+	voice.index = index;
+	voice.serial = serial;
+	return voice;
+}
+
+bool VoiceMixer::stop(Voice voice)
+{
+	Command command = { STOP, voice.index, voice.serial, NULL, 0, 0, 0 };
+	return voice.index < 0 || push(command);
+}
+
+bool VoiceMixer::setGain(Voice voice, float gain)
+{
+	Command command = { GAIN, voice.index, voice.serial, NULL, gain, 0,
+		0 };
+	return voice.index < 0 || push(command);
+}
+
+bool VoiceMixer::setDistance(Voice voice, float distance)
+{
+	Command command = { DISTANCE, voice.index, voice.serial, NULL,
+		distance, 0, 0 };
+	return voice.index < 0 || push(command);
+}
+
+bool VoiceMixer::isPlaying(Voice voice) const
+{
+	if(voice.index < 0) {
+		return false;
+	}
+	const Slot &slot = slots_[voice.index];
+	return slot.serial.load() == voice.serial && slot.playing.load();
+}
+
+void VoiceMixer::setDistanceModel(float minDistance, float maxDistance,
+	float rolloff)
+{
+	minDistance_.store(minDistance);
+	maxDistance_.store(maxDistance);
+	rolloff_.store(rolloff);
+}
+
+VoiceMixer::Stats VoiceMixer::getStats() const
+{
+	Stats stats;
+	stats.active = activeCount_.load();
+	stats.real = realCount_.load();
+	stats.callbacks = callbacks_.load();
+	stats.mixSeconds = static_cast<double>(mixTicks_.load())
+		/ SDL_GetPerformanceFrequency();
+	return stats;
+}
+
+void VoiceMixer::hook(void *udata, Uint8 *stream, int len)
+{
+	static_cast<VoiceMixer*>(udata)->mix(stream, len);
+}
+
+void VoiceMixer::apply(const Command &command)
+{
+	State &voice = states_[command.index];
+	if(command.type == PLAY) {
+		voice.data = command.chunk->abuf;
+		voice.length = command.chunk->alen / frameSize_;
+		voice.position = 0;
+		voice.loops = command.loops;
+		voice.serial = command.serial;
+		voice.gain = command.value;
+		voice.distance = 0;
+		voice.priority = command.priority;
+		voice.lastGain = -1;
+		voice.real = voice.wasReal = false;
+		voice.active = true;
+		active_.push_back(command.index);
+		if(voice.length == 0) {
+			finish(command.index);
+		}
+		return;
+	}
+	if(!voice.active || voice.serial != command.serial) {
+		// stale
+		return;
+	}
+	switch(command.type) {
+	case STOP: finish(command.index); break;
+	case GAIN: voice.gain = command.value; break;
+	case DISTANCE: voice.distance = command.value; break;
+	default: break;
+	}
+}
+
+void VoiceMixer::finish(int index)
+{
+	states_[index].active = false;
+	slots_[index].playing.store(false);
+	// freed by sweep()
+}
+
+// Takes the voices finished out of active_, and only then frees their
+// slots: freed any sooner, a slot could be played again (and put in active_
+// again) while it's still there, and be mixed and freed twice.
+void VoiceMixer::sweep()
+{
+	size_t kept = 0;
+	for(size_t i = 0; i < active_.size(); ++i) {
+		int index = active_[i];
+		if(states_[index].active) {
+			active_[kept++] = index;
+		} else {
+			// can't fail; there's room for every voice
+			free_.push(index);
+		}
+	}
+	active_.resize(kept);
+}
+
+void VoiceMixer::cull()
+{
+	float minDistance = minDistance_.load();
+	float maxDistance = maxDistance_.load();
+	float rolloff = rolloff_.load();
+	float threshold = threshold_.load();
+	audible_.clear();
+	for(int index : active_) {
+		State &voice = states_[index];
+		voice.wasReal = voice.real;
+		voice.real = false;
+		float attenuation = 1;
+		if(voice.distance > maxDistance) {
+			attenuation = 0;
+		} else if(voice.distance > minDistance) {
+			attenuation = minDistance / (minDistance
+				+ rolloff * (voice.distance - minDistance));
+		}
+		voice.audibility = voice.gain * attenuation;
+		if(voice.audibility >= threshold) {
+			audible_.push_back(index);
+		}
+	}
+	size_t maxReal = std::max(maxReal_.load(), 0);
+	if(audible_.size() > maxReal) {
+		// the most important ones first, then the loudest
+		std::nth_element(audible_.begin(), audible_.begin() + maxReal,
+			audible_.end(), [this](int a, int b) {
+				const State &first = states_[a];
+				const State &second = states_[b];
+				if(first.priority != second.priority) {
+					return first.priority > second.priority;
+				}
+				return first.audibility > second.audibility;
+			});
+		audible_.resize(maxReal);
+	}
+	for(int index : audible_) {
+		states_[index].real = true;
+	}
+}
+
+template <typename Sample>
+void VoiceMixer::mixVoice(State &voice, float *out, int frames, float from,
+	float to)
+{
+	// to floats in -1..1
+	const float scale = sizeof(Sample) == 2 ? 1.0f / 32768.0f : 1.0f;
+	const Sample *data = reinterpret_cast<const Sample*>(voice.data);
+	float step = (to - from) / frames;
+	int done = 0;
+	while(done < frames && voice.active) {
+		int n = std::min<Uint32>(frames - done,
+			voice.length - voice.position);
+		const Sample *in = data + voice.position * channels_;
+		float *dst = out + done * channels_;
+		if(step == 0) {
+			// the common case, a constant gain; GCC vectorizes this at -O3
+			float gain = from * scale;
+			for(int i = 0; i < n * channels_; ++i) {
+				dst[i] += in[i] * gain;
+			}
+		} else {
+			float gain = from;
+			for(int i = 0; i < n * channels_; i += channels_) {
+				gain += step;
+				for(int c = 0; c < channels_; ++c) {
+					dst[i + c] += in[i + c] * gain * scale;
+				}
+			}
+		}
+		from += step * n;
+		done += n;
+		voice.position += n;
+		if(voice.position == voice.length) {
+			voice.position = 0;
+			if(voice.loops == 0) {
+				finish(&voice - states_.data());
+			} else if(voice.loops > 0) {
+				--voice.loops;
+			}
+		}
+	}
+}
+
+bool VoiceMixer::skip(State &voice, int frames)
+{
+	Uint64 position = static_cast<Uint64>(voice.position) + frames;
+	while(position >= voice.length) {
+		if(voice.loops == 0) {
+			return false;
+		}
+		if(voice.loops > 0) {
+			--voice.loops;
+		}
+		position -= voice.length;
+	}
+	voice.position = static_cast<Uint32>(position);
+	return true;
+}
+
+void VoiceMixer::mix(Uint8 *stream, int len)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	Command command;
+	while(commands_.pop(command)) {
+		apply(command);
+	}
+	// drops the voices stopped by commands
+	sweep();
+	cull();
+
+	int frames = len / frameSize_;
+	for(int index : active_) {
+		State &voice = states_[index];
+		if(!voice.real && !voice.wasReal && !skip(voice, frames)) {
+			finish(index);
+		}
+	}
+	for(int done = 0; done < frames; done += BLOCK_FRAMES) {
+		int n = std::min(frames - done, static_cast<int>(BLOCK_FRAMES));
+		std::fill(block_.begin(), block_.end(), 0.0f);
+		for(int index : active_) {
+			State &voice = states_[index];
+			if(!voice.active || (!voice.real && !voice.wasReal)) {
+				continue;
+			}
+			// ramps over the whole callback, to 0 if it's going virtual
+			float target = voice.real ? voice.audibility : 0.0f;
+			float last = voice.lastGain < 0 ? target : voice.lastGain;
+			float from = last + (target - last) * done / frames;
+			float to = last + (target - last) * (done + n) / frames;
+			if(format_ == AUDIO_F32SYS) {
+				mixVoice<float>(voice, block_.data(), n, from, to);
+			} else {
+				mixVoice<Sint16>(voice, block_.data(), n, from, to);
+			}
+		}
+		int count = n * channels_;
+		if(format_ == AUDIO_F32SYS) {
+			float *out = reinterpret_cast<float*>(stream) + done * channels_;
+			std::copy(block_.begin(), block_.begin() + count, out);
+		} else {
+			Sint16 *out = reinterpret_cast<Sint16*>(stream)
+				+ done * channels_;
+			for(int i = 0; i < count; ++i) {
+				float s = block_[i] * 32768.0f;
+				s = std::max(-32768.0f, std::min(s, 32767.0f));
+				out[i] = static_cast<Sint16>(s);
+			}
+		}
+	}
+
+	int real = 0;
+	for(int index : active_) {
+		State &voice = states_[index];
+		voice.lastGain = voice.real ? voice.audibility : 0.0f;
+		if(voice.real) {
+			++real;
+		}
+	}
+	sweep();
+	activeCount_.store(active_.size());
+	realCount_.store(real);
+	++callbacks_;
+	mixTicks_ += SDL_GetPerformanceCounter() - start;
+}
+
+} // namespace SDL
+
+#endif // SCC_VOICEMIXER_HPP
@@ -0,0 +1,358 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SCC_WRITEBEHINDRWOPS_HPP
+#define SCC_WRITEBEHINDRWOPS_HPP
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <SDL.h>
+#include "null.hpp"
+#include "rwops.hpp"
+
+namespace SDL {
+
+// A RWops that writes to another one (typically a file) on a worker thread,
+// so that autosaves, logs and captures don't make the caller wait for the
+// disk. write() only copies into a ring of buffers; whenever one fills up,
+// it's handed to the worker, which writes it to the destination.
+//
+// Notes:
+// - when every buffer is waiting to be written, write() waits for one to
+//   be free. If blocking is false, it instead writes as many whole objects
+//   as fit and returns that count (possibly 0), like a full disk would.
+// - flush() hands the buffer being filled to the worker without waiting
+//   for it to be written; sync() waits until everything written so far has
+//   reached the destination.
+// - if writing to the destination fails, the data is dropped and the next
+//   write(), flush() or sync() fails once, with SDL_GetError() saying why.
+//   SDL's error is per thread, so the worker can't report it itself.
+// - it can't be read from. tell() is just the position written up to;
+//   other seeks, and size(), sync() first and then ask the destination.
+// - destroying it writes everything and waits for it
+class WriteBehindRWops : public RWops {
+public:
+	static const size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+	static const int DEFAULT_BUFFER_COUNT = 4;
+
+	// Throws std::runtime_error if bufferSize or bufferCount is 0 or
+	// bufferCount is 1 (the worker needs one to write while the caller
+	// fills another).
+	explicit WriteBehindRWops(RWops destination,
+		size_t bufferSize = DEFAULT_BUFFER_SIZE,
+		int bufferCount = DEFAULT_BUFFER_COUNT, bool blocking = true);
+
+	// Both return false on failure. Only flush() is meant for the main
+	// loop: it waits (or, if not blocking, fails) only if every buffer
+	// is still waiting to be written.
+	bool flush();
+	bool sync();
+
+	WriteBehindRWops(const WriteBehindRWops &that) = delete;
+	WriteBehindRWops(WriteBehindRWops &&that) = default;
+	~WriteBehindRWops() = default;
+	WriteBehindRWops & operator=(WriteBehindRWops that)
+	{
+		swap(*this, that);
+		return *this;
+	}
+	friend void swap(WriteBehindRWops &first,
+		WriteBehindRWops &second) noexcept
+	{
+		using std::swap;
+		swap(static_cast<RWops&>(first), static_cast<RWops&>(second));
+		swap(first.stream_, second.stream_);
+	}
+
+private:
+	// what's adapted into the RWops
+	class Stream;
+
+	// owned by the RWops
+	Stream *stream_;
+};
+
+class WriteBehindRWops::Stream {
+public:
+	Stream(RWops destination, size_t bufferSize, int bufferCount,
+		bool blocking);
+	~Stream();
+
+	// for RWops::adapt(). There's no read(), so reading fails.
+	Sint64 size();
+	Sint64 seek(Sint64 offset, int whence);
+	size_t write(const void *ptr, size_t size, size_t num);
+
+	bool flush();
+	bool sync();
+
+	Stream(const Stream &that) = delete;
+	Stream & operator=(const Stream &that) = delete;
+private:
+	struct Buffer {
+		std::vector<Uint8> data;
+		size_t fill;
+	};
+
+	// all of these must be called with mutex_ locked
+	bool reportError();
+	// how much can be written without waiting
+	size_t room() const;
+	// Hands current_ to the worker. If every other buffer is queued, it
+	// waits for one to be written, or returns false if wait is false.
+	bool handOver(std::unique_lock<std::mutex> &lock, bool wait);
+
+	void work();
+
+	RWops destination_;
+	std::vector<Buffer> buffers_;
+	bool blocking_;
+	Sint64 position_;
+	// the one being filled. It may be full, if it couldn't be handed
+	// over yet.
+	size_t current_;
+
+	// shared with the worker
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	// buffers_[next_] and the queued_ - 1 after it are waiting to be
+	// written (with the first possibly being written right now)
+	size_t next_;
+	size_t queued_;
+	std::string error_;
+	bool quit_;
+	std::thread worker_;
+};
+
+WriteBehindRWops::WriteBehindRWops(RWops destination, size_t bufferSize,
+	int bufferCount, bool blocking)
+	: RWops(RWops::adapt(std::unique_ptr<Stream>(new Stream(
+		std::move(destination), bufferSize, bufferCount, blocking)))),
+	stream_{target<Stream>()}
+{}
+
+bool WriteBehindRWops::flush()
+{
+	return stream_->flush();
+}
+
+bool WriteBehindRWops::sync()
+{
+	return stream_->sync();
+}
+
+WriteBehindRWops::Stream::Stream(RWops destination, size_t bufferSize,
+	int bufferCount, bool blocking)
+	: destination_(std::move(destination)), blocking_{blocking},
+	position_{0}, current_{0}, next_{0}, queued_{0}, quit_{false}
+{
+	if(bufferSize == 0 || bufferCount < 2) {
+		throw std::runtime_error("WriteBehindRWops: invalid buffer "
+			"size or count");
+	}
+	buffers_.resize(bufferCount);
+	for(Buffer &buffer : buffers_) {
+		buffer.data.resize(bufferSize);
+		buffer.fill = 0;
+	}
+	// not all destinations can tell (pipes, for instance)
+	position_ = std::max<Sint64>(destination_.tell(), 0);
+	// started last, so the ctor can still throw without joining it
+	worker_ = std::thread(&Stream::work, this);
+}
+
+WriteBehindRWops::Stream::~Stream()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if(buffers_[current_].fill > 0) {
+			handOver(lock, true);
+		}
+		// the worker empties the queue before quitting
+		quit_ = true;
+	}
+	cond_.notify_all();
+	worker_.join();
+}
+
+Sint64 WriteBehindRWops::Stream::size()
+{
+	if(!sync()) {
+		return -1;
+	}
+	return destination_.size();
+}
+
+Sint64 WriteBehindRWops::Stream::seek(Sint64 offset, int whence)
+{
+	if(whence == RW_SEEK_CUR && offset == 0) {
+		return position_; // tell() mustn't wait
+	}
+	if(!sync()) {
+		return -1;
+	}
+	// the worker is idle until the next handOver()
+	Sint64 position = destination_.seek(offset, whence);
+	if(position >= 0) {
+		position_ = position;
+	}
+	return position;
+}
+
+size_t WriteBehindRWops::Stream::write(const void *ptr, size_t size,
+	size_t num)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	if(!reportError()) {
+		return 0;
+	}
+	if(size == 0 || num == 0) {
+		return 0;
+	}
+	if(!blocking_) {
+		// whole objects only, so the count returned is honest
+		num = std::min(num, room() / size);
+	}
+	const Uint8 *src = static_cast<const Uint8*>(ptr);
+	size_t left = size * num;
+	while(left > 0) {
+		Buffer &buffer = buffers_[current_];
+		if(buffer.fill == buffer.data.size()) {
+			// when not blocking, room() made sure this won't wait
+			handOver(lock, true);
+			continue;
+		}
+		size_t count = std::min(left, buffer.data.size() - buffer.fill);
+		std::memcpy(&buffer.data[buffer.fill], src, count);
+		buffer.fill += count;
+		src += count;
+		left -= count;
+		if(buffer.fill == buffer.data.size()) {
+			// if the worker is behind, this waits for the next write
+			handOver(lock, false);
+		}
+	}
+	position_ += size * num;
+	return num;
+}
+
+bool WriteBehindRWops::Stream::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	if(!reportError()) {
+		return false;
+	}
+	if(buffers_[current_].fill > 0 && !handOver(lock, blocking_)) {
+		SDL_SetError("WriteBehindRWops: all buffers are full");
+		return false;
+	}
+	return true;
+}
+
+bool WriteBehindRWops::Stream::sync()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	if(buffers_[current_].fill > 0) {
+		handOver(lock, true);
+	}
+	while(queued_ > 0) {
+		cond_.wait(lock);
+	}
+	return reportError();
+}
+
+bool WriteBehindRWops::Stream::reportError()
+{
+	if(error_.empty()) {
+		return true;
+	}
+	SDL_SetError("WriteBehindRWops: %s", error_.c_str());
+	error_.clear();
+	return false;
+}
+
+size_t WriteBehindRWops::Stream::room() const
+{
+	// what's left of current_ plus the buffers neither being filled nor
+	// queued
+	size_t bufferSize = buffers_[current_].data.size();
+	size_t free = buffers_.size() - 1 - queued_;
+	return bufferSize - buffers_[current_].fill + free * bufferSize;
+}
+
+bool WriteBehindRWops::Stream::handOver(std::unique_lock<std::mutex> &lock,
+	bool wait)
+{
+	// the one after current_ must be free to become the new current_
+	while(queued_ + 1 >= buffers_.size()) {
+		if(!wait) {
+			return false;
+		}
+		cond_.wait(lock);
+	}
+	++queued_;
+	current_ = (current_ + 1) % buffers_.size();
+	cond_.notify_all();
+	return true;
+}
+
+void WriteBehindRWops::Stream::work()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	for(;;) {
+		while(queued_ == 0 && !quit_) {
+			cond_.wait(lock);
+		}
+		if(queued_ == 0) {
+			return; // quit_, with nothing left to write
+		}
+		Buffer &buffer = buffers_[next_];
+		lock.unlock();
+		SDL_ClearError(); // this thread's own, so it can't be stale
+		bool ok = destination_.write(buffer.data.data(), 1, buffer.fill)
+			== buffer.fill;
+		std::string error;
+		if(!ok) {
+			// not every RWops sets an error
+			error = *SDL_GetError() ? SDL_GetError() : "writing failed";
+		}
+		lock.lock();
+		if(!ok && error_.empty()) {
+			error_ = error;
+		}
+		buffer.fill = 0;
+		next_ = (next_ + 1) % buffers_.size();
+		--queued_;
+		cond_.notify_all();
+	}
+}
+
+} // namespace SDL
+
+#endif // SCC_WRITEBEHINDRWOPS_HPP
@@ -0,0 +1,123 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <iostream>
+#include <cmath>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "audiodevice.hpp"
+using SDL::AudioChunk;
+using SDL::AudioChannels;
+using SDL::AudioDevice;
+
+// the wav of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+
+const Uint32 TUNE_TIME = 500; // ms, for each chunk size
+
+void print(const AudioDevice::Stats &stats)
+{
+	std::cout << "  " << stats.callbacks << " callbacks of "
+		<< stats.frames << " frames, every " << stats.period * 1000
+		<< " ms (jitter " << stats.jitter * 1000 << " ms, at most "
+		<< stats.maxPeriod * 1000 << " ms)" << std::endl
+		<< "  callbacks took " << stats.callbackTime * 1000
+		<< " ms (at most " << stats.maxCallbackTime * 1000 << " ms), "
+		<< stats.underruns << " underruns, latency "
+		<< stats.latency * 1000 << " ms" << std::endl;
+}
+
+// something for the callback to chew on, standing in for a game's mixing
+void load(Uint8 *, int len)
+{
+	volatile double x = 0;
+	for(int i = 0; i < len * 4; ++i) {
+		x = x + std::sin(i * 0.001);
+	}
+}
+
+void test()
+{
+	AudioDevice device(FREQUENCY, FORMAT, CHANNELS);
+	std::cout << "opened with chunks of " << device.getChunkSize()
+		<< std::endl;
+	SDL_Delay(TUNE_TIME);
+	print(device.getStats());
+
+	int chunkSize = device.autoTune(256, 8192, TUNE_TIME, load);
+	if(chunkSize < 0) {
+		std::cout << "couldn't tune: " << SDL_GetError() << std::endl;
+		return;
+	}
+	std::cout << "tuned to chunks of " << chunkSize << std::endl;
+
+	// tuning reopened audio, so the chunk's loaded after it
+	AudioChunk chunk(keyWav);
+	int channel = chunk.play(-1, 0);
+	if(channel < 0) {
+		std::cout << "couldn't play: " << SDL_GetError() << std::endl;
+		return;
+	}
+	while(AudioChannels::isPlaying(channel)) {
+		SDL_Delay(10);
+	}
+	std::cout << "while playing" << std::endl;
+	print(device.getStats());
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	try {
+		test();
+	} catch(const std::exception &e) {
+		std::cout << e.what() << std::endl;
+	}
+	quit();
+	return 0;
+}
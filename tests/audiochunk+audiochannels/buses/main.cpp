@@ -0,0 +1,163 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <atomic>
+#include <cmath>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "audioeffects.hpp"
+#include "audiobuses.hpp"
+using SDL::AudioChunk;
+using SDL::AudioChannels;
+using SDL::AudioEffects;
+using SDL::AudioBuses;
+
+// the wavs of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+const char *switchWav = "../playWav/switch.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+const int PLAY_TIME = 1000; // ms
+
+// an effect that only keeps the loudest sample it's seen
+struct PeakMeter {
+	explicit PeakMeter(std::atomic<float> &peak) : peak(peak) {}
+
+	void operator()(float *samples, int frames)
+	{
+		float max = peak.load();
+		for(int i = 0; i < frames * CHANNELS; ++i) {
+			max = std::max(max, std::fabs(samples[i]));
+		}
+		peak.store(max);
+	}
+
+	std::atomic<float> &peak;
+};
+
+void test()
+{
+	AudioChunk keys(keyWav);
+	AudioChunk click(switchWav);
+	AudioChannels::allocate(8);
+
+	AudioBuses buses;
+	int sfx = buses.create();
+	int ui = buses.create();
+	// channels 0 to 5 are for effects, 6 and 7 for the UI
+	buses.assign(0, 5, sfx);
+	buses.assign(6, 7, ui);
+
+	// one reverb for every effect channel
+	AudioEffects::Reverb reverb(FREQUENCY, 0.7f, 0.4f, 0.3f, CHANNELS);
+	buses.addEffect(sfx, reverb);
+	std::atomic<float> sfxPeak(0.0f), uiPeak(0.0f), masterPeak(0.0f);
+	buses.addEffect(sfx, PeakMeter(sfxPeak));
+	buses.addEffect(ui, PeakMeter(uiPeak));
+	buses.addEffect(AudioBuses::MASTER, PeakMeter(masterPeak));
+
+	std::cout << "four key sounds on the effects bus, a click on the UI's"
+		<< std::endl;
+	for(int i = 0; i < 4; ++i) {
+		buses.play(keys, i);
+	}
+	buses.play(click, 6);
+	SDL_Delay(PLAY_TIME);
+	std::cout << "  peaks: effects " << sfxPeak.exchange(0.0f) << ", UI "
+		<< uiPeak.exchange(0.0f) << ", master "
+		<< masterPeak.exchange(0.0f) << std::endl;
+
+	std::cout << "the same, with the effects bus at half volume and the "
+		"UI's muted" << std::endl;
+	buses.setGain(sfx, 0.5f);
+	buses.setGain(ui, 0.0f);
+	for(int i = 0; i < 4; ++i) {
+		buses.play(keys, i);
+	}
+	buses.play(click, 6);
+	SDL_Delay(PLAY_TIME);
+	std::cout << "  peaks: effects " << sfxPeak.exchange(0.0f) << ", UI "
+		<< uiPeak.exchange(0.0f) << ", master "
+		<< masterPeak.exchange(0.0f) << std::endl;
+
+	std::cout << "a key sound muted by an effect added after routing it, "
+		"then routed again" << std::endl;
+	buses.setGain(ui, 1.0f);
+	int channel = buses.play(keys, 6);
+	AudioEffects::add(channel, AudioEffects::Gain(0.0f, CHANNELS));
+	SDL_Delay(PLAY_TIME / 2);
+	std::cout << "  UI peak before: " << (uiPeak.exchange(0.0f) > 0.0f
+		? "sound" : "silence") << std::endl;
+	buses.attach(channel);
+	SDL_Delay(PLAY_TIME / 4);
+	uiPeak.store(0.0f);
+	SDL_Delay(PLAY_TIME / 4);
+	std::cout << "  UI peak after: " << (uiPeak.exchange(0.0f) > 0.0f
+		? "sound" : "silence") << std::endl;
+	AudioChannels::halt(channel);
+	SDL_Delay(PLAY_TIME);
+	sfxPeak.store(0.0f);
+	uiPeak.store(0.0f);
+	masterPeak.store(0.0f);
+
+	std::cout << "channel 0 is on bus " << buses.getBus(0)
+		<< ", channel 7 on bus " << buses.getBus(7) << std::endl;
+	AudioChannels::halt(-1);
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
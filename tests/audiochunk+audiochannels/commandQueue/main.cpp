@@ -0,0 +1,138 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "audiocommandqueue.hpp"
+using SDL::AudioChunk;
+using SDL::AudioChannels;
+using SDL::AudioCommandQueue;
+
+// the wavs of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+const char *switchWav = "../playWav/switch.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+const int THREADS = 4;
+const int PLAYS_PER_THREAD = 3;
+const int PLAY_INTERVAL = 100; // ms
+const Uint32 FADE_TIME = 500; // ms
+
+// reads the events until there's none, counting them
+void pollEvents(AudioCommandQueue &queue, int &started, int &failed,
+	int &finished)
+{
+	AudioCommandQueue::Event event;
+	while(queue.poll(event)) {
+		switch(event.type) {
+		case AudioCommandQueue::Event::STARTED: ++started; break;
+		case AudioCommandQueue::Event::FAILED: ++failed; break;
+		case AudioCommandQueue::Event::FINISHED: ++finished; break;
+		}
+	}
+}
+
+void test()
+{
+	AudioChunk keys(keyWav);
+	AudioChunk click(switchWav);
+	AudioChannels::allocate(8);
+	AudioCommandQueue queue;
+
+	std::cout << THREADS << " threads playing sounds, none of them "
+		"locking the audio" << std::endl;
+	std::vector<std::thread> threads;
+	for(int t = 0; t < THREADS; ++t) {
+		threads.emplace_back([&, t]() {
+			for(int i = 0; i < PLAYS_PER_THREAD; ++i) {
+				Uint32 id = t * PLAYS_PER_THREAD + i + 1;
+				queue.play(t % 2 == 0 ? keys : click, -1, 0, -1, id);
+				SDL_Delay(PLAY_INTERVAL);
+			}
+		});
+	}
+	for(std::thread &thread : threads) {
+		thread.join();
+	}
+	int started = 0, failed = 0, finished = 0;
+	pollEvents(queue, started, failed, finished);
+	std::cout << "  started: " << started << ", failed: " << failed
+		<< ", finished so far: " << finished << std::endl;
+
+	std::cout << "fading channel 0 out, without halting it" << std::endl;
+	queue.play(keys, 0, -1);
+	queue.setVolume(0, 0, FADE_TIME);
+	SDL_Delay(FADE_TIME / 2);
+	std::cout << "  volume halfway: " << AudioChannels::getVolume(0)
+		<< std::endl;
+	SDL_Delay(FADE_TIME);
+	std::cout << "  volume after: " << AudioChannels::getVolume(0)
+		<< std::endl;
+
+	queue.halt(-1);
+	queue.setVolume(-1, MIX_MAX_VOLUME, 0);
+	SDL_Delay(PLAY_INTERVAL);
+	pollEvents(queue, started, failed, finished);
+	std::cout << "all halted; started: " << started << ", failed: "
+		<< failed << ", finished: " << finished << ", events dropped: "
+		<< queue.getDroppedEvents() << std::endl;
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
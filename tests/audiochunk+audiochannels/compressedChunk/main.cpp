@@ -0,0 +1,129 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <iostream>
+#include <atomic>
+#include <cmath>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "audioeffects.hpp"
+#include "compressedchunk.hpp"
+using SDL::AudioChunk;
+using SDL::AudioChannels;
+using SDL::AudioEffects;
+using SDL::CompressedChunk;
+
+// the wavs of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+const char *switchWav = "../playWav/switch.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+const int POLL_TIME = 10; // ms
+
+template<typename Chunk>
+void playAll(Chunk &chunk, int loops)
+{
+	int channel = chunk.play(-1, loops);
+	if(channel < 0) {
+		std::cout << "couldn't play: " << SDL_GetError() << std::endl;
+		return;
+	}
+	Uint32 start = SDL_GetTicks();
+	while(AudioChannels::isPlaying(channel)) {
+		SDL_Delay(POLL_TIME);
+	}
+	std::cout << "  played for " << SDL_GetTicks() - start << " ms";
+}
+
+void test(const char *filename)
+{
+	std::cout << filename << std::endl;
+	AudioChunk chunk(filename);
+	CompressedChunk compressed(chunk);
+	std::cout << "  " << compressed.getDecodedLength() << " bytes, "
+		<< compressed.getByteLength() << " compressed ("
+		<< static_cast<float>(compressed.getDecodedLength())
+			/ compressed.getByteLength()
+		<< ":1)" << std::endl;
+
+	// measures the final mix
+	std::atomic<float> peak(0.0f);
+	AudioEffects::addPost([&peak](float *samples, int frames) {
+		float max = peak.load();
+		for(int i = 0; i < frames * CHANNELS; ++i) {
+			max = std::max(max, std::fabs(samples[i]));
+		}
+		peak.store(max);
+	});
+
+	playAll(chunk, 0);
+	std::cout << ", original's peak: " << peak.exchange(0.0f)
+		<< std::endl;
+	playAll(compressed, 0);
+	std::cout << ", compressed's peak: " << peak.exchange(0.0f)
+		<< std::endl;
+	playAll(compressed, 1);
+	std::cout << " looping once, peak: " << peak.exchange(0.0f)
+		<< std::endl;
+
+	// the post-mix effect holds a reference to peak
+	AudioEffects::removeAll(MIX_CHANNEL_POST);
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test(keyWav);
+	test(switchWav);
+	quit();
+	return 0;
+}
@@ -0,0 +1,169 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <atomic>
+#include <functional>
+#include <cmath>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "audioeffects.hpp"
+using SDL::AudioChunk;
+using SDL::AudioChannels;
+using SDL::AudioEffects;
+
+// the wav of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+const int STEPS = 20;
+const int STEP_TIME = 50; // ms
+
+// plays the sound, running f(step, channel) every STEP_TIME ms while it
+// plays
+void playWhile(AudioChunk &chunk, std::function<void(int, int)> f)
+{
+	int channel = chunk.play(-1, 0);
+	if(channel < 0) {
+		std::cout << "couldn't play: " << SDL_GetError() << std::endl;
+		return;
+	}
+	for(int step = 0; step < STEPS && AudioChannels::isPlaying(channel);
+		++step)
+	{
+		f(step, channel);
+		SDL_Delay(STEP_TIME);
+	}
+	AudioChannels::halt(channel);
+}
+
+void test()
+{
+	AudioChunk chunk(keyWav);
+
+	// measures the final mix
+	std::atomic<float> peak(0.0f);
+	AudioEffects::addPost([&peak](float *samples, int frames) {
+		float max = peak.load();
+		for(int i = 0; i < frames * CHANNELS; ++i) {
+			max = std::max(max, std::fabs(samples[i]));
+		}
+		peak.store(max);
+	});
+
+	std::cout << "as is" << std::endl;
+	playWhile(chunk, [](int, int) {});
+	std::cout << "  peak: " << peak.exchange(0.0f) << std::endl;
+
+	std::cout << "at half the gain" << std::endl;
+	playWhile(chunk, [](int step, int channel) {
+		if(step == 0) {
+			AudioEffects::add(channel, AudioEffects::Gain(0.5f, CHANNELS));
+		}
+	});
+	std::cout << "  peak: " << peak.exchange(0.0f) << std::endl;
+
+	std::cout << "sweeping a low-pass filter down" << std::endl;
+	AudioEffects::Biquad filter(FREQUENCY, AudioEffects::Biquad::LOW_PASS,
+		8000.0f);
+	playWhile(chunk, [&](int step, int channel) {
+		if(step == 0) {
+			// a channel's effects go away when it stops playing. The
+			// copy added shares its parameters with filter.
+			AudioEffects::add(channel, filter);
+		}
+		filter.set(AudioEffects::Biquad::LOW_PASS,
+			8000.0f / (step + 1), 0.7071f);
+	});
+	std::cout << "  peak: " << peak.exchange(0.0f) << std::endl;
+
+	std::cout << "panning from left to right, fading out" << std::endl;
+	AudioEffects::Pan pan(-1.0f);
+	AudioEffects::Gain gain(1.0f, CHANNELS);
+	playWhile(chunk, [&](int step, int channel) {
+		if(step == 0) {
+			AudioEffects::add(channel, pan);
+			AudioEffects::add(channel, gain);
+		}
+		pan.setPan(-1.0f + 2.0f * step / STEPS);
+		gain.setGain(1.0f - static_cast<float>(step) / STEPS);
+	});
+	std::cout << "  peak: " << peak.exchange(0.0f) << std::endl;
+
+	std::cout << "compressed, with reverb on the mix" << std::endl;
+	AudioEffects::Compressor compressor(FREQUENCY, -24.0f, 8.0f,
+		CHANNELS);
+	compressor.setMakeup(6.0f);
+	AudioEffects::Reverb reverb(FREQUENCY, 0.8f, 0.3f, 0.3f, CHANNELS);
+	AudioEffects::addPost(reverb);
+	float maxReduction = 0;
+	playWhile(chunk, [&](int step, int channel) {
+		if(step == 0) {
+			AudioEffects::add(channel, compressor);
+		}
+		maxReduction = std::max(maxReduction,
+			compressor.getReduction());
+	});
+	std::cout << "  peak: " << peak.exchange(0.0f)
+		<< ", most gain reduction: " << maxReduction << " dB"
+		<< std::endl;
+
+	// the peak meter holds a reference to a local
+	AudioEffects::removeAll(MIX_CHANNEL_POST);
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
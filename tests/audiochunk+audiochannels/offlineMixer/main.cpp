@@ -0,0 +1,133 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <iostream>
+#include <vector>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "music.hpp"
+#include "offlinemixer.hpp"
+#include "rwops.hpp"
+using SDL::AudioChunk;
+using SDL::AudioChannels;
+using SDL::Music;
+using SDL::OfflineMixer;
+using SDL::RWops;
+
+// the wavs of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+const char *switchWav = "../playWav/switch.wav";
+const char *outputWav = "offline.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+
+const double RENDER_SECONDS = 10.0;
+const int MAX_VOICES = 64;
+
+void print(const char *what, const OfflineMixer::Stats &stats)
+{
+	std::cout << what << ": " << stats.seconds << " s in "
+		<< stats.realSeconds << " s (" << stats.speed
+		<< "x real time), " << stats.throughput
+		<< " voice-seconds per second" << std::endl;
+}
+
+void test()
+{
+	OfflineMixer mixer(FREQUENCY, FORMAT, CHANNELS);
+	// put back as it was, so unset unless it's set outside
+	const char *driver = SDL_getenv("SDL_AUDIODRIVER");
+	std::cout << "SDL_AUDIODRIVER after opening: "
+		<< (driver == NULL ? "unset" : driver) << std::endl;
+	AudioChannels::allocate(MAX_VOICES);
+	AudioChunk chunk(keyWav);
+
+	print("silence", mixer.render(RENDER_SECONDS));
+	for(int voices = 1; voices <= MAX_VOICES; voices *= 4) {
+		AudioChannels::halt(-1);
+		for(int i = 0; i < voices; ++i) {
+			chunk.play(i, -1);
+		}
+		std::cout << voices << " voices, ";
+		print("looping", mixer.render(RENDER_SECONDS));
+	}
+	AudioChannels::halt(-1);
+
+	Music music(switchWav);
+	music.play(-1);
+	chunk.play(0, -1);
+	print("music and a voice", mixer.render(RENDER_SECONDS));
+	Music::halt();
+	AudioChannels::halt(-1);
+
+	// the last render's kept, as a WAV, to listen to
+	mixer.clearSamples();
+	chunk.play(0, 0);
+	mixer.render(1.0);
+	{
+		RWops file(outputWav, "wb");
+		if(!mixer.writeWav(file)) {
+			std::cout << "couldn't write: " << SDL_GetError()
+				<< std::endl;
+			return;
+		}
+	}
+	std::cout << "wrote " << mixer.getSamples().size() << " bytes to "
+		<< outputWav << std::endl;
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	// audio's initialized by OfflineMixer, for the disk driver
+	Uint32 sdlFlags = 0;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	try {
+		test();
+	} catch(const std::exception &e) {
+		std::cout << e.what() << std::endl;
+	}
+	quit();
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audioloader.hpp"
+using SDL::AudioChunk;
+using SDL::AudioLoader;
+
+// the wavs of the playWav test: 8 bit mono at 44.1 kHz, and 16 bit stereo
+// at 48 kHz, so both need converting
+const char *keyWav = "../playWav/keys.wav";
+const char *switchWav = "../playWav/switch.wav";
+// pretend it's a level's sound bank
+const int COPIES = 100;
+
+const int FREQUENCY = 22050;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+double millisecondsSince(Uint64 start)
+{
+	return 1000.0 * (SDL_GetPerformanceCounter() - start)
+		/ SDL_GetPerformanceFrequency();
+}
+
+void testResample()
+{
+	// a ramp stays a ramp
+	const float src[] = {0, 1, 2, 3, 4, 5, 6, 7};
+	float dst[16];
+	AudioLoader::resample(src, 8, dst, 16, 1);
+	std::cout << "8 frames resampled to 16:";
+	for(float sample : dst) {
+		std::cout << " " << sample;
+	}
+	std::cout << std::endl;
+}
+
+void test()
+{
+	testResample();
+
+	std::vector<std::string> paths;
+	for(int i = 0; i < COPIES; ++i) {
+		paths.push_back(keyWav);
+		paths.push_back(switchWav);
+	}
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 sequentialBytes = 0;
+	for(const std::string &path : paths) {
+		AudioChunk chunk(path.c_str());
+		sequentialBytes += chunk.getByteLength();
+	}
+	std::cout << "AudioChunk, one at a time: " << millisecondsSince(start)
+		<< " ms" << std::endl;
+
+	AudioLoader loader;
+	start = SDL_GetPerformanceCounter();
+	std::vector<AudioChunk> chunks = loader.loadAll(paths);
+	std::cout << "AudioLoader::loadAll(): " << millisecondsSince(start)
+		<< " ms" << std::endl;
+
+	// Mix_LoadWAV_RW()'s resampler rounds lengths differently
+	Uint64 parallelBytes = 0;
+	for(const AudioChunk &chunk : chunks) {
+		parallelBytes += chunk.getByteLength();
+	}
+	std::cout << "bytes: " << sequentialBytes << " one at a time, "
+		<< parallelBytes << " in parallel" << std::endl;
+
+	try {
+		loader.loadAll({keyWav, "nonexistent.wav"});
+		std::cout << "error: loading a missing file didn't throw"
+			<< std::endl;
+	} catch(const std::exception &ex) {
+		std::cout << "loading a missing file threw: " << ex.what()
+			<< std::endl;
+	}
+
+	std::cout << "playing the switch" << std::endl;
+	chunks[1].play(-1, 0);
+	while(chunks[1].isPlaying()) {
+		SDL_Delay(10);
+	}
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
@@ -0,0 +1,123 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <stdexcept>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "soundbank.hpp"
+using SDL::AudioChunk;
+using SDL::SoundBank;
+
+// the wavs of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+const char *switchWav = "../playWav/switch.wav";
+const char *missingWav = "nonexistent.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+void printBank(const SoundBank &bank)
+{
+	std::cout << "  " << bank.size() << " sound(s), " << bank.getBytes()
+		<< " bytes" << std::endl;
+}
+
+void test()
+{
+	SoundBank bank;
+
+	// two systems asking for the same sound share it
+	SoundBank::Handle key1 = bank.get(keyWav);
+	SoundBank::Handle key2 = bank.get(keyWav);
+	std::cout << "same chunk for the same name: " << (key1 == key2)
+		<< std::endl;
+	printBank(bank);
+
+	bank.preload({keyWav, switchWav});
+	std::cout << "after preloading:" << std::endl;
+	printBank(bank);
+
+	try {
+		bank.preload({missingWav});
+		std::cout << "error: preloading a missing file didn't throw"
+			<< std::endl;
+	} catch(const std::exception &ex) {
+		std::cout << "preloading a missing file threw: " << ex.what()
+			<< std::endl;
+	}
+
+	// switch.wav is unused, keys.wav isn't
+	bank.setBudget(key1->getByteLength());
+	std::cout << "with a budget of keys.wav's size:" << std::endl;
+	printBank(bank);
+	std::cout << "  has switch.wav: " << bank.contains(switchWav)
+		<< std::endl;
+
+	// playing counts as in use, even without handles
+	key1->play(-1, 0);
+	key1.reset();
+	key2.reset();
+	bank.trim();
+	std::cout << "trimmed while keys.wav plays:" << std::endl;
+	printBank(bank);
+	while(bank.get(keyWav)->isPlaying()) {
+		SDL_Delay(10);
+	}
+	bank.trim();
+	std::cout << "trimmed after it stopped:" << std::endl;
+	printBank(bank);
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
@@ -0,0 +1,157 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "soundtriggers.hpp"
+using SDL::AudioChunk;
+using SDL::AudioChannels;
+using SDL::SoundTriggers;
+
+// the wavs of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+const char *switchWav = "../playWav/switch.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+const int FRAME_TIME = 16; // ms
+const int HITS = 200;
+const int QUIET_HITS = 10;
+const float HIT_GAIN = 0.05f;
+const Uint32 SWITCH_INTERVAL = 500; // ms
+
+void printStats(const SoundTriggers &triggers)
+{
+	const SoundTriggers::Stats &stats = triggers.getStats();
+	std::cout << "  triggered: " << stats.triggered << ", played: "
+		<< stats.played << ", merged: " << stats.merged << ", dropped: "
+		<< stats.dropped << ", channels playing: "
+		<< AudioChannels::isPlaying(-1) << std::endl;
+}
+
+// the first channel playing, -1 if none is
+int playingChannel()
+{
+	for(int i = 0; i < AudioChannels::total(); ++i) {
+		if(AudioChannels::isPlaying(i)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void test()
+{
+	AudioChunk hit(keyWav);
+	AudioChunk click(switchWav);
+	SoundTriggers triggers;
+	triggers.setRateLimit(click, SWITCH_INTERVAL);
+
+	// 200 projectiles hitting on the same frame
+	for(int i = 0; i < HITS; ++i) {
+		triggers.trigger(hit, HIT_GAIN);
+	}
+	triggers.flush();
+	int channel = playingChannel();
+	std::cout << HITS << " hits at gain " << HIT_GAIN << " in a frame:"
+		<< std::endl;
+	printStats(triggers);
+	// sqrt(200 * 0.05^2) = 0.707
+	std::cout << "  their voice's volume: "
+		<< AudioChannels::getVolume(channel) << " of " << MIX_MAX_VOLUME
+		<< std::endl;
+
+	// more on the next frame are within the merge window
+	SDL_Delay(FRAME_TIME);
+	for(int i = 0; i < HITS; ++i) {
+		triggers.trigger(hit, HIT_GAIN);
+	}
+	triggers.flush();
+	std::cout << "as many on the next frame:" << std::endl;
+	printStats(triggers);
+	std::cout << "  their voice's volume: "
+		<< AudioChannels::getVolume(channel) << std::endl;
+
+	// a click every frame, but no more than one per interval
+	triggers.resetStats();
+	for(int frame = 0; frame < 60; ++frame) {
+		triggers.trigger(click);
+		triggers.flush();
+		SDL_Delay(FRAME_TIME);
+	}
+	std::cout << "a rate limited click on every frame for about a second:"
+		<< std::endl;
+	printStats(triggers);
+
+	// a quiet merged voice, then a plain sound on its channel once it's
+	// gone, which must not be played as quietly
+	AudioChannels::halt(-1);
+	for(int i = 0; i < QUIET_HITS; ++i) {
+		triggers.trigger(hit, HIT_GAIN);
+	}
+	triggers.flush();
+	channel = playingChannel();
+	std::cout << QUIET_HITS << " hits, merged into a voice at volume "
+		<< AudioChannels::getVolume(channel) << std::endl;
+	AudioChannels::halt(channel);
+	click.play(channel, 0);
+	std::cout << "a plain click on the same channel after them, at volume "
+		<< AudioChannels::getVolume(channel) << " (should be "
+		<< MIX_MAX_VOLUME << ")" << std::endl;
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
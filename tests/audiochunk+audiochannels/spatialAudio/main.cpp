@@ -0,0 +1,161 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "voicemanager.hpp"
+#include "spatialaudio.hpp"
+using SDL::AudioChunk;
+using SDL::AudioChannels;
+using SDL::VoiceManager;
+using SDL::SpatialAudio;
+
+// the wavs of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+const char *switchWav = "../playWav/switch.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+const int VOICE_CHANNELS = 16;
+const int EMITTERS = 200;
+const int FRAMES = 120;
+const int FRAME_TIME = 16; // ms
+const float PI = 3.14159265f;
+// set on every channel beforehand, to see it put back
+const int CHANNEL_VOLUME = 100;
+
+void test()
+{
+	AudioChunk keys(keyWav);
+	AudioChunk switchSound(switchWav);
+	VoiceManager voices(VOICE_CHANNELS);
+	SpatialAudio spatial(voices);
+	spatial.setDistanceModel(1.0f, 50.0f);
+	AudioChannels::setVolume(-1, CHANNEL_VOLUME);
+
+	// scattered around, from next to the listener to out of earshot
+	std::vector<SpatialAudio::Emitter> emitters;
+	std::vector<SpatialAudio::Vector> positions(EMITTERS);
+	for(int i = 0; i < EMITTERS; ++i) {
+		float distance = 1.0f + 60.0f * i / EMITTERS;
+		float angle = 2 * PI * i / 7;
+		SpatialAudio::Vector position{distance * std::cos(angle), 0.0f,
+			distance * std::sin(angle)};
+		emitters.push_back(spatial.play(keys, position, 1.0f,
+			i % 2 == 0 ? 1 : 0, -1));
+	}
+	// a one-shot that's too far to hear, and one that's close
+	SpatialAudio::Emitter far = spatial.play(switchSound,
+		{100.0f, 0.0f, 0.0f}, 1.0f, 255);
+	SpatialAudio::Emitter near = spatial.play(switchSound,
+		{0.0f, 0.0f, 2.0f}, 1.0f, 255);
+
+	Uint64 updateTicks = 0;
+	for(int frame = 0; frame < FRAMES; ++frame) {
+		// the listener walks along x, and everything turns around it
+		float t = static_cast<float>(frame) / FRAMES;
+		spatial.setListener({t * 30.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f});
+		for(int i = 0; i < EMITTERS; ++i) {
+			float distance = 1.0f + 60.0f * i / EMITTERS;
+			float angle = 2 * PI * (static_cast<float>(i) / 7 + t);
+			positions[i] = SpatialAudio::Vector{
+				distance * std::cos(angle), 0.0f,
+				distance * std::sin(angle)};
+		}
+		spatial.setPositions(emitters.data(), positions.data(),
+			EMITTERS);
+
+		Uint64 start = SDL_GetPerformanceCounter();
+		spatial.update();
+		updateTicks += SDL_GetPerformanceCounter() - start;
+
+		if(frame % 30 == 0) {
+			SpatialAudio::Stats stats = spatial.getStats();
+			std::cout << "frame " << frame << ": " << stats.active
+				<< " emitters, " << stats.real << " real, far one-shot "
+				<< (spatial.isPlaying(far) ? "waiting" : "gone")
+				<< ", near one " << (spatial.isReal(near) ? "playing"
+					: "not playing") << std::endl;
+		}
+		SDL_Delay(FRAME_TIME);
+	}
+	std::cout << "updates took " << 1000.0 * updateTicks
+		/ SDL_GetPerformanceFrequency() / FRAMES << " ms on average"
+		<< std::endl;
+
+	for(SpatialAudio::Emitter emitter : emitters) {
+		spatial.stop(emitter);
+	}
+	spatial.update();
+	int changed = 0;
+	for(int i = 0; i < VOICE_CHANNELS; ++i) {
+		if(!AudioChannels::isPlaying(i)
+			&& AudioChannels::getVolume(i) != CHANNEL_VOLUME)
+		{
+			++changed;
+		}
+	}
+	std::cout << "stopped: " << spatial.getStats().active
+		<< " emitters left, channels playing: "
+		<< AudioChannels::isPlaying(-1) << ", stopped ones with another "
+		"volume: " << changed << std::endl;
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
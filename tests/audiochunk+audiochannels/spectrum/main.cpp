@@ -0,0 +1,133 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "spectrumanalyzer.hpp"
+using SDL::AudioChunk;
+using SDL::AudioChannels;
+using SDL::SpectrumAnalyzer;
+
+// the wav of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+const float TONE = 1000.0f; // Hz
+const float AMPLITUDE = 0.5f;
+const int SNAPSHOTS = 5;
+const int SNAPSHOT_TIME = 100; // ms
+
+void print(const SpectrumAnalyzer &analyzer,
+	const SpectrumAnalyzer::Snapshot &snapshot)
+{
+	int loudest = 0;
+	for(size_t i = 1; i < snapshot.magnitudes.size(); ++i) {
+		if(snapshot.magnitudes[i] > snapshot.magnitudes[loudest]) {
+			loudest = i;
+		}
+	}
+	std::cout << "  #" << snapshot.sequence << ": rms " << snapshot.rms
+		<< ", peak " << snapshot.peak << ", loudest at "
+		<< analyzer.getBinFrequency(loudest) << " Hz ("
+		<< snapshot.magnitudes[loudest] << ")" << std::endl;
+}
+
+void watch(SpectrumAnalyzer &analyzer)
+{
+	for(int i = 0; i < SNAPSHOTS; ++i) {
+		SDL_Delay(SNAPSHOT_TIME);
+		print(analyzer, analyzer.getLatest());
+	}
+}
+
+void test()
+{
+	SpectrumAnalyzer analyzer;
+
+	// a second of a sine, on both sides
+	std::vector<Sint16> tone(FREQUENCY * CHANNELS);
+	const float PI = 3.14159265f;
+	for(int i = 0; i < FREQUENCY; ++i) {
+		Sint16 sample = static_cast<Sint16>(32767 * AMPLITUDE
+			* std::sin(2 * PI * TONE * i / FREQUENCY));
+		tone[i * CHANNELS] = tone[i * CHANNELS + 1] = sample;
+	}
+	AudioChunk toneChunk(reinterpret_cast<Uint8*>(tone.data()),
+		tone.size() * sizeof(Sint16));
+
+	std::cout << "a " << TONE << " Hz sine at " << AMPLITUDE
+		<< " (the FFT's bins are " << analyzer.getBinFrequency(1)
+		<< " Hz apart)" << std::endl;
+	toneChunk.play(0, -1);
+	watch(analyzer);
+	AudioChannels::halt(-1);
+
+	std::cout << keyWav << std::endl;
+	AudioChunk keys(keyWav);
+	keys.play(0, 0);
+	watch(analyzer);
+	AudioChannels::halt(-1);
+
+	std::cout << "dropped " << analyzer.getDroppedSamples()
+		<< " samples" << std::endl;
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "voicemanager.hpp"
+using SDL::AudioChunk;
+using SDL::VoiceManager;
+
+// the wavs of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+const char *switchWav = "../playWav/switch.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+const int VOICES = 4;
+const int FOOTSTEP_CAP = 3;
+const Uint8 FOOTSTEP_PRIORITY = 10;
+const Uint8 ALARM_PRIORITY = 200;
+
+void printStats(const VoiceManager &voices)
+{
+	const VoiceManager::Stats &stats = voices.getStats();
+	std::cout << "  active: " << voices.getActiveCount()
+		<< ", played: " << stats.played << ", stolen: " << stats.stolen
+		<< ", rejected: " << stats.rejected << ", capped: "
+		<< stats.capped << std::endl;
+}
+
+void test()
+{
+	AudioChunk footstep(keyWav);
+	AudioChunk alarm(switchWav);
+	VoiceManager voices(VOICES);
+	voices.setCap(footstep, FOOTSTEP_CAP);
+
+	// a crowd walking: only FOOTSTEP_CAP of them are heard at once
+	for(int i = 0; i < 10; ++i) {
+		voices.play(footstep, FOOTSTEP_PRIORITY);
+	}
+	std::cout << "after 10 footsteps (cap " << FOOTSTEP_CAP << "):"
+		<< std::endl;
+	printStats(voices);
+
+	// the alarms take the last channel, then steal the footsteps'
+	VoiceManager::Voice first = voices.play(alarm, ALARM_PRIORITY);
+	for(int i = 1; i < VOICES; ++i) {
+		voices.play(alarm, ALARM_PRIORITY);
+	}
+	std::cout << "after " << VOICES << " alarms:" << std::endl;
+	printStats(voices);
+
+	// nothing left that a footstep may steal
+	VoiceManager::Voice step = voices.play(footstep, FOOTSTEP_PRIORITY);
+	std::cout << "footstep over alarms: channel " << step.channel
+		<< std::endl;
+	printStats(voices);
+
+	// an alarm over alarms steals the oldest
+	voices.play(alarm, ALARM_PRIORITY);
+	std::cout << "first alarm still playing: " << voices.isPlaying(first)
+		<< std::endl;
+
+	voices.stop(VoiceManager::Voice{0, 0}); // stale: does nothing
+	while(voices.getActiveCount() > 0) {
+		SDL_Delay(10);
+		voices.update();
+	}
+	std::cout << "after they all ended:" << std::endl;
+	printStats(voices);
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
@@ -0,0 +1,159 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <vector>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "audiochunk.hpp"
+#include "audiochannels.hpp"
+#include "voicemixer.hpp"
+using SDL::AudioChunk;
+using SDL::AudioChannels;
+using SDL::VoiceMixer;
+
+// the wav of the playWav test
+const char *keyWav = "../playWav/keys.wav";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+const int VOICE_COUNTS[] = { 64, 256, 1024 };
+const int RUN_TIME = 1000; // ms
+const int MAX_REAL = 64;
+// quiet, but above the threshold up close
+const float GAIN = 0.05f;
+
+// SDL_mixer's channels are timed from the music hook (called first) to the
+// post mix (called last)
+Uint64 callbackStart = 0;
+Uint64 channelTicks = 0;
+Uint64 channelCallbacks = 0;
+
+void startTiming(void *, Uint8 *, int)
+{
+	callbackStart = SDL_GetPerformanceCounter();
+}
+
+void stopTiming(void *, Uint8 *, int)
+{
+	channelTicks += SDL_GetPerformanceCounter() - callbackStart;
+	++channelCallbacks;
+}
+
+// in microseconds
+double perCallback(double seconds, Uint64 callbacks)
+{
+	return callbacks == 0 ? 0.0 : seconds * 1e6 / callbacks;
+}
+
+void benchmarkChannels(AudioChunk &chunk, int voices)
+{
+	AudioChannels::allocate(voices);
+	AudioChannels::setVolume(-1,
+		static_cast<int>(GAIN * MIX_MAX_VOLUME));
+	channelTicks = channelCallbacks = 0;
+	Mix_HookMusic(startTiming, NULL);
+	Mix_SetPostMix(stopTiming, NULL);
+	for(int i = 0; i < voices; ++i) {
+		chunk.play(i, -1);
+	}
+	SDL_Delay(RUN_TIME);
+	AudioChannels::halt(-1);
+	Mix_SetPostMix(NULL, NULL);
+	Mix_HookMusic(NULL, NULL);
+	AudioChannels::setVolume(-1, MIX_MAX_VOLUME);
+	AudioChannels::allocate(0);
+	std::cout << "  Mix_PlayChannel: "
+		<< perCallback(static_cast<double>(channelTicks)
+			/ SDL_GetPerformanceFrequency(), channelCallbacks)
+		<< " us per callback" << std::endl;
+}
+
+void benchmarkMixer(AudioChunk &chunk, int voices, int maxReal,
+	bool spread)
+{
+	VoiceMixer mixer(voices, maxReal);
+	for(int i = 0; i < voices; ++i) {
+		VoiceMixer::Voice voice = mixer.play(chunk, GAIN, 0, -1);
+		if(spread) {
+			// most of them far away
+			mixer.setDistance(voice, static_cast<float>(i));
+		}
+	}
+	SDL_Delay(RUN_TIME);
+	VoiceMixer::Stats stats = mixer.getStats();
+	std::cout << "  VoiceMixer, " << stats.real << " of " << stats.active
+		<< " mixed: " << perCallback(stats.mixSeconds, stats.callbacks)
+		<< " us per callback" << std::endl;
+}
+
+void test()
+{
+	AudioChunk chunk(keyWav);
+	int frequency, channels;
+	Uint16 format;
+	Mix_QuerySpec(&frequency, &format, &channels);
+	std::cout << "a callback is " << 1e6 * CHUNK_SIZE / frequency
+		<< " us long" << std::endl;
+	for(int voices : VOICE_COUNTS) {
+		std::cout << voices << " voices:" << std::endl;
+		benchmarkChannels(chunk, voices);
+		benchmarkMixer(chunk, voices, voices, false);
+		benchmarkMixer(chunk, voices, MAX_REAL, true);
+	}
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	// no need to hear it; this only measures
+	SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
@@ -27,6 +27,8 @@
 //#include <SDL_image.h>
 //#include <SDL_ttf.h>
 //#include <SDL_mixer.h>
+// and this, also setting HAVE_THREADS in the makefile
+//#define HAVE_THREADS
 #include "scc.hpp"
 
 int main(int argc, char **argv)
@@ -47,5 +49,13 @@ int main(int argc, char **argv)
 	std::cout << "HAVE_SDL_MIXER" << std::endl;
 #endif
 
+#ifdef HAVE_THREADS
+	std::cout << "HAVE_THREADS" << std::endl;
+#endif
+
+#ifdef HAVE_IOSTATS
+	std::cout << "HAVE_IOSTATS" << std::endl;
+#endif
+
 	return 0;
 }
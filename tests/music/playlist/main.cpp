@@ -0,0 +1,143 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "playlist.hpp"
+using SDL::Playlist;
+
+// the wavs of the playWav test, and one that isn't there
+const char *keyWav = "../../audiochunk+audiochannels/playWav/keys.wav";
+const char *switchWav = "../../audiochunk+audiochannels/playWav/switch.wav";
+const char *missing = "missing.ogg";
+
+const int FREQUENCY = 44100;
+const Uint16 FORMAT = AUDIO_S16SYS;
+const int CHANNELS = 2; // stereo
+const int CHUNK_SIZE = 2048;
+
+const int POLL_TIME = 20; // ms
+const Uint32 FADE_TIME = 500; // ms
+
+// prints the track whenever it changes, for a while
+void watch(const Playlist &playlist, Uint32 ms)
+{
+	int last = Playlist::NONE - 1;
+	Uint32 start = SDL_GetTicks();
+	while(SDL_GetTicks() - start < ms) {
+		int current = playlist.getCurrent();
+		if(current != last) {
+			std::cout << "  " << SDL_GetTicks() - start << " ms: ";
+			if(current == Playlist::NONE) {
+				std::cout << "nothing" << std::endl;
+			} else {
+				std::cout << playlist.getPath(current) << std::endl;
+			}
+			last = current;
+		}
+		SDL_Delay(POLL_TIME);
+	}
+}
+
+void test()
+{
+	{
+		std::vector<std::string> tracks = { keyWav, missing, switchWav };
+		Playlist playlist(tracks, false);
+		std::cout << "playing through once (the missing one is skipped)"
+			<< std::endl;
+		if(!playlist.play()) {
+			std::cout << "couldn't play: " << SDL_GetError()
+				<< std::endl;
+			return;
+		}
+		watch(playlist, 4000);
+		std::cout << "  last error: " << playlist.getError() << std::endl;
+	}
+
+	// only one playlist at a time
+	std::vector<std::string> tracks = { switchWav, keyWav };
+	{
+		Playlist playlist(tracks);
+		std::cout << "on repeat, skipping after half a second"
+			<< std::endl;
+		playlist.play();
+		watch(playlist, 500);
+		playlist.next();
+		watch(playlist, 1000);
+
+		std::cout << "skipping with a " << FADE_TIME << " ms fade"
+			<< std::endl;
+		playlist.setFade(FADE_TIME);
+		playlist.play();
+		watch(playlist, 500);
+		playlist.next();
+		watch(playlist, 1000);
+		playlist.stop();
+	}
+
+	Playlist playlist(tracks, true, FADE_TIME);
+	std::cout << "crossfading over " << FADE_TIME << " ms, skipping after "
+		"half a second" << std::endl;
+	if(!playlist.play()) {
+		std::cout << "couldn't play: " << SDL_GetError() << std::endl;
+		return;
+	}
+	watch(playlist, 500);
+	playlist.next();
+	watch(playlist, 4000);
+	playlist.stop();
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(Mix_OpenAudio(FREQUENCY, FORMAT, CHANNELS, CHUNK_SIZE) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	Mix_CloseAudio();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_AUDIO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
@@ -0,0 +1,114 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <cstdio>
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "window.hpp"
+#include "renderer.hpp"
+#include "truetypefont.hpp"
+using SDL::Window;
+using SDL::TrueTypeFont;
+
+const int ERR_SDL_INIT = -1;
+
+// change this to match some font in your system
+const char *fontPath = "/usr/share/fonts/truetype/dejavu/DejaVuSerif.ttf";
+const int fontSize = 24;
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(TTF_Init() < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	SDL_Quit();
+	TTF_Quit();
+}
+
+void gameLoop()
+{
+	Window window("test");
+	window.makeRenderer();
+
+	int windowWidth = window.getWidth();
+	int windowHeight = window.getHeight();
+
+	TrueTypeFont font(fontPath, fontSize);
+	const char *pangram = "the quick brown fox jumps over the lazy dog";
+	// with accents, to check it's read as UTF-8
+	const char *accents = "Dépêche-toi, Zoë! Ça fait déjà 5 €";
+	int pangramWidth = window.renderer->measureText(font, pangram);
+	int accentsWidth = window.renderer->measureText(font, accents);
+
+	window.renderer->setDrawColor(255, 255, 255, 255);
+
+	// a HUD counter that changes every frame, which would otherwise mean a
+	// new texture every frame
+	char counter[64];
+	Uint32 frames = 0;
+	Uint32 start = SDL_GetTicks();
+	bool quit = false;
+	while(!quit) {
+		SDL_Event e;
+		while(SDL_PollEvent(&e)) {
+			if(e.type == SDL_QUIT) {
+				quit = true;
+			}
+		}
+		window.renderer->clear();
+
+		window.renderer->drawText(font, pangram,
+			(windowWidth - pangramWidth) / 2, windowHeight / 4,
+			SDL_Color{0, 0, 0, 255});
+		window.renderer->drawText(font, accents,
+			(windowWidth - accentsWidth) / 2, windowHeight / 2,
+			SDL_Color{0, 0, 160, 255});
+		std::snprintf(counter, sizeof(counter), "frame %u, %u ms",
+			static_cast<unsigned>(frames),
+			static_cast<unsigned>(SDL_GetTicks() - start));
+		window.renderer->drawText(font, counter, 10,
+			windowHeight * 3 / 4, SDL_Color{160, 0, 0, 255});
+
+		window.renderer->present();
+		++frames;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_VIDEO | SDL_INIT_TIMER;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	gameLoop();
+	quit();
+	return 0;
+}
@@ -0,0 +1,135 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <memory>
+#include <SDL.h>
+#include "rwops.hpp"
+using SDL::RWops;
+
+const int ERR_SDL_INIT = -1;
+
+const int BUFFER_SIZE = 4;
+const int CHAR_SKIP = 2;
+const Sint64 REPEATER_SIZE = 1000;
+
+// An endless (well, REPEATER_SIZE bytes long) repetition of a pattern.
+// There's no write(), so writing to it fails.
+class Repeater {
+public:
+	Repeater(const std::string &pattern) : pattern_(pattern), pos_(0) {}
+
+	Sint64 size() const { return REPEATER_SIZE; }
+	Sint64 seek(Sint64 offset, int whence)
+	{
+		Sint64 base = whence == RW_SEEK_SET ? 0
+			: whence == RW_SEEK_CUR ? pos_ : REPEATER_SIZE;
+		if(base + offset < 0) {
+			return -1;
+		}
+		pos_ = base + offset;
+		return pos_;
+	}
+	size_t read(void *ptr, size_t size, size_t maxnum)
+	{
+		char *dst = static_cast<char*>(ptr);
+		size_t count = 0;
+		for(; count < maxnum && pos_ + Sint64(size) <= REPEATER_SIZE;
+			++count)
+		{
+			for(size_t i = 0; i < size; ++i) {
+				*dst++ = pattern_[pos_++ % pattern_.size()];
+			}
+		}
+		return count;
+	}
+private:
+	std::string pattern_;
+	Sint64 pos_;
+};
+
+void printRead(RWops &rwops, const char *what)
+{
+	char buffer[BUFFER_SIZE];
+	size_t got = rwops.read(buffer, sizeof(char), BUFFER_SIZE);
+	std::cout << what << ": ";
+	std::cout.write(buffer, got); // buffer isn't null terminated
+	std::cout << std::endl;
+}
+
+// same as the customRWops test, without any of its callbacks
+void testStringstream()
+{
+	RWops custom = RWops::adapt(std::stringstream());
+
+	std::string str = "abcdefghijklmnopqrstuvwxyz";
+	custom.write(str.c_str(), sizeof(char), str.size());
+	std::cout << "size after writing: " << custom.size() << std::endl;
+
+	custom.seek(0, RW_SEEK_SET);
+	printRead(custom, "first characters");
+	custom.seek(CHAR_SKIP, RW_SEEK_CUR);
+	printRead(custom, "characters after skipping");
+	custom.seek(-BUFFER_SIZE, RW_SEEK_END);
+	printRead(custom, "last characters");
+
+	std::stringstream *ss = custom.target<std::stringstream>();
+	std::cout << "target<std::stringstream>() holds: "
+		<< (ss != NULL ? ss->str() : "(null)") << std::endl;
+}
+
+void testMembers()
+{
+	// objects that can't be moved can be passed through a unique_ptr
+	RWops repeater = RWops::adapt(std::unique_ptr<Repeater>(
+		new Repeater("0123456789")));
+	std::cout << "repeater size: " << repeater.size() << std::endl;
+	repeater.seek(-BUFFER_SIZE, RW_SEEK_END);
+	printRead(repeater, "repeater's last characters");
+
+	char c = 'x';
+	if(repeater.write(&c, 1, 1) == 0) {
+		std::cout << "success: writing failed with error: "
+			<< SDL_GetError() << std::endl;
+	}
+	std::cout << "target<std::stringstream>() is "
+		<< (repeater.target<std::stringstream>() == NULL
+			? "NULL (good)" : "not NULL (bad)") << std::endl;
+	std::cout << "target<Repeater>() is "
+		<< (repeater.target<Repeater>() != NULL
+			? "not NULL (good)" : "NULL (bad)") << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_VIDEO;
+	if(SDL_Init(sdlFlags) < 0) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	testStringstream();
+	testMembers();
+	SDL_Quit();
+	return 0;
+}
@@ -0,0 +1,165 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+#include <SDL.h>
+#include "rwops.hpp"
+#include "chunkedrwops.hpp"
+using SDL::RWops;
+using SDL::ChunkedRWops;
+
+const int ERR_SDL_INIT = -1;
+
+// small, so that even this test's data spans many blocks
+const Uint32 BLOCK_SIZE = 1024;
+const int LINE_COUNT = 2000;
+const int RANDOM_READS = 1000;
+const int READ_SIZE = 100;
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	SDL_Quit();
+}
+
+// compressible, but not trivially so
+std::string makeData()
+{
+	std::string data;
+	for(int i = 0; i < LINE_COUNT; ++i) {
+		data += "line " + std::to_string(i)
+			+ ": the quick brown fox jumps over the lazy dog "
+			+ std::to_string(i * i % 997) + '\n';
+	}
+	return data;
+}
+
+bool sequentialRead(RWops &chunked, const std::string &data)
+{
+	std::vector<char> buffer(data.size());
+	chunked.seek(0, RW_SEEK_SET);
+	size_t got = chunked.read(buffer.data(), 1, buffer.size());
+	return got == data.size()
+		&& std::string(buffer.begin(), buffer.end()) == data;
+}
+
+bool randomReads(RWops &chunked, const std::string &data)
+{
+	char buffer[READ_SIZE];
+	for(int i = 0; i < RANDOM_READS; ++i) {
+		Sint64 offset = std::rand() % (data.size() - READ_SIZE);
+		if(chunked.seek(offset, RW_SEEK_SET) != offset) {
+			return false;
+		}
+		if(chunked.read(buffer, READ_SIZE, 1) != 1) {
+			return false;
+		}
+		if(data.compare(offset, READ_SIZE, buffer, READ_SIZE) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// a header claiming 2^32 - 1 blocks, consistent with its size, must be
+// caught before the index is allocated
+void corruptHeader(const std::vector<char> &packedMem, Sint64 packedSize)
+{
+	std::vector<char> corrupt(packedMem.begin(),
+		packedMem.begin() + packedSize);
+	Uint64 size = 0xffffffffull * BLOCK_SIZE;
+	for(int i = 0; i < 4; ++i) {
+		corrupt[12 + i] = static_cast<char>(0xff);
+	}
+	for(int i = 0; i < 8; ++i) {
+		corrupt[16 + i] = static_cast<char>(size >> (8 * i));
+	}
+	try {
+		ChunkedRWops::open(RWops(static_cast<const void*>(corrupt.data()),
+			static_cast<int>(corrupt.size())));
+		std::cout << "error: a corrupt header was opened" << std::endl;
+	} catch(const std::runtime_error &e) {
+		std::cout << "corrupt header: " << e.what() << std::endl;
+	}
+}
+
+void test()
+{
+	std::string data = makeData();
+	RWops src(data.data(), static_cast<int>(data.size()));
+
+	// compressed data is never bigger than this
+	std::vector<char> packedMem(data.size() * 2);
+	RWops packed(packedMem.data(), static_cast<int>(packedMem.size()));
+
+	Sint64 packedSize = ChunkedRWops::pack(src, packed, BLOCK_SIZE);
+	if(packedSize < 0) {
+		std::cout << "error: pack() failed: " << SDL_GetError()
+			<< std::endl;
+		return;
+	}
+	std::cout << "packed " << data.size() << " bytes into " << packedSize
+		<< " bytes" << std::endl;
+
+	RWops chunked = ChunkedRWops::open(RWops(
+		static_cast<const void*>(packedMem.data()),
+		static_cast<int>(packedSize)));
+	std::cout << "size(): " << chunked.size() << std::endl;
+	std::cout << "sequential read: "
+		<< (sequentialRead(chunked, data) ? "success" : "error")
+		<< std::endl;
+	std::cout << "random reads: "
+		<< (randomReads(chunked, data) ? "success" : "error")
+		<< std::endl;
+
+	char c;
+	chunked.seek(0, RW_SEEK_END);
+	std::cout << "reading past the end returns "
+		<< chunked.read(&c, 1, 1) << " (should be 0)" << std::endl;
+	std::cout << "writing returns " << chunked.write(&c, 1, 1)
+		<< " (should be 0): " << SDL_GetError() << std::endl;
+
+	corruptHeader(packedMem, packedSize);
+}
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = 0;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
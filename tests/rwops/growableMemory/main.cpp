@@ -0,0 +1,81 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <vector>
+#include <SDL.h>
+#include "rwops.hpp"
+#include "memoryrwops.hpp"
+using SDL::MemoryRWops;
+
+const int ERR_SDL_INIT = -1;
+
+const Uint32 RECORD_COUNT = 100000;
+const Sint64 GAP = 16;
+// more than RWops(void*, int) could ever handle
+const Sint64 FAR_AWAY = Sint64(3) << 30;
+
+void test()
+{
+	MemoryRWops<> memory;
+
+	// written without knowing how much will be written
+	for(Uint32 i = 0; i < RECORD_COUNT; ++i) {
+		memory.write(&i, sizeof(i), 1);
+	}
+	std::cout << "size after " << RECORD_COUNT << " writes: "
+		<< memory.size() << " (capacity " << memory.capacity() << ")"
+		<< std::endl;
+
+	// writing past the end fills the gap with zeroes
+	Uint32 last = 0xdeadbeef;
+	memory.seek(GAP, RW_SEEK_END);
+	memory.write(&last, sizeof(last), 1);
+
+	Uint32 record;
+	memory.seek(sizeof(record) * 1234, RW_SEEK_SET);
+	memory.read(&record, sizeof(record), 1);
+	std::cout << "record #1234: " << record << std::endl;
+	memory.seek(-Sint64(sizeof(record)) - GAP, RW_SEEK_END);
+	memory.read(&record, sizeof(record), 1);
+	std::cout << "first gap bytes: " << record << " (should be 0)"
+		<< std::endl;
+
+	std::cout << "seeking 3 GiB in returns " << memory.seek(FAR_AWAY,
+		RW_SEEK_SET) << std::endl;
+
+	std::vector<Uint8> contents = memory.release();
+	std::cout << "released " << contents.size() << " bytes; "
+		<< "size afterwards: " << memory.size() << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_VIDEO;
+	if(SDL_Init(sdlFlags) < 0) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	SDL_Quit();
+	return 0;
+}
@@ -0,0 +1,120 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <SDL.h>
+#include "rwops.hpp"
+#include "iostats.hpp"
+#include "instrumentedrwops.hpp"
+using SDL::RWops;
+using SDL::FromRWops;
+using SDL::IOStats;
+using SDL::InstrumentedRWops;
+
+const int ERR_SDL_INIT = -1;
+
+const char *FILE_NAME = "../fromFile/sonnet116.txt";
+const char *TRACE_FILE_NAME = "trace.json";
+const int LOAD_COUNT = 3;
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	SDL_Quit();
+}
+
+struct Text {
+	std::vector<char> chars;
+};
+
+struct TextDeleter {
+	void operator()(Text *text) { delete text; }
+};
+
+// a loader like IMG_Load_RW(), reading a byte at a time
+Text * loadText(SDL_RWops *rwops, int freesrc)
+{
+	Text *text = new Text;
+	char c;
+	while(SDL_RWread(rwops, &c, 1, 1) == 1) {
+		text->chars.push_back(c);
+	}
+	return text;
+}
+
+void test()
+{
+	// not counted: IOStats is disabled by default
+	FromRWops<TextDeleter>::load(RWops(FILE_NAME, "rb"), loadText, "");
+
+	IOStats::setEnabled(true);
+	for(int i = 0; i < LOAD_COUNT; ++i) {
+		FromRWops<TextDeleter>::load(RWops(FILE_NAME, "rb"), loadText,
+			"loading text failed");
+	}
+	RWops unnamed(FILE_NAME, "rb");
+	unnamed.setName("");
+	FromRWops<TextDeleter>::load(unnamed, loadText, "loading text failed");
+
+	{
+		InstrumentedRWops streamed(RWops(FILE_NAME, "rb"), "streamed");
+		char buffer[64];
+		while(streamed.read(buffer, 1, sizeof(buffer)) > 0) {
+			streamed.seek(0, RW_SEEK_CUR);
+		}
+	}
+
+	std::cout << "CSV:" << std::endl;
+	IOStats::writeCsv(std::cout);
+	std::cout << "JSON:" << std::endl;
+	IOStats::writeJson(std::cout);
+
+	std::ofstream trace(TRACE_FILE_NAME);
+	IOStats::writeTrace(trace);
+	std::cout << "trace written to " << TRACE_FILE_NAME
+		<< " (open it in chrome://tracing)" << std::endl;
+
+	IOStats::clear();
+	std::cout << "names counted after clear(): " << IOStats::totals().size()
+		<< std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_VIDEO;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
@@ -0,0 +1,164 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <SDL.h>
+#include "rwops.hpp"
+#include "prefetchrwops.hpp"
+using SDL::RWops;
+using SDL::PrefetchRWops;
+
+const int ERR_SDL_INIT = -1;
+
+// 1 MiB of records, each its own index
+const Uint32 RECORD_COUNT = 256 * 1024;
+const size_t BUFFER_SIZE = 256 * 1024;
+const size_t READ_SIZE = 16 * 1024;
+// like a decoder would: a bit, every so often
+const Uint32 RECORDS_PER_READ = 1024;
+const Uint32 READ_INTERVAL = 5; // ms
+const Uint32 SOURCE_DELAY = 20; // ms, per read
+
+// storage that takes a while to answer, like a disc or a network share
+class SlowSource {
+public:
+	SlowSource() : position_{0}
+	{
+		for(Uint32 i = 0; i < RECORD_COUNT; ++i) {
+			data_.push_back(i);
+		}
+	}
+
+	Sint64 size() { return data_.size() * sizeof(Uint32); }
+	Sint64 seek(Sint64 offset, int whence)
+	{
+		SDL_Delay(SOURCE_DELAY);
+		Sint64 base = whence == RW_SEEK_SET ? 0
+			: whence == RW_SEEK_CUR ? position_ : size();
+		position_ = std::max<Sint64>(0, std::min(base + offset, size()));
+		return position_;
+	}
+	size_t read(void *ptr, size_t size, size_t maxnum)
+	{
+		SDL_Delay(SOURCE_DELAY);
+		size_t count = std::min<Sint64>(size * maxnum, this->size()
+			- position_);
+		const Uint8 *bytes = reinterpret_cast<const Uint8*>(data_.data());
+		std::copy(bytes + position_, bytes + position_ + count,
+			static_cast<Uint8*>(ptr));
+		position_ += count;
+		return count / size;
+	}
+private:
+	std::vector<Uint32> data_;
+	Sint64 position_;
+};
+
+double toMilliseconds(Uint64 ticks)
+{
+	return 1000.0 * ticks / SDL_GetPerformanceFrequency();
+}
+
+// reads the first n records as a decoder would, returning the slowest read
+Uint64 readLikeADecoder(RWops &input, Uint32 n, bool &correct)
+{
+	std::vector<Uint32> records(RECORDS_PER_READ);
+	Uint64 slowest = 0;
+	correct = true;
+	for(Uint32 i = 0; i < n; i += RECORDS_PER_READ) {
+		Uint64 before = SDL_GetPerformanceCounter();
+		size_t count = input.read(records.data(), sizeof(Uint32),
+			RECORDS_PER_READ);
+		slowest = std::max(slowest, SDL_GetPerformanceCounter() - before);
+		for(size_t k = 0; k < count; ++k) {
+			correct = correct && records[k] == i + k;
+		}
+		SDL_Delay(READ_INTERVAL);
+	}
+	return slowest;
+}
+
+void testReading()
+{
+	const Uint32 n = RECORD_COUNT / 4;
+	bool correct;
+	RWops direct = RWops::adapt(SlowSource());
+	Uint64 slowest = readLikeADecoder(direct, n, correct);
+	std::cout << "straight from the source, the slowest read took "
+		<< toMilliseconds(slowest) << " ms" << std::endl;
+
+	PrefetchRWops prefetched(RWops::adapt(SlowSource()), BUFFER_SIZE,
+		READ_SIZE);
+	// gives it a head start, as there'd be between loading and playing
+	SDL_Delay(SOURCE_DELAY * 4);
+	std::cout << "read ahead before the first read: "
+		<< prefetched.getBuffered() << " bytes" << std::endl;
+	slowest = readLikeADecoder(prefetched, n, correct);
+	std::cout << "read ahead, the slowest read took "
+		<< toMilliseconds(slowest) << " ms; the data is "
+		<< (correct ? "correct" : "WRONG") << std::endl;
+}
+
+void testSeeking()
+{
+	PrefetchRWops input(RWops::adapt(SlowSource()), BUFFER_SIZE,
+		READ_SIZE);
+	Uint32 record = 0;
+	SDL_Delay(SOURCE_DELAY * 4);
+	// within what's read ahead
+	input.seek(100 * sizeof(Uint32), RW_SEEK_SET);
+	input.read(&record, sizeof(record), 1);
+	std::cout << "after skipping ahead: " << record << " (should be 100)"
+		<< std::endl;
+	// anywhere else
+	input.seek(-static_cast<Sint64>(sizeof(Uint32)), RW_SEEK_END);
+	input.read(&record, sizeof(record), 1);
+	std::cout << "the last record: " << record << " (should be "
+		<< RECORD_COUNT - 1 << ")" << std::endl;
+	std::cout << "reading past the end gives "
+		<< input.read(&record, sizeof(record), 1) << " records"
+		<< std::endl;
+	input.seek(0, RW_SEEK_SET);
+	input.read(&record, sizeof(record), 1);
+	std::cout << "back at the start: " << record << ", tell: "
+		<< input.tell() << std::endl;
+}
+
+void test()
+{
+	testReading();
+	testSeeking();
+}
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_VIDEO;
+	if(SDL_Init(sdlFlags) < 0) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	SDL_Quit();
+	return 0;
+}
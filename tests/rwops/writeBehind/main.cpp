@@ -0,0 +1,122 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <SDL.h>
+#include "rwops.hpp"
+#include "writebehindrwops.hpp"
+using SDL::RWops;
+using SDL::WriteBehindRWops;
+
+const int ERR_SDL_INIT = -1;
+
+const char *FILE_NAME = "output.bin";
+// 8 MiB in small writes, like a log or a capture would do
+const Uint32 RECORD_COUNT = 2 * 1024 * 1024;
+const size_t BUFFER_SIZE = 64 * 1024;
+const int BUFFER_COUNT = 8;
+
+double toMilliseconds(Uint64 ticks)
+{
+	return 1000.0 * ticks / SDL_GetPerformanceFrequency();
+}
+
+void testWriting()
+{
+	WriteBehindRWops output(RWops(FILE_NAME, "wb"), BUFFER_SIZE,
+		BUFFER_COUNT);
+	Uint64 slowest = 0;
+	Uint64 start = SDL_GetPerformanceCounter();
+	for(Uint32 i = 0; i < RECORD_COUNT; ++i) {
+		Uint64 before = SDL_GetPerformanceCounter();
+		if(output.write(&i, sizeof(i), 1) != 1) {
+			std::cout << "write #" << i << " failed: " << SDL_GetError()
+				<< std::endl;
+			return;
+		}
+		slowest = std::max(slowest, SDL_GetPerformanceCounter() - before);
+		if(i % (RECORD_COUNT / 4) == 0) {
+			output.flush(); // eg once per frame
+		}
+	}
+	Uint64 written = SDL_GetPerformanceCounter();
+	output.sync();
+	Uint64 synced = SDL_GetPerformanceCounter();
+	std::cout << "writing took " << toMilliseconds(written - start)
+		<< " ms (slowest write: " << toMilliseconds(slowest) << " ms); "
+		<< "sync() waited " << toMilliseconds(synced - written) << " ms"
+		<< std::endl;
+	std::cout << "tell: " << output.tell() << ", size: " << output.size()
+		<< " (both should be " << RECORD_COUNT * sizeof(Uint32) << ")"
+		<< std::endl;
+}
+
+void testReadingBack()
+{
+	RWops input(FILE_NAME, "rb");
+	Uint32 record;
+	for(Uint32 i = 0; i < RECORD_COUNT; ++i) {
+		if(input.read(&record, sizeof(record), 1) != 1 || record != i) {
+			std::cout << "record #" << i << " is wrong" << std::endl;
+			return;
+		}
+	}
+	std::cout << "all records read back correctly" << std::endl;
+}
+
+void testErrors()
+{
+	// can't be written to, so the worker fails
+	WriteBehindRWops output(RWops(FILE_NAME, "rb"), BUFFER_SIZE,
+		BUFFER_COUNT, false);
+	Uint32 record = 0;
+	output.write(&record, sizeof(record), 1);
+	std::cout << "sync() after a failed write returns " << output.sync()
+		<< " (" << SDL_GetError() << ")" << std::endl;
+	std::cout << "sync() afterwards returns " << output.sync()
+		<< std::endl;
+	// not blocking, so big writes are cut short instead of waiting
+	std::vector<Uint8> big(BUFFER_SIZE * BUFFER_COUNT * 2);
+	std::cout << "wrote " << output.write(big.data(), 1, big.size())
+		<< " of " << big.size() << " bytes without waiting" << std::endl;
+}
+
+void test()
+{
+	testWriting();
+	testReadingBack();
+	testErrors();
+}
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_VIDEO;
+	if(SDL_Init(sdlFlags) < 0) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	SDL_Quit();
+	return 0;
+}
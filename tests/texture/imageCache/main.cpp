@@ -0,0 +1,125 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include "window.hpp"
+#include "renderer.hpp"
+#include "texture.hpp"
+#include "surface.hpp"
+#include "imagecache.hpp"
+using SDL::Window;
+using SDL::Renderer;
+using SDL::Texture;
+using SDL::Surface;
+using SDL::ImageCache;
+
+const int ERR_SDL_INIT = -1;
+const char *imagePath = "../fromImage/foo.jpg";
+// the cache files go in the test's own directory
+const char *cacheDirectory = ".";
+const int LOAD_COUNT = 3;
+
+bool init(Uint32 sdlInitFlags, Uint32 imgInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(static_cast<Uint32>(IMG_Init(imgInitFlags)) != imgInitFlags) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	SDL_Quit();
+	IMG_Quit();
+}
+
+double millisecondsSince(Uint64 start)
+{
+	return 1000.0 * (SDL_GetPerformanceCounter() - start)
+		/ SDL_GetPerformanceFrequency();
+}
+
+void gameLoop()
+{
+	Window window("test");
+	window.makeRenderer();
+	ImageCache cache(cacheDirectory);
+
+	// the first load may or may not be a miss, depending on whether the
+	// test was run before
+	for(int i = 0; i < LOAD_COUNT; ++i) {
+		Uint64 start = SDL_GetPerformanceCounter();
+		Surface surface = Surface::fromImage(imagePath, cache);
+		SDL_Log("surface %dx%d in %.3f ms (hits: %d, misses: %d)",
+			surface.getWidth(), surface.getHeight(),
+			millisecondsSince(start), int(cache.getHits()),
+			int(cache.getMisses()));
+	}
+
+	Texture imgTexture = window.renderer->makeTexture(imagePath, cache);
+	for(int i = 1; i < LOAD_COUNT; ++i) {
+		Uint64 start = SDL_GetPerformanceCounter();
+		imgTexture = window.renderer->makeTexture(imagePath, cache);
+		SDL_Log("texture in %.3f ms (hits: %d, misses: %d)",
+			millisecondsSince(start), int(cache.getHits()),
+			int(cache.getMisses()));
+	}
+	int windowWidth = window.getWidth();
+	int windowHeight = window.getHeight();
+	int textureWidth = imgTexture.getWidth();
+	int textureHeight = imgTexture.getHeight();
+
+	bool quit = false;
+	while(!quit) {
+		SDL_Event e;
+		while(SDL_PollEvent(&e)) {
+			if(e.type == SDL_QUIT) {
+				quit = true;
+			}
+		}
+		window.renderer->setDrawColor(255, 255, 255, 255);
+		window.renderer->clear();
+
+		window.renderer->render(imgTexture,
+			(windowWidth - textureWidth) / 2,
+			(windowHeight - textureHeight) / 2);
+
+		window.renderer->present();
+	}
+}
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_VIDEO | SDL_INIT_TIMER;
+	Uint32 imgFlags = IMG_INIT_JPG | IMG_INIT_PNG;
+	if(!init(sdlFlags, imgFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	gameLoop();
+	quit();
+	return 0;
+}
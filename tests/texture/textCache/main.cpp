@@ -0,0 +1,143 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <vector>
+#include <memory>
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "window.hpp"
+#include "renderer.hpp"
+#include "texture.hpp"
+#include "truetypefont.hpp"
+#include "textcache.hpp"
+using SDL::Window;
+using SDL::Texture;
+using SDL::TrueTypeFont;
+using SDL::TextCache;
+
+const int ERR_SDL_INIT = -1;
+
+// change this to match some font in your system
+const char *fontPath = "/usr/share/fonts/truetype/dejavu/DejaVuSerif.ttf";
+const int fontSize = 24;
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(TTF_Init() < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	SDL_Quit();
+	TTF_Quit();
+}
+
+void gameLoop()
+{
+	Window window("test");
+	window.makeRenderer();
+
+	int windowWidth = window.getWidth();
+	int windowHeight = window.getHeight();
+
+	TrueTypeFont font(fontPath, fontSize);
+	// room for a few menus' worth of labels
+	TextCache cache(*window.renderer, 4 * 1024 * 1024);
+
+	const int MENU_COUNT = 2;
+	const int LABEL_COUNT = 4;
+	const char *menus[MENU_COUNT][LABEL_COUNT] = {
+		{"New game", "Load game", "Options", "Quit"},
+		{"Video", "Audio", "Controls", "Back"},
+	};
+	const SDL_Color normal{0, 0, 0, 255};
+	const SDL_Color selected{200, 0, 0, 255};
+
+	window.renderer->setDrawColor(255, 255, 255, 255);
+
+	// up and down choose a label, and any other key switches menus. The
+	// labels are made again every frame, as if the menu was rebuilt; only
+	// the first frame of each menu and color should miss.
+	int menu = 0;
+	int choice = 0;
+	std::vector<std::shared_ptr<Texture>> labels;
+	bool quit = false;
+	while(!quit) {
+		SDL_Event e;
+		while(SDL_PollEvent(&e)) {
+			if(e.type == SDL_QUIT) {
+				quit = true;
+			} else if(e.type == SDL_KEYDOWN) {
+				if(e.key.keysym.sym == SDLK_UP) {
+					choice = (choice + LABEL_COUNT - 1) % LABEL_COUNT;
+				} else if(e.key.keysym.sym == SDLK_DOWN) {
+					choice = (choice + 1) % LABEL_COUNT;
+				} else {
+					menu = (menu + 1) % MENU_COUNT;
+					choice = 0;
+				}
+			}
+		}
+
+		labels.clear();
+		for(int i = 0; i < LABEL_COUNT; ++i) {
+			labels.push_back(cache.get(font, menus[menu][i],
+				i == choice ? selected : normal));
+		}
+
+		window.renderer->clear();
+		for(int i = 0; i < LABEL_COUNT; ++i) {
+			Texture &label = *labels[i];
+			window.renderer->render(label,
+				(windowWidth - label.getWidth()) / 2,
+				windowHeight * (i + 1) / (LABEL_COUNT + 1));
+		}
+		window.renderer->present();
+	}
+
+	SDL_Log("%llu hits, %llu misses (%.2f%% hit rate), %llu evictions, "
+		"%u textures in %u bytes",
+		static_cast<unsigned long long>(cache.getHits()),
+		static_cast<unsigned long long>(cache.getMisses()),
+		cache.getHitRate() * 100,
+		static_cast<unsigned long long>(cache.getEvictions()),
+		static_cast<unsigned>(cache.getCount()),
+		static_cast<unsigned>(cache.getBytes()));
+}
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_VIDEO | SDL_INIT_TIMER;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	gameLoop();
+	quit();
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "truetypefont.hpp"
+#include "fontregistry.hpp"
+using SDL::TrueTypeFont;
+using SDL::FontRegistry;
+
+// change this to match some font in your system
+const char *fontPath = "/usr/share/fonts/truetype/dejavu/DejaVuSerif.ttf";
+const char *missingPath = "nonexistent.ttf";
+// the sizes of a UI's fonts
+const int SIZES[] = {10, 12, 14, 16, 20, 24, 32, 48};
+
+double millisecondsSince(Uint64 start)
+{
+	return 1000.0 * (SDL_GetPerformanceCounter() - start)
+		/ SDL_GetPerformanceFrequency();
+}
+
+void printRegistry(const FontRegistry &registry)
+{
+	std::cout << "  " << registry.getFileCount() << " file(s), "
+		<< registry.getBytes() << " bytes, " << registry.getFontCount()
+		<< " font(s) open" << std::endl;
+}
+
+void test()
+{
+	// each one reads the file on its own
+	Uint64 start = SDL_GetPerformanceCounter();
+	{
+		std::vector<TrueTypeFont> fonts;
+		for(int size : SIZES) {
+			fonts.emplace_back(fontPath, size);
+		}
+	}
+	std::cout << "opening every size from the file: "
+		<< millisecondsSince(start) << " ms" << std::endl;
+
+	FontRegistry registry;
+	start = SDL_GetPerformanceCounter();
+	std::vector<FontRegistry::Handle> fonts;
+	for(int size : SIZES) {
+		fonts.push_back(registry.get(fontPath, size));
+	}
+	std::cout << "opening every size from the registry: "
+		<< millisecondsSince(start) << " ms" << std::endl;
+	printRegistry(registry);
+
+	bool sizesMatch = true;
+	for(size_t i = 0; i < fonts.size(); ++i) {
+		sizesMatch = sizesMatch && fonts[i]->getSize() == SIZES[i]
+			&& fonts[i]->getHeight() > 0;
+	}
+	std::cout << "every font has its size: " << sizesMatch << std::endl;
+
+	// two systems asking for the same size share it
+	FontRegistry::Handle again = registry.get(fontPath, SIZES[0]);
+	std::cout << "same font for the same size: " << (again == fonts[0])
+		<< std::endl;
+
+	try {
+		registry.get(missingPath, 12);
+		std::cout << "error: getting a missing file didn't throw"
+			<< std::endl;
+	} catch(const std::exception &ex) {
+		std::cout << "getting a missing file threw: " << ex.what()
+			<< std::endl;
+	}
+
+	// the file's kept while some size of it is open
+	fonts.clear();
+	registry.trim();
+	std::cout << "trimmed while one size is open:" << std::endl;
+	printRegistry(registry);
+	again.reset();
+	registry.trim();
+	std::cout << "trimmed after it was closed:" << std::endl;
+	printRegistry(registry);
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(TTF_Init() < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	TTF_Quit();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_TIMER;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}
@@ -0,0 +1,212 @@
+/*
+  SDL C++ Classes
+  Copyright (C) 2017-2018 Mateus Carmo M. de F. Barbosa
+ 
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+ 
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+ 
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <iostream>
+#include <string>
+#include <random>
+#include <cstdlib>
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "truetypefont.hpp"
+#include "textlayout.hpp"
+using SDL::TrueTypeFont;
+using SDL::TextLayout;
+
+// change this to match some font in your system
+const char *fontPath = "/usr/share/fonts/truetype/dejavu/DejaVuSerif.ttf";
+const int fontSize = 16;
+const int WIDTH = 400;
+
+const char *WORDS[] = {
+	"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog",
+	"Zoë", "déjà", "vu", "AVATAR", "naïve", "café", "x",
+	"incomprehensibilities",
+};
+const int WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+std::mt19937 generator(1234); // the same every time
+
+std::string makeSentence(int words)
+{
+	std::string sentence;
+	for(int i = 0; i < words; ++i) {
+		if(i > 0) {
+			sentence += ' ';
+		}
+		sentence += WORDS[generator() % WORD_COUNT];
+	}
+	return sentence;
+}
+
+// whether layout has the lines it would have if made from scratch
+bool isLaidOut(TextLayout &layout, TrueTypeFont &font)
+{
+	TextLayout fresh(font, layout.getWidth(), layout.getWrap());
+	fresh.setText(layout.getText());
+	if(fresh.getLineCount() != layout.getLineCount()) {
+		return false;
+	}
+	for(size_t i = 0; i < fresh.getLineCount(); ++i) {
+		TextLayout::Line a = fresh.getLine(i);
+		TextLayout::Line b = layout.getLine(i);
+		if(a.begin != b.begin || a.end != b.end || a.width != b.width
+			|| a.y != b.y)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool measuresLikeSDL(TextLayout &layout, TrueTypeFont &font)
+{
+	// TTF_SizeUTF8() adds the last glyph's overhang, so only lines
+	// ending in a glyph without one would match exactly; a few pixels
+	// off is fine
+	for(size_t i = 0; i < layout.getLineCount(); ++i) {
+		TextLayout::Line line = layout.getLine(i);
+		std::string text = layout.getText().substr(line.begin,
+			line.end - line.begin);
+		int width;
+		if(!font.getTextSize(text.c_str(), &width, NULL)) {
+			return false;
+		}
+		if(std::abs(width - line.width) > 4) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void testEdits(TrueTypeFont &font, TextLayout::Wrap wrap)
+{
+	TextLayout layout(font, WIDTH, wrap);
+	layout.setText(makeSentence(300) + "\n\n" + makeSentence(50));
+	std::cout << "  " << layout.getLineCount() << " lines, "
+		<< layout.getHeight() << " pixels high" << std::endl;
+
+	layout.resetStats();
+	bool same = true;
+	for(int i = 0; i < 200; ++i) {
+		size_t offset = generator() % (layout.getText().size() + 1);
+		// at a word's end, so offsets stay between code points
+		offset = layout.getText().find(' ', offset);
+		if(offset == std::string::npos) {
+			offset = layout.getText().size();
+		}
+		switch(generator() % 4) {
+		case 0:
+			layout.insert(offset, (" " + makeSentence(1)).c_str());
+			break;
+		case 1:
+			layout.insert(offset, (" " + makeSentence(5)).c_str());
+			break;
+		case 2:
+			layout.insert(offset, "\n");
+			break;
+		default: {
+			// a word and the space before it
+			size_t before = layout.getText().rfind(' ', offset - 1);
+			if(offset > 0 && before != std::string::npos) {
+				layout.erase(before, offset - before);
+			}
+		}
+		}
+		same = same && isLaidOut(layout, font);
+	}
+	std::cout << "  after 200 edits, " << layout.getLineCount()
+		<< " lines; " << layout.getLinesLaidOut()
+		<< " laid out again" << std::endl;
+	std::cout << "  same as laying out from scratch: " << same << std::endl;
+}
+
+void test()
+{
+	TrueTypeFont font(fontPath, fontSize);
+
+	std::cout << "greedy:" << std::endl;
+	testEdits(font, TextLayout::GREEDY);
+	std::cout << "optimal:" << std::endl;
+	testEdits(font, TextLayout::OPTIMAL);
+
+	// a chat log: only the new message is laid out
+	TextLayout chat(font, WIDTH);
+	for(int i = 0; i < 1000; ++i) {
+		chat.append(("\n" + makeSentence(20)).c_str());
+	}
+	chat.resetStats();
+	chat.append(("\n" + makeSentence(20)).c_str());
+	std::cout << "appending to a chat log of " << chat.getLineCount()
+		<< " lines laid out " << chat.getLinesLaidOut() << std::endl;
+
+	// a word typed in the middle of a long paragraph
+	TextLayout field(font, WIDTH);
+	field.setText(makeSentence(1000));
+	size_t middle = field.getText().find(' ', field.getText().size() / 2);
+	field.resetStats();
+	field.insert(middle, " inserted");
+	std::cout << "typing in a paragraph of " << field.getLineCount()
+		<< " lines laid out " << field.getLinesLaidOut() << std::endl;
+	std::cout << "  words measured: " << field.getWordMisses()
+		<< ", cached: " << field.getWordHits() << std::endl;
+	std::cout << "  same as laying out from scratch: "
+		<< isLaidOut(field, font) << std::endl;
+	std::cout << "  measured like TTF_SizeUTF8: "
+		<< measuresLikeSDL(field, font) << std::endl;
+
+	// alignment doesn't lay out again
+	field.setAlign(TextLayout::RIGHT);
+	TextLayout::Line line = field.getLine(0);
+	std::cout << "right aligned, the first line ends at "
+		<< line.x + line.width << " of " << WIDTH << std::endl;
+}
+
+bool init(Uint32 sdlInitFlags)
+{
+	if(SDL_Init(sdlInitFlags) < 0) {
+		return false;
+	}
+	if(TTF_Init() < 0) {
+		return false;
+	}
+	return true;
+}
+
+void quit()
+{
+	TTF_Quit();
+	SDL_Quit();
+}
+
+const int ERR_SDL_INIT = -1;
+
+int main(int argc, char **argv)
+{
+	Uint32 sdlFlags = SDL_INIT_TIMER;
+	if(!init(sdlFlags)) {
+		SDL_LogCritical(SDL_LOG_CATEGORY_ERROR,
+			"couldn't initialize SDL\n");
+		return ERR_SDL_INIT;
+	}
+	test();
+	quit();
+	return 0;
+}